@@ -0,0 +1,569 @@
+
+/* scaling benchmark of the cut: domain01 style tet boxes of several
+ * sizes cut by analytic surfaces, phase times written as csv */
+
+/* Copyright 2007 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space
+ * Administration. No copyright is claimed in the United States under
+ * Title 17, U.S. Code.  All Other Rights Reserved.
+ *
+ * The knife platform is licensed under the Apache License, Version
+ * 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "knife_definitions.h"
+#include "primal.h"
+#include "surface.h"
+#include "domain.h"
+#include "triangle.h"
+#include "profile.h"
+
+#define BENCH_MAX_LIST (32)
+
+/* resolution of the generated surfaces, the grid is what scales */
+#define BENCH_SPHERE_NLAT  (24)
+#define BENCH_SPHERE_NLON  (48)
+#define BENCH_WING_NCHORD  (32)
+#define BENCH_WING_NSPAN   (24)
+#define BENCH_WING_THICKNESS (0.04)
+
+#define BENCH_PI (3.14159265358979323846)
+
+static int bench_list( char *string, int *list, int max_list )
+{
+  char *cursor, *end;
+  int n;
+
+  n = 0;
+  cursor = string;
+  while ( n < max_list )
+    {
+      list[n] = (int)strtol( cursor, &end, 10 );
+      if ( end == cursor || list[n] < 1 ) return EMPTY;
+      n++;
+      if ( '\0' == *end ) return n;
+      if ( ',' != *end ) return EMPTY;
+      cursor = end+1;
+    }
+  return EMPTY;
+}
+
+/* face ids and adjacency of a surface primal filled by the generator */
+static KNIFE_STATUS bench_surface_adj( Primal primal )
+{
+  int face;
+
+  for ( face = 0 ; face < primal_nface(primal) ; face++ )
+    primal->f2n[3+4*face] = 1;
+  if ( NULL == adj_add_elements( primal->face_adj, primal_nface(primal),
+				 3, 4, primal->f2n ) ) return KNIFE_MEMORY;
+
+  return KNIFE_SUCCESS;
+}
+
+static void bench_tri( Primal primal, int face, int n0, int n1, int n2 )
+{
+  /* same winding as tri/cylinder-ascii.tri */
+  primal->f2n[0+4*face] = n0;
+  primal->f2n[1+4*face] = n2;
+  primal->f2n[2+4*face] = n1;
+}
+
+/* unit sphere, latitude and longitude lines with a node at each pole */
+static Primal bench_sphere( void )
+{
+  Primal primal;
+  int nlat, nlon;
+  int lat, lon, node, face;
+  double theta, phi;
+  int north, south;
+
+  nlat = BENCH_SPHERE_NLAT;
+  nlon = BENCH_SPHERE_NLON;
+  primal = primal_create( 2 + (nlat-1)*nlon, 2*(nlat-1)*nlon, 0 );
+  if ( NULL == primal ) return NULL;
+
+#define bench_sphere_node(lat,lon) (2+((lon)%nlon)+((lat)-1)*nlon)
+  north = 0;
+  south = 1;
+  primal->xyz[0+3*north] = 0.0;
+  primal->xyz[1+3*north] = 0.0;
+  primal->xyz[2+3*north] = 1.0;
+  primal->xyz[0+3*south] = 0.0;
+  primal->xyz[1+3*south] = 0.0;
+  primal->xyz[2+3*south] = -1.0;
+  for ( lat = 1 ; lat < nlat ; lat++ )
+    for ( lon = 0 ; lon < nlon ; lon++ )
+      {
+	theta = BENCH_PI*(double)lat/(double)nlat;
+	phi = 2.0*BENCH_PI*(double)lon/(double)nlon;
+	node = bench_sphere_node(lat,lon);
+	primal->xyz[0+3*node] = sin(theta)*cos(phi);
+	primal->xyz[1+3*node] = sin(theta)*sin(phi);
+	primal->xyz[2+3*node] = cos(theta);
+      }
+
+  face = 0;
+  for ( lon = 0 ; lon < nlon ; lon++ )
+    {
+      bench_tri( primal, face++, north,
+		 bench_sphere_node(1,lon), bench_sphere_node(1,lon+1) );
+      bench_tri( primal, face++, south,
+		 bench_sphere_node(nlat-1,lon+1),
+		 bench_sphere_node(nlat-1,lon) );
+    }
+  for ( lat = 1 ; lat < nlat-1 ; lat++ )
+    for ( lon = 0 ; lon < nlon ; lon++ )
+      {
+	bench_tri( primal, face++, bench_sphere_node(lat,lon),
+		   bench_sphere_node(lat+1,lon),
+		   bench_sphere_node(lat+1,lon+1) );
+	bench_tri( primal, face++, bench_sphere_node(lat,lon),
+		   bench_sphere_node(lat+1,lon+1),
+		   bench_sphere_node(lat,lon+1) );
+      }
+#undef bench_sphere_node
+
+  if ( KNIFE_SUCCESS != bench_surface_adj( primal ) )
+    {
+      primal_free( primal );
+      return NULL;
+    }
+
+  return primal;
+}
+
+/* half thickness of a symmetric four digit naca section, closed
+ * trailing edge */
+static double bench_naca( double x, double thickness )
+{
+  return 5.0*thickness*( 0.2969*sqrt(x) - 0.1260*x - 0.3516*x*x
+			 + 0.2843*x*x*x - 0.1036*x*x*x*x );
+}
+
+/* unit chord rectangular wing of span 2 along y, capped at the tips
+ * by a fan around the mid chord */
+static Primal bench_wing( void )
+{
+  Primal primal;
+  int nchord, nspan, nring;
+  int span, chord, ring, node, face;
+  double x, z, y;
+
+  nchord = BENCH_WING_NCHORD;
+  nspan = BENCH_WING_NSPAN;
+  nring = 2*nchord;
+  primal = primal_create( 2 + (nspan+1)*nring, 2*nspan*nring + 2*nring, 0 );
+  if ( NULL == primal ) return NULL;
+
+#define bench_wing_node(span,ring) (2+((ring)%nring)+(span)*nring)
+  for ( span = 0 ; span <= nspan ; span++ )
+    {
+      y = -1.0 + 2.0*(double)span/(double)nspan;
+      /* around the section from the trailing edge under the lower
+       * surface to the leading edge and back over the upper */
+      for ( ring = 0 ; ring < nring ; ring++ )
+	{
+	  chord = ( ring <= nchord ? nchord-ring : ring-nchord );
+	  x = 0.5*(1.0-cos(BENCH_PI*(double)chord/(double)nchord));
+	  z = bench_naca( x, BENCH_WING_THICKNESS );
+	  if ( ring < nchord ) z = -z;
+	  node = bench_wing_node(span,ring);
+	  primal->xyz[0+3*node] = x - 0.5;
+	  primal->xyz[1+3*node] = y;
+	  primal->xyz[2+3*node] = z;
+	}
+    }
+  for ( span = 0 ; span < 2 ; span++ )
+    {
+      primal->xyz[0+3*span] = 0.0;
+      primal->xyz[1+3*span] = ( 0 == span ? -1.0 : 1.0 );
+      primal->xyz[2+3*span] = 0.0;
+    }
+
+  face = 0;
+  for ( span = 0 ; span < nspan ; span++ )
+    for ( ring = 0 ; ring < nring ; ring++ )
+      {
+	bench_tri( primal, face++, bench_wing_node(span,ring),
+		   bench_wing_node(span,ring+1),
+		   bench_wing_node(span+1,ring+1) );
+	bench_tri( primal, face++, bench_wing_node(span,ring),
+		   bench_wing_node(span+1,ring+1),
+		   bench_wing_node(span+1,ring) );
+      }
+  for ( ring = 0 ; ring < nring ; ring++ )
+    {
+      bench_tri( primal, face++, 0,
+		 bench_wing_node(0,ring+1), bench_wing_node(0,ring) );
+      bench_tri( primal, face++, 1,
+		 bench_wing_node(nspan,ring), bench_wing_node(nspan,ring+1) );
+    }
+#undef bench_wing_node
+
+  if ( KNIFE_SUCCESS != bench_surface_adj( primal ) )
+    {
+      primal_free( primal );
+      return NULL;
+    }
+
+  return primal;
+}
+
+/* the tets and boundary faces of util/domain01.f90, l by m by n nodes
+ * between lo and hi */
+static Primal bench_box( int l, int m, int n, double *lo, double *hi )
+{
+  Primal primal;
+  int i, j, k, node, cell, face;
+  int n1, n2, n3, n4, n5, n6, n7, n8;
+
+  primal = primal_create( l*m*n,
+			  4*(l-1)*(m-1)+4*(m-1)*(n-1)+4*(n-1)*(l-1),
+			  6*(l-1)*(m-1)*(n-1) );
+  if ( NULL == primal ) return NULL;
+
+  for ( k = 0 ; k < n ; k++ )
+    for ( j = 0 ; j < m ; j++ )
+      for ( i = 0 ; i < l ; i++ )
+	{
+	  node = i + j*l + k*l*m;
+	  primal->xyz[0+3*node] = lo[0] + (hi[0]-lo[0])*(double)i/(double)(l-1);
+	  primal->xyz[1+3*node] = lo[1] + (hi[1]-lo[1])*(double)j/(double)(m-1);
+	  primal->xyz[2+3*node] = lo[2] + (hi[2]-lo[2])*(double)k/(double)(n-1);
+	}
+
+#define bench_box_hex( i, j, k )			\
+  n1 = ((i)+0) + ((j)+0)*l + ((k)+0)*l*m;		\
+  n2 = ((i)+0) + ((j)+1)*l + ((k)+0)*l*m;		\
+  n3 = ((i)+0) + ((j)+0)*l + ((k)+1)*l*m;		\
+  n4 = ((i)+0) + ((j)+1)*l + ((k)+1)*l*m;		\
+  n5 = ((i)+1) + ((j)+0)*l + ((k)+0)*l*m;		\
+  n6 = ((i)+1) + ((j)+1)*l + ((k)+0)*l*m;		\
+  n7 = ((i)+1) + ((j)+0)*l + ((k)+1)*l*m;		\
+  n8 = ((i)+1) + ((j)+1)*l + ((k)+1)*l*m;
+#define bench_box_cell( a, b, c, d )		\
+  primal->c2n[0+4*cell] = (a);			\
+  primal->c2n[1+4*cell] = (b);			\
+  primal->c2n[2+4*cell] = (c);			\
+  primal->c2n[3+4*cell] = (d);			\
+  cell++;
+#define bench_box_face( a, b, c, id )		\
+  primal->f2n[0+4*face] = (a);			\
+  primal->f2n[1+4*face] = (b);			\
+  primal->f2n[2+4*face] = (c);			\
+  primal->f2n[3+4*face] = (id);			\
+  face++;
+
+  cell = 0;
+  for ( i = 0 ; i < l-1 ; i++ )
+    for ( j = 0 ; j < m-1 ; j++ )
+      for ( k = 0 ; k < n-1 ; k++ )
+	{
+	  bench_box_hex( i, j, k );
+	  bench_box_cell( n2, n4, n3, n7 );
+	  bench_box_cell( n1, n2, n3, n7 );
+	  bench_box_cell( n1, n5, n2, n7 );
+	  bench_box_cell( n2, n5, n6, n7 );
+	  bench_box_cell( n2, n8, n4, n7 );
+	  bench_box_cell( n2, n6, n8, n7 );
+	}
+
+  face = 0;
+  for ( j = 0 ; j < m-1 ; j++ )
+    for ( k = 0 ; k < n-1 ; k++ )
+      {
+	bench_box_hex( 0, j, k );
+	bench_box_face( n2, n4, n3, 1 );
+	bench_box_face( n1, n2, n3, 1 );
+	bench_box_hex( l-2, j, k );
+	bench_box_face( n6, n7, n8, 2 );
+	bench_box_face( n5, n7, n6, 2 );
+      }
+  for ( i = 0 ; i < l-1 ; i++ )
+    for ( k = 0 ; k < n-1 ; k++ )
+      {
+	bench_box_hex( i, 0, k );
+	bench_box_face( n1, n7, n5, 3 );
+	bench_box_face( n1, n3, n7, 3 );
+	bench_box_hex( i, m-2, k );
+	bench_box_face( n2, n6, n8, 4 );
+	bench_box_face( n2, n8, n4, 4 );
+      }
+  for ( i = 0 ; i < l-1 ; i++ )
+    for ( j = 0 ; j < m-1 ; j++ )
+      {
+	bench_box_hex( i, j, 0 );
+	bench_box_face( n1, n5, n2, 5 );
+	bench_box_face( n2, n5, n6, 5 );
+	bench_box_hex( i, j, n-2 );
+	bench_box_face( n3, n4, n7, 6 );
+	bench_box_face( n4, n8, n7, 6 );
+      }
+#undef bench_box_hex
+#undef bench_box_cell
+#undef bench_box_face
+
+  if ( NULL == adj_add_elements( primal->cell_adj, primal_ncell(primal),
+				 4, 4, primal->c2n ) ||
+       NULL == adj_add_elements( primal->face_adj, primal_nface(primal),
+				 3, 4, primal->f2n ) )
+    {
+      primal_free( primal );
+      return NULL;
+    }
+
+  return primal;
+}
+
+/* the box around the surface, half again as wide as its bounding box
+ * and shifted off center so that grid planes miss the surface nodes */
+static void bench_extent( Primal surface_primal, double *lo, double *hi )
+{
+  int node, i;
+  double center, half;
+  double shift[3] = { 0.0137, 0.0291, 0.0173 };
+
+  for ( i = 0 ; i < 3 ; i++ )
+    {
+      lo[i] = surface_primal->xyz[i];
+      hi[i] = surface_primal->xyz[i];
+    }
+  for ( node = 1 ; node < primal_nnode(surface_primal) ; node++ )
+    for ( i = 0 ; i < 3 ; i++ )
+      {
+	lo[i] = MIN( lo[i], surface_primal->xyz[i+3*node] );
+	hi[i] = MAX( hi[i], surface_primal->xyz[i+3*node] );
+      }
+  for ( i = 0 ; i < 3 ; i++ )
+    {
+      half = 0.75*(hi[i]-lo[i]);
+      center = 0.5*(lo[i]+hi[i]) + shift[i]*half;
+      lo[i] = center - half;
+      hi[i] = center + half;
+    }
+}
+
+static void bench_row( FILE *f, char *surface_name, int size, Primal volume,
+		       int nsurface, int threads, char *phase_name,
+		       double wall, double cpu, long peak_rss, long *count )
+{
+  int counter;
+
+  fprintf( f, "%s,%d,%d,%d,%d,%d,%s,%.6f,%.6f,%ld",
+	   surface_name, size, primal_nnode(volume), primal_ncell(volume),
+	   nsurface, threads, phase_name, wall, cpu, peak_rss );
+  for ( counter = 0 ; counter < PROFILE_NCOUNTER ; counter++ )
+    fprintf( f, ",%ld", count[counter] );
+  fprintf( f, "\n" );
+}
+
+/* cut a size^3 box around surface_primal and write a row per phase and
+ * a total */
+static KNIFE_STATUS bench_cut( FILE *f, char *surface_name,
+			       Primal surface_primal, int size, int threads )
+{
+  Primal volume;
+  Surface surface;
+  Domain domain;
+  int *required;
+  double lo[3], hi[3];
+  int phase_index, counter;
+  ProfilePhase phase;
+  double wall, cpu;
+  long peak_rss;
+  long count[PROFILE_NCOUNTER];
+
+  TSS( profile_reset( ), "profile_reset" );
+  TSS( profile_phase( "setup" ), "profile_phase" );
+
+  bench_extent( surface_primal, lo, hi );
+  volume = bench_box( size, size, size, lo, hi );
+  TNS( volume, "bench_box" );
+  TSS( primal_establish_all( volume ), "primal_establish_all" );
+  surface = surface_from( surface_primal, NULL, FALSE );
+  TNS( surface, "surface_from" );
+  domain = domain_create( volume, surface );
+  TNS( domain, "domain_create" );
+  required = (int *)malloc( primal_nnode(volume) * sizeof(int) );
+  TNS( required, "required" );
+
+  TSS( domain_required_local_dual( domain, required ),
+       "domain_required_local_dual" );
+  TSS( domain_create_dual( domain, required ), "domain_create_dual" );
+  TSS( domain_boolean_subtract( domain ), "domain_boolean_subtract" );
+  TSS( profile_end( ), "profile_end" );
+
+  wall = 0.0;
+  cpu = 0.0;
+  peak_rss = 0;
+  for ( counter = 0 ; counter < PROFILE_NCOUNTER ; counter++ )
+    count[counter] = 0;
+  for ( phase_index = 0 ; phase_index < profile_nphase( ) ; phase_index++ )
+    {
+      phase = profile_phase_record( phase_index );
+      bench_row( f, surface_name, size, volume, surface_ntriangle(surface),
+		 threads, phase->name, phase->wall, phase->cpu,
+		 phase->peak_rss, phase->count );
+      if ( 0 == phase_index ) continue; /* setup is not the cut */
+      wall += phase->wall;
+      cpu += phase->cpu;
+      peak_rss = MAX( peak_rss, phase->peak_rss );
+      for ( counter = 0 ; counter < PROFILE_NCOUNTER ; counter++ )
+	count[counter] += phase->count[counter];
+    }
+  bench_row( f, surface_name, size, volume, surface_ntriangle(surface),
+	     threads, "total", wall, cpu, peak_rss, count );
+  fflush( f );
+
+  printf( "%-8s %4d^3 nodes %2d threads %10.3f s\n",
+	  surface_name, size, threads, wall );
+
+  free( required );
+  domain_free( domain );
+  surface_free( surface );
+  primal_free( volume );
+
+  return KNIFE_SUCCESS;
+}
+
+int main( int argc, char *argv[] )
+{
+  int size[BENCH_MAX_LIST], nsize;
+  int threads[BENCH_MAX_LIST], nthreads;
+  char *output_filename;
+  char *cylinder_filename;
+  FILE *f;
+  int arg, counter;
+  int surface_index, size_index, threads_index;
+  int nfailed;
+  char *surface_name[3] = { "sphere", "cylinder", "wing" };
+  Primal surface_primal;
+
+  nsize = bench_list( "9,17,33", size, BENCH_MAX_LIST );
+  nthreads = bench_list( "1", threads, BENCH_MAX_LIST );
+  output_filename = "bench.csv";
+  cylinder_filename = NULL;
+
+  for ( arg = 1 ; arg < argc ; arg++ )
+    {
+      if ( 0 == strcmp( argv[arg], "-s" ) && arg+1 < argc )
+	{
+	  nsize = bench_list( argv[++arg], size, BENCH_MAX_LIST );
+	  continue;
+	}
+      if ( 0 == strcmp( argv[arg], "-t" ) && arg+1 < argc )
+	{
+	  nthreads = bench_list( argv[++arg], threads, BENCH_MAX_LIST );
+	  continue;
+	}
+      if ( 0 == strcmp( argv[arg], "-1" ) )
+	{
+	  triangle_set_single_cut_check( TRUE );
+	  continue;
+	}
+      if ( 0 == strcmp( argv[arg], "-c" ) )
+	{
+	  triangle_set_cdt_check( TRUE );
+	  continue;
+	}
+      if ( 0 == strcmp( argv[arg], "-o" ) && arg+1 < argc )
+	{
+	  output_filename = argv[++arg];
+	  continue;
+	}
+      if ( '-' != argv[arg][0] )
+	{
+	  cylinder_filename = argv[arg];
+	  continue;
+	}
+      nsize = EMPTY;
+    }
+
+  if ( EMPTY == nsize || EMPTY == nthreads )
+    {
+      printf("usage : %s [-s nodes,...] [-t threads,...] [-1] [-c] "
+	     "[-o bench.csv] "
+	     "[cylinder.tri]\n", argv[0] );
+      printf("  cuts boxes of nodes^3 (default 9,17,33) with a sphere, the\n");
+      printf("  cylinder (when given) and a thin wing, once per thread count\n");
+      printf("  -1 checks the single cut split against the generic path\n");
+      printf("  -c recovers every multiple cut triangle with the cdt\n");
+      printf("  exits 1 when a cut (or a check) fails\n");
+      return 1;
+    }
+
+  f = fopen( output_filename, "w" );
+  if ( NULL == f )
+    {
+      printf("%s: %d: could not open %s\n",__FILE__,__LINE__,output_filename);
+      return 1;
+    }
+  fprintf( f, "surface,size,nnode,ncell,nsurface,threads,phase,"
+	   "wall,cpu,peak_rss_kb" );
+  for ( counter = 0 ; counter < PROFILE_NCOUNTER ; counter++ )
+    fprintf( f, ",%s", profile_counter_name( counter ) );
+  fprintf( f, "\n" );
+
+  nfailed = 0;
+  for ( surface_index = 0 ; surface_index < 3 ; surface_index++ )
+    {
+      surface_primal = NULL;
+      if ( 0 == surface_index ) surface_primal = bench_sphere( );
+      if ( 1 == surface_index && NULL != cylinder_filename )
+	surface_primal = primal_from_file( cylinder_filename );
+      if ( 2 == surface_index ) surface_primal = bench_wing( );
+      if ( NULL == surface_primal )
+	{
+	  if ( 1 != surface_index || NULL != cylinder_filename )
+	    printf("%s: %d: no %s surface\n",
+		   __FILE__,__LINE__,surface_name[surface_index]);
+	  continue;
+	}
+      for ( size_index = 0 ; size_index < nsize ; size_index++ )
+	for ( threads_index = 0 ; threads_index < nthreads ; threads_index++ )
+	  {
+#ifdef _OPENMP
+	    omp_set_num_threads( threads[threads_index] );
+#else
+	    if ( 1 != threads[threads_index] )
+	      {
+		printf("%d threads skipped, built without openmp\n",
+		       threads[threads_index] );
+		continue;
+	      }
+#endif
+	    if ( KNIFE_SUCCESS != bench_cut( f, surface_name[surface_index],
+					     surface_primal,
+					     size[size_index],
+					     threads[threads_index] ) )
+	      {
+		printf("%s: %d: %s %d^3 cut failed\n",__FILE__,__LINE__,
+		       surface_name[surface_index], size[size_index] );
+		nfailed++;
+	      }
+	  }
+      primal_free( surface_primal );
+    }
+
+  if ( 0 != fclose( f ) ) return 1;
+
+  return ( nfailed > 0 ? 1 : 0 );
+}
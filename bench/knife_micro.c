@@ -0,0 +1,585 @@
+
+/* microbenchmarks of the geometric kernels on seeded random inputs,
+ * no volume grid needed */
+
+/* Copyright 2007 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space
+ * Administration. No copyright is claimed in the United States under
+ * Title 17, U.S. Code.  All Other Rights Reserved.
+ *
+ * The knife platform is licensed under the Apache License, Version
+ * 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "knife_definitions.h"
+#include "node.h"
+#include "segment.h"
+#include "triangle.h"
+#include "intersection.h"
+#include "cut.h"
+#include "near.h"
+#include "mask.h"
+#include "poly.h"
+
+/* each kernel is repeated until it has run this long */
+#define MICRO_MIN_SECONDS (0.2)
+
+#define MICRO_NSEGMENT (4096)
+#define MICRO_NNEAR    (65536)
+#define MICRO_NQUERY   (4096)
+#define MICRO_NCLUSTER (8)
+#define MICRO_NTRIAL   (8)
+
+#define MICRO_PI (3.14159265358979323846)
+
+#define TRY(fcn,msg)					      \
+  {							      \
+    int code;						      \
+    code = (fcn);					      \
+    if (KNIFE_SUCCESS != code){				      \
+      printf("%s: %d: %d %s\n",__FILE__,__LINE__,code,(msg)); \
+      return code;					      \
+    }							      \
+  }
+
+#define NOT_NULL(pointer,msg)				      \
+  if (NULL == (pointer)) {				      \
+    printf("%s: %d: %s\n",__FILE__,__LINE__,(msg));	      \
+    return KNIFE_NULL;					      \
+  }
+
+/* xorshift, so the inputs are the same on every platform */
+static unsigned long long micro_state = 1;
+
+static void micro_seed( unsigned long long seed )
+{
+  micro_state = ( 0 == seed ? 1 : seed );
+}
+
+static double micro_random( void )
+{
+  micro_state ^= micro_state << 13;
+  micro_state ^= micro_state >> 7;
+  micro_state ^= micro_state << 17;
+  return (double)(micro_state >> 11) / 9007199254740992.0;
+}
+
+/* sum of 4 uniforms, near normal with unit variance */
+static double micro_normal( void )
+{
+  return ( micro_random( ) + micro_random( ) +
+	   micro_random( ) + micro_random( ) - 2.0 ) * sqrt(3.0);
+}
+
+typedef KNIFE_STATUS (*MicroKernel)( void *data );
+
+/* call kernel (nop operations a call) until MICRO_MIN_SECONDS of cpu
+ * and print the cpu time of one operation */
+static KNIFE_STATUS micro_run( char *name, MicroKernel kernel, void *data,
+			       int nop )
+{
+  long calls, call;
+  clock_t start;
+  double seconds;
+
+  calls = 1;
+  while ( TRUE )
+    {
+      start = clock( );
+      for ( call = 0 ; call < calls ; call++ )
+	TRY( kernel( data ), name );
+      seconds = ((double)(clock( ) - start))/((double)CLOCKS_PER_SEC);
+      if ( seconds >= MICRO_MIN_SECONDS ) break;
+      calls *= 2;
+    }
+
+  printf( "%-36s %12.1f ns/op %10ld ops\n", name,
+	  1.0e9*seconds/((double)calls*(double)nop), calls*(long)nop );
+
+  return KNIFE_SUCCESS;
+}
+
+/* a triangle with its own nodes and segments */
+typedef struct MicroTriangleStruct MicroTriangleStruct;
+typedef MicroTriangleStruct * MicroTriangle;
+struct MicroTriangleStruct {
+  Node node[3];
+  Segment segment[3];
+  Triangle triangle;
+};
+
+static KNIFE_STATUS micro_triangle( MicroTriangle micro,
+				    double *xyz0, double *xyz1, double *xyz2 )
+{
+  micro->node[0] = node_create( xyz0 );
+  micro->node[1] = node_create( xyz1 );
+  micro->node[2] = node_create( xyz2 );
+  NOT_NULL( micro->node[0], "node0" );
+  NOT_NULL( micro->node[1], "node1" );
+  NOT_NULL( micro->node[2], "node2" );
+  micro->segment[0] = segment_create( micro->node[1], micro->node[2] );
+  micro->segment[1] = segment_create( micro->node[2], micro->node[0] );
+  micro->segment[2] = segment_create( micro->node[0], micro->node[1] );
+  NOT_NULL( micro->segment[0], "segment0" );
+  NOT_NULL( micro->segment[1], "segment1" );
+  NOT_NULL( micro->segment[2], "segment2" );
+  micro->triangle = triangle_create( micro->segment[0], micro->segment[1],
+				     micro->segment[2], EMPTY );
+  NOT_NULL( micro->triangle, "triangle" );
+
+  return KNIFE_SUCCESS;
+}
+
+/* the cuts are freed with the triangle that lists them first */
+static void micro_triangle_free( MicroTriangle micro, KnifeBool free_cuts )
+{
+  int i;
+
+  if ( free_cuts )
+    for ( i = 0 ; i < triangle_ncut(micro->triangle) ; i++ )
+      cut_free( triangle_cut(micro->triangle,i) );
+  triangle_free( micro->triangle );
+  for ( i = 0 ; i < 3 ; i++ )
+    {
+      segment_drop_intersections( micro->segment[i] );
+      segment_free( micro->segment[i] );
+      node_free( micro->node[i] );
+    }
+}
+
+/* intersection_core */
+
+typedef struct MicroSegmentsStruct MicroSegmentsStruct;
+struct MicroSegmentsStruct {
+  double xyz[5*3*MICRO_NSEGMENT];
+  int nhit;
+};
+
+/* triangle corners in the unit cube, the segment through the triangle
+ * when pierce, otherwise anywhere in the cube */
+static void micro_segments( MicroSegmentsStruct *segments, KnifeBool pierce )
+{
+  int i, j;
+  double *xyz;
+  double bary[3], sum, center[3], direction[3];
+
+  for ( i = 0 ; i < MICRO_NSEGMENT ; i++ )
+    {
+      xyz = &(segments->xyz[15*i]);
+      for ( j = 0 ; j < 15 ; j++ ) xyz[j] = micro_random( );
+      if ( !pierce ) continue;
+      bary[0] = 0.05 + micro_random( );
+      bary[1] = 0.05 + micro_random( );
+      bary[2] = 0.05 + micro_random( );
+      sum = bary[0] + bary[1] + bary[2];
+      for ( j = 0 ; j < 3 ; j++ )
+	{
+	  center[j] = ( bary[0]*xyz[j] + bary[1]*xyz[3+j] +
+			bary[2]*xyz[6+j] ) / sum;
+	  direction[j] = micro_normal( );
+	}
+      for ( j = 0 ; j < 3 ; j++ )
+	{
+	  xyz[9+j]  = center[j] - 0.5*direction[j];
+	  xyz[12+j] = center[j] + 0.5*direction[j];
+	}
+    }
+}
+
+static KNIFE_STATUS micro_intersection_core( void *data )
+{
+  MicroSegmentsStruct *segments = (MicroSegmentsStruct *)data;
+  int i;
+  double *xyz;
+  double t, uvw[3];
+
+  segments->nhit = 0;
+  for ( i = 0 ; i < MICRO_NSEGMENT ; i++ )
+    {
+      xyz = &(segments->xyz[15*i]);
+      if ( KNIFE_SUCCESS == intersection_core( &xyz[0], &xyz[3], &xyz[6],
+					       &xyz[9], &xyz[12],
+					       &t, uvw ) ) segments->nhit++;
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+/* near_touched */
+
+typedef struct MicroNearStruct MicroNearStruct;
+struct MicroNearStruct {
+  NearStruct *tree;
+  NearStruct query[MICRO_NQUERY];
+  int touched[MICRO_NNEAR];
+  long found;
+};
+
+/* spheres spaced about their diameter in the unit cube, queries the
+ * same size, spread over the cube or gathered around a few points */
+static KNIFE_STATUS micro_near( MicroNearStruct *near, KnifeBool cluster )
+{
+  int i, j;
+  double radius;
+  double center[MICRO_NCLUSTER][3];
+  double xyz[3];
+
+  radius = 0.5 / pow( (double)MICRO_NNEAR, 1.0/3.0 );
+
+  near->tree = (NearStruct *)malloc( MICRO_NNEAR*sizeof(NearStruct) );
+  NOT_NULL( near->tree, "tree" );
+  for ( i = 0 ; i < MICRO_NNEAR ; i++ )
+    {
+      near_initialize( &(near->tree[i]), i, micro_random( ), micro_random( ),
+		       micro_random( ), radius );
+      if ( i > 0 ) near_insert( near->tree, &(near->tree[i]) );
+    }
+
+  for ( i = 0 ; i < MICRO_NCLUSTER ; i++ )
+    for ( j = 0 ; j < 3 ; j++ )
+      center[i][j] = 0.2 + 0.6*micro_random( );
+  for ( i = 0 ; i < MICRO_NQUERY ; i++ )
+    {
+      for ( j = 0 ; j < 3 ; j++ )
+	xyz[j] = ( cluster ?
+		   center[i%MICRO_NCLUSTER][j] + 0.02*micro_normal( ) :
+		   micro_random( ) );
+      near_initialize( &(near->query[i]), i, xyz[0], xyz[1], xyz[2],
+		       radius );
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+static KNIFE_STATUS micro_near_touched( void *data )
+{
+  MicroNearStruct *near = (MicroNearStruct *)data;
+  int i, found;
+
+  near->found = 0;
+  for ( i = 0 ; i < MICRO_NQUERY ; i++ )
+    {
+      found = 0;
+      TRY( near_touched( near->tree, &(near->query[i]),
+			 &found, MICRO_NNEAR, near->touched ), "touched" );
+      near->found += found;
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+/* triangle_triangulate_cuts and mask_paint */
+
+typedef struct MicroCutsStruct MicroCutsStruct;
+struct MicroCutsStruct {
+  int ncut;
+  MicroTriangleStruct dual[MICRO_NTRIAL];
+  MicroTriangleStruct *cutter;
+  Mask mask;
+};
+
+/* a unit right triangle in z=0 crossed by ncut parallel chords, each
+ * made by a vertical cutter triangle at a random offset */
+static KNIFE_STATUS micro_cuts( MicroCutsStruct *cuts, int ncut )
+{
+  int trial, cut_index;
+  double xyz[3][3];
+  double angle, d[2], p[2];
+  double lo, hi, offset;
+  MicroTriangle cutter;
+
+  cuts->ncut = ncut;
+  cuts->cutter = (MicroTriangleStruct *)
+    malloc( MICRO_NTRIAL*ncut*sizeof(MicroTriangleStruct) );
+  NOT_NULL( cuts->cutter, "cutter" );
+  cuts->mask = NULL;
+
+  for ( trial = 0 ; trial < MICRO_NTRIAL ; trial++ )
+    {
+      xyz[0][0] = 0.0; xyz[0][1] = 0.0; xyz[0][2] = 0.0;
+      xyz[1][0] = 1.0; xyz[1][1] = 0.0; xyz[1][2] = 0.0;
+      xyz[2][0] = 0.0; xyz[2][1] = 1.0; xyz[2][2] = 0.0;
+      TRY( micro_triangle( &(cuts->dual[trial]), xyz[0], xyz[1], xyz[2] ),
+	   "dual" );
+
+      /* chords normal to d, between the projections of the corners */
+      angle = 2.0*MICRO_PI*micro_random( );
+      d[0] = cos(angle);
+      d[1] = sin(angle);
+      p[0] = -d[1];
+      p[1] = d[0];
+      lo = MIN( 0.0, MIN( d[0], d[1] ) );
+      hi = MAX( 0.0, MAX( d[0], d[1] ) );
+      for ( cut_index = 0 ; cut_index < ncut ; cut_index++ )
+	{
+	  offset = lo + (hi-lo)*( 0.02 + 0.96*micro_random( ) );
+	  xyz[0][0] = offset*d[0] - 3.0*p[0];
+	  xyz[0][1] = offset*d[1] - 3.0*p[1];
+	  xyz[0][2] = -1.0;
+	  xyz[1][0] = offset*d[0] + 3.0*p[0];
+	  xyz[1][1] = offset*d[1] + 3.0*p[1];
+	  xyz[1][2] = -1.0;
+	  xyz[2][0] = offset*d[0];
+	  xyz[2][1] = offset*d[1];
+	  xyz[2][2] = 2.0;
+	  cutter = &(cuts->cutter[cut_index+ncut*trial]);
+	  TRY( micro_triangle( cutter, xyz[0], xyz[1], xyz[2] ), "cutter" );
+	  TRY( cut_establish_between( cuts->dual[trial].triangle,
+				      cutter->triangle ), "cut" );
+	}
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+static void micro_cuts_free( MicroCutsStruct *cuts )
+{
+  int trial, cut_index;
+
+  mask_free( cuts->mask );
+  for ( trial = 0 ; trial < MICRO_NTRIAL ; trial++ )
+    {
+      micro_triangle_free( &(cuts->dual[trial]), TRUE );
+      for ( cut_index = 0 ; cut_index < cuts->ncut ; cut_index++ )
+	micro_triangle_free( &(cuts->cutter[cut_index+cuts->ncut*trial]),
+			     FALSE );
+    }
+  free( cuts->cutter );
+}
+
+static KNIFE_STATUS micro_triangulate_cuts( void *data )
+{
+  MicroCutsStruct *cuts = (MicroCutsStruct *)data;
+  int trial;
+
+  for ( trial = 0 ; trial < MICRO_NTRIAL ; trial++ )
+    {
+      TRY( triangle_reset_subtri( cuts->dual[trial].triangle ), "reset" );
+      TRY( triangle_triangulate_cuts( cuts->dual[trial].triangle ),
+	   "triangulate" );
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+/* every subtri starts in its own region, painted down to a region
+ * between each pair of cuts */
+static KNIFE_STATUS micro_mask_paint( void *data )
+{
+  MicroCutsStruct *cuts = (MicroCutsStruct *)data;
+  int nsubtri, subtri_index;
+
+  nsubtri = triangle_nsubtri( mask_triangle(cuts->mask) );
+  for ( subtri_index = 0 ; subtri_index < nsubtri ; subtri_index++ )
+    cuts->mask->region[subtri_index] = subtri_index+1;
+
+  TRY( mask_paint( cuts->mask ), "paint" );
+
+  return KNIFE_SUCCESS;
+}
+
+/* poly_centroid_volume */
+
+#define MICRO_POLY_NLAT (4)
+#define MICRO_POLY_NLON (8)
+#define MICRO_POLY_NFACE (2*(MICRO_POLY_NLAT-1)*MICRO_POLY_NLON)
+
+typedef struct MicroPolyStruct MicroPolyStruct;
+struct MicroPolyStruct {
+  MicroTriangleStruct face[MICRO_POLY_NFACE];
+  Poly poly;
+  double volume;
+};
+
+/* a dual poly sized closed surface, latitude and longitude lines of a
+ * unit sphere with the radius jittered */
+static KNIFE_STATUS micro_poly( MicroPolyStruct *micro )
+{
+  double xyz[2+(MICRO_POLY_NLAT-1)*MICRO_POLY_NLON][3];
+  int lat, lon, node, face;
+  double theta, phi, radius;
+
+#define micro_poly_node(lat,lon) \
+  (2+((lon)%MICRO_POLY_NLON)+((lat)-1)*MICRO_POLY_NLON)
+  for ( node = 0 ; node < 2 ; node++ )
+    {
+      xyz[node][0] = 0.0;
+      xyz[node][1] = 0.0;
+      xyz[node][2] = ( 0 == node ? 1.0 : -1.0 );
+    }
+  for ( lat = 1 ; lat < MICRO_POLY_NLAT ; lat++ )
+    for ( lon = 0 ; lon < MICRO_POLY_NLON ; lon++ )
+      {
+	theta = MICRO_PI*(double)lat/(double)MICRO_POLY_NLAT;
+	phi = 2.0*MICRO_PI*(double)lon/(double)MICRO_POLY_NLON;
+	radius = 0.9 + 0.2*micro_random( );
+	node = micro_poly_node(lat,lon);
+	xyz[node][0] = radius*sin(theta)*cos(phi);
+	xyz[node][1] = radius*sin(theta)*sin(phi);
+	xyz[node][2] = radius*cos(theta);
+      }
+
+  face = 0;
+  for ( lon = 0 ; lon < MICRO_POLY_NLON ; lon++ )
+    {
+      TRY( micro_triangle( &(micro->face[face++]), xyz[0],
+			   xyz[micro_poly_node(1,lon)],
+			   xyz[micro_poly_node(1,lon+1)] ), "north" );
+      TRY( micro_triangle( &(micro->face[face++]), xyz[1],
+			   xyz[micro_poly_node(MICRO_POLY_NLAT-1,lon+1)],
+			   xyz[micro_poly_node(MICRO_POLY_NLAT-1,lon)] ),
+	   "south" );
+    }
+  for ( lat = 1 ; lat < MICRO_POLY_NLAT-1 ; lat++ )
+    for ( lon = 0 ; lon < MICRO_POLY_NLON ; lon++ )
+      {
+	TRY( micro_triangle( &(micro->face[face++]),
+			     xyz[micro_poly_node(lat,lon)],
+			     xyz[micro_poly_node(lat+1,lon)],
+			     xyz[micro_poly_node(lat+1,lon+1)] ), "band" );
+	TRY( micro_triangle( &(micro->face[face++]),
+			     xyz[micro_poly_node(lat,lon)],
+			     xyz[micro_poly_node(lat+1,lon+1)],
+			     xyz[micro_poly_node(lat,lon+1)] ), "band" );
+      }
+#undef micro_poly_node
+
+  micro->poly = poly_create( );
+  NOT_NULL( micro->poly, "poly" );
+  for ( face = 0 ; face < MICRO_POLY_NFACE ; face++ )
+    TRY( poly_add_triangle( micro->poly, micro->face[face].triangle, FALSE ),
+	 "poly_add_triangle" );
+
+  return KNIFE_SUCCESS;
+}
+
+static KNIFE_STATUS micro_poly_centroid_volume( void *data )
+{
+  MicroPolyStruct *micro = (MicroPolyStruct *)data;
+  double origin[3] = { 0.1, 0.2, 0.3 };
+  double centroid[3];
+
+  TRY( poly_centroid_volume( micro->poly, 1, origin,
+			     centroid, &(micro->volume) ), "centroid" );
+
+  return KNIFE_SUCCESS;
+}
+
+static KnifeBool micro_selected( int argc, char *argv[], char *kernel )
+{
+  int arg;
+
+  if ( argc < 2 ) return TRUE;
+  for ( arg = 1 ; arg < argc ; arg++ )
+    if ( 0 == strcmp( argv[arg], kernel ) ) return TRUE;
+  return FALSE;
+}
+
+int main( int argc, char *argv[] )
+{
+  MicroSegmentsStruct *segments;
+  MicroNearStruct *near;
+  MicroCutsStruct *cuts;
+  MicroPolyStruct *micro;
+  int pierce, cluster, ncut;
+  char name[128];
+
+  if ( argc > 1 && '-' == argv[1][0] )
+    {
+      printf("usage : %s [kernel ...]\n", argv[0] );
+      printf("  kernels intersection_core near_touched "
+	     "triangulate_cuts mask_paint\n");
+      printf("  poly_centroid_volume (default all), cpu ns per operation\n");
+      return 1;
+    }
+
+  if ( micro_selected( argc, argv, "intersection_core" ) )
+    {
+      segments = (MicroSegmentsStruct *)malloc(sizeof(MicroSegmentsStruct));
+      TNS( segments, "segments" );
+      for ( pierce = 0 ; pierce < 2 ; pierce++ )
+	{
+	  micro_seed( 1 );
+	  micro_segments( segments, (KnifeBool)pierce );
+	  sprintf( name, "intersection_core %s",
+		   ( pierce ? "piercing" : "random" ) );
+	  TSS( micro_run( name, micro_intersection_core, segments,
+			  MICRO_NSEGMENT ), name );
+	}
+      free( segments );
+    }
+
+  if ( micro_selected( argc, argv, "near_touched" ) )
+    {
+      near = (MicroNearStruct *)malloc(sizeof(MicroNearStruct));
+      TNS( near, "near" );
+      for ( cluster = 0 ; cluster < 2 ; cluster++ )
+	{
+	  micro_seed( 2 );
+	  TSS( micro_near( near, (KnifeBool)cluster ), "micro_near" );
+	  sprintf( name, "near_touched %s",
+		   ( cluster ? "clustered" : "random" ) );
+	  TSS( micro_run( name, micro_near_touched, near,
+			  MICRO_NQUERY ), name );
+	  free( near->tree );
+	}
+      free( near );
+    }
+
+  cuts = (MicroCutsStruct *)malloc(sizeof(MicroCutsStruct));
+  TNS( cuts, "cuts" );
+  for ( ncut = 1 ; ncut <= 100 ; ncut *= 10 )
+    {
+      if ( !micro_selected( argc, argv, "triangulate_cuts" ) &&
+	   !( 100 == ncut && micro_selected( argc, argv, "mask_paint" ) ) )
+	continue;
+      micro_seed( 3 );
+      TSS( micro_cuts( cuts, ncut ), "micro_cuts" );
+      /* includes the reset of the subtri to the single original */
+      sprintf( name, "triangulate_cuts %d cut%s", ncut,
+	       ( 1 == ncut ? "" : "s" ) );
+      TSS( micro_run( name, micro_triangulate_cuts, cuts,
+		      MICRO_NTRIAL ), name );
+      if ( 100 == ncut && micro_selected( argc, argv, "mask_paint" ) )
+	{
+	  cuts->mask = mask_create( cuts->dual[0].triangle, FALSE );
+	  TNS( cuts->mask, "mask" );
+	  TSS( mask_deactivate_all_subtri( cuts->mask ), "deactivate" );
+	  sprintf( name, "mask_paint %d subtri",
+		   triangle_nsubtri( cuts->dual[0].triangle ) );
+	  TSS( micro_run( name, micro_mask_paint, cuts, 1 ), name );
+	}
+      micro_cuts_free( cuts );
+    }
+  free( cuts );
+
+  if ( micro_selected( argc, argv, "poly_centroid_volume" ) )
+    {
+      micro = (MicroPolyStruct *)malloc(sizeof(MicroPolyStruct));
+      TNS( micro, "poly" );
+      micro_seed( 4 );
+      TSS( micro_poly( micro ), "micro_poly" );
+      sprintf( name, "poly_centroid_volume %d faces", MICRO_POLY_NFACE );
+      TSS( micro_run( name, micro_poly_centroid_volume, micro, 1 ), name );
+      poly_free( micro->poly );
+      for ( ncut = 0 ; ncut < MICRO_POLY_NFACE ; ncut++ )
+	micro_triangle_free( &(micro->face[ncut]), FALSE );
+      free( micro );
+    }
+
+  return 0;
+}
@@ -152,6 +152,140 @@ Adj adj_add( Adj adj, int node, int item )
   return adj;
 }
 
+/* node2item[start[node]] to node2item[start[node+1]-1] hold the items
+ * of node, in list order; chain them (adj_allocate_and_init_node2item
+ * already links each slot to the next) and put the rest on blank */
+static void adj_chain_lists( Adj adj, int *start )
+{
+  int node;
+
+  for ( node=0 ; node<adj->nnode; node++ )
+    {
+      adj->first[node] = NULL;
+      if ( start[node] == start[node+1] ) continue;
+      adj->first[node] = &(adj->node2item[start[node]]);
+      adj->node2item[start[node+1]-1].next = NULL;
+    }
+  adj->blank = ( start[adj->nnode] < adj->nadj ? 
+		 &(adj->node2item[start[adj->nnode]]) : NULL );
+  adj->current = NULL;
+}
+
+/* same result as adj_add( adj, item2node[n+stride*item], item ) for
+ * each item and n < nodes_per_item in order, but an empty adj is laid
+ * out with one counting pass instead of growing a chunk at a time */
+Adj adj_add_elements( Adj adj, int nitem, int nodes_per_item, int stride,
+		      int *item2node )
+{
+  int *offset;
+  int nnode, item, n, node, total;
+
+  nnode = adj->nnode;
+
+  for ( node=0 ; node<nnode; node++ )
+    if ( NULL != adj->first[node] ) break;
+  if ( node < nnode )
+    {
+      for ( item = 0 ; item < nitem ; item++ )
+	for ( n = 0 ; n < nodes_per_item ; n++ )
+	  adj_add( adj, item2node[n+stride*item], item );
+      return adj;
+    }
+
+  offset = (int *)malloc( (nnode+2) * sizeof(int) );
+  if (NULL == offset) {
+    printf("%s: %d: malloc failed in adj_add_elements\n",
+	   __FILE__,__LINE__);
+    return NULL;
+  }
+  for ( node=0 ; node<=nnode; node++ ) offset[node] = 0;
+  for ( item = 0 ; item < nitem ; item++ )
+    for ( n = 0 ; n < nodes_per_item ; n++ )
+      {
+	node = item2node[n+stride*item];
+	if ( node >= 0 && node < nnode ) offset[node+1]++;
+      }
+  total = 0;
+  for ( node=0 ; node<nnode; node++ )
+    {
+      total += offset[node+1];
+      offset[node+1] = total;
+    }
+
+  free( adj->node2item );
+  adj->nadj = MAX( adj->nadj, MAX(total,1) );
+  if ( KNIFE_SUCCESS != adj_allocate_and_init_node2item(adj) )
+    {
+      free( offset );
+      return NULL;
+    }
+
+  /* fill each node's slots from the back so the last item added is
+   * first, matching the push front of adj_add */
+  for ( item = 0 ; item < nitem ; item++ )
+    for ( n = 0 ; n < nodes_per_item ; n++ )
+      {
+	node = item2node[n+stride*item];
+	if ( node < 0 || node >= nnode ) continue;
+	offset[node+1]--;
+	adj->node2item[offset[node+1]].item = item;
+      }
+
+  /* the fill left offset[node+1] at the start of node's slots */
+  offset[nnode+1] = total;
+  adj_chain_lists( adj, &(offset[1]) );
+
+  free( offset );
+
+  return adj;
+}
+
+/* replace the contents of adj with the lists of adj_lists */
+Adj adj_from_lists( Adj adj, int *start, int *item )
+{
+  int node, slot;
+
+  if ( 0 != start[0] ) return NULL;
+  for ( node=0 ; node<adj->nnode; node++ )
+    if ( start[node+1] < start[node] ) return NULL;
+
+  free( adj->node2item );
+  adj->nadj = MAX( adj->nadj, MAX(start[adj->nnode],1) );
+  if ( KNIFE_SUCCESS != adj_allocate_and_init_node2item(adj) ) return NULL;
+
+  for ( slot = 0 ; slot < start[adj->nnode] ; slot++ )
+    adj->node2item[slot].item = item[slot];
+  adj_chain_lists( adj, start );
+
+  return adj;
+}
+
+/* start[nnode+1] and item[adj_nitem] of the lists, in iteration order */
+KNIFE_STATUS adj_lists( Adj adj, int *start, int *item )
+{
+  int node, slot;
+  AdjIterator it;
+
+  slot = 0;
+  for ( node=0 ; node<adj->nnode; node++ )
+    {
+      start[node] = slot;
+      for ( it = adj_first(adj,node); adj_valid(it); it = adj_next(it) )
+	item[slot++] = adj_item(it);
+    }
+  start[adj->nnode] = slot;
+
+  return KNIFE_SUCCESS;
+}
+
+int adj_nitem( Adj adj )
+{
+  int node, nitem;
+  nitem = 0;
+  for ( node=0 ; node<adj->nnode; node++ ) nitem += adj_degree( adj, node );
+  return nitem;
+}
+
 Adj adj_remove(Adj adj, int node, int item)
 {
   AdjIterator it;
@@ -53,6 +53,11 @@ void adj_free( Adj );
 Adj adj_resize( Adj, int nnode );
 
 Adj adj_add( Adj, int node, int item );
+Adj adj_add_elements( Adj, int nitem, int nodes_per_item, int stride,
+		      int *item2node );
+Adj adj_from_lists( Adj, int *start, int *item );
+KNIFE_STATUS adj_lists( Adj, int *start, int *item );
+int adj_nitem( Adj );
 Adj adj_remove( Adj, int node, int item );
 
 #define adj_valid(iterator) (iterator!=NULL)
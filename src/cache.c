@@ -0,0 +1,707 @@
+/* persistent cut results of one partition, keyed on its inputs */
+
+/* Copyright 2007 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space
+ * Administration. No copyright is claimed in the United States under
+ * Title 17, U.S. Code.  All Other Rights Reserved.
+ *
+ * The knife platform is licensed under the Apache License, Version
+ * 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_SYS_STAT_H
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+#include "cache.h"
+#include "poly.h"
+
+#define CACHE_MAGIC "KNIFECUT"
+#define CACHE_VERSION (1)
+#define CACHE_NHEADER (8)
+
+#define TRY(fcn,msg)					      \
+  {							      \
+    int code;						      \
+    code = (fcn);					      \
+    if (KNIFE_SUCCESS != code){				      \
+      printf("%s: %d: %d %s\n",__FILE__,__LINE__,code,(msg)); \
+      return code;					      \
+    }							      \
+  }
+
+#define NOT_NULL(pointer,msg)				      \
+  if (NULL == (pointer)) {				      \
+    printf("%s: %d: %s\n",__FILE__,__LINE__,(msg));	      \
+    return KNIFE_NULL;					      \
+  }
+
+Cache cache_create( void )
+{
+  Cache cache;
+
+  cache = (Cache) malloc( sizeof(CacheStruct) );
+  if (NULL == cache) {
+    printf("%s: %d: malloc failed in cache_create\n",
+	   __FILE__,__LINE__);
+    return NULL; 
+  }
+
+  cache->key = 0;
+
+  cache->npoly = 0;
+  cache->topo = NULL;
+
+  cache->nrecord = 0;
+  cache->nrecord_allocated = 0;
+  cache->record = NULL;
+
+  cache->nint = 0;
+  cache->nint_allocated = 0;
+  cache->ints = NULL;
+
+  cache->ndouble = 0;
+  cache->ndouble_allocated = 0;
+  cache->doubles = NULL;
+
+  cache->nhash = 0;
+  cache->hash = NULL;
+
+  return cache;
+}
+
+void cache_free( Cache cache )
+{
+  if ( NULL == cache ) return;
+  if ( NULL != cache->topo ) free( cache->topo );
+  if ( NULL != cache->record ) free( cache->record );
+  if ( NULL != cache->ints ) free( cache->ints );
+  if ( NULL != cache->doubles ) free( cache->doubles );
+  if ( NULL != cache->hash ) free( cache->hash );
+  free( cache );
+}
+
+/* 64 bit FNV-1a */
+unsigned long long cache_hash( unsigned long long hash, 
+			       void *data, size_t bytes )
+{
+  unsigned char *byte = (unsigned char *)data;
+  size_t i;
+  for ( i = 0 ; i < bytes ; i++ )
+    {
+      hash ^= (unsigned long long)byte[i];
+      hash *= 1099511628211ULL;
+    }
+  return hash;
+}
+
+unsigned long long cache_hash_primal( unsigned long long hash, Primal primal )
+{
+  hash = cache_hash( hash, &(primal->nnode0), sizeof(int) );
+  hash = cache_hash( hash, &(primal->nnode), sizeof(int) );
+  hash = cache_hash( hash, &(primal->nface), sizeof(int) );
+  hash = cache_hash( hash, &(primal->ncell), sizeof(int) );
+  hash = cache_hash( hash, primal->xyz, 3*(size_t)primal->nnode*sizeof(double) );
+  hash = cache_hash( hash, primal->f2n, 4*(size_t)primal->nface*sizeof(int) );
+  hash = cache_hash( hash, primal->c2n, 4*(size_t)primal->ncell*sizeof(int) );
+  return hash;
+}
+
+/* the name of a file and its size and modification time, or its
+ * contents where stat is missing, so a file rewritten under the same
+ * name changes the hash */
+unsigned long long cache_hash_file( unsigned long long hash, char *filename )
+{
+#ifdef HAVE_SYS_STAT_H
+  struct stat info;
+  long long size, mtime;
+#else
+  FILE *file;
+  char block[4096];
+  size_t bytes;
+#endif
+
+  hash = cache_hash( hash, filename, strlen(filename)+1 );
+
+#ifdef HAVE_SYS_STAT_H
+  if ( 0 != stat( filename, &info ) ) return hash;
+  size = (long long)info.st_size;
+  mtime = (long long)info.st_mtime;
+  hash = cache_hash( hash, &size, sizeof(long long) );
+  hash = cache_hash( hash, &mtime, sizeof(long long) );
+#else
+  file = fopen( filename, "rb" );
+  if ( NULL == file ) return hash;
+  while ( 0 < ( bytes = fread( block, 1, sizeof(block), file ) ) )
+    hash = cache_hash( hash, block, bytes );
+  fclose( file );
+#endif
+
+  return hash;
+}
+
+KNIFE_STATUS cache_filename( char *directory, int partition, 
+			     unsigned long long key, char *filename )
+{
+  sprintf( filename, "%s/knife_cut_%05d_%016llx.cache", 
+	   directory, partition, key );
+  return KNIFE_SUCCESS;
+}
+
+#define cache_record_slot(kind,a,b,c,d,nhash)				\
+  ((int)(( ( (unsigned int)(kind) * 2654435761u ) ^			\
+	   ( (unsigned int)(a) * 2246822519u ) ^			\
+	   ( (unsigned int)(b) * 3266489917u ) ^			\
+	   ( (unsigned int)(c) * 668265263u ) ^				\
+	   ( (unsigned int)(d) * 374761393u ) ) & ((unsigned int)(nhash)-1)))
+
+#define cache_record_is(cache,record_index,kind,a,b,c,d)		\
+  ( (kind) == (cache)->record[0+CACHE_RECORD_SIZE*(record_index)] &&	\
+    (a) == (cache)->record[1+CACHE_RECORD_SIZE*(record_index)] &&	\
+    (b) == (cache)->record[2+CACHE_RECORD_SIZE*(record_index)] &&	\
+    (c) == (cache)->record[3+CACHE_RECORD_SIZE*(record_index)] &&	\
+    (d) == (cache)->record[4+CACHE_RECORD_SIZE*(record_index)] )
+
+static void cache_hash_record( Cache cache, int record )
+{
+  int *r;
+  int slot;
+
+  r = &(cache->record[CACHE_RECORD_SIZE*record]);
+  slot = cache_record_slot(r[0],r[1],r[2],r[3],r[4],cache->nhash);
+  while ( EMPTY != cache->hash[slot] ) slot = (slot+1) & (cache->nhash-1);
+  cache->hash[slot] = record;
+}
+
+static KNIFE_STATUS cache_rehash( Cache cache )
+{
+  int slot, record;
+
+  if ( NULL != cache->hash ) free( cache->hash );
+  cache->nhash = 16;
+  while ( cache->nhash < 4*cache->nrecord ) cache->nhash *= 2;
+  cache->hash = (int *) malloc( cache->nhash * sizeof(int) );
+  if (NULL == cache->hash) {
+    printf("%s: %d: malloc failed in cache_rehash\n",
+	   __FILE__,__LINE__);
+    cache->nhash = 0;
+    return KNIFE_MEMORY; 
+  }
+  for ( slot = 0 ; slot < cache->nhash ; slot++ ) cache->hash[slot] = EMPTY;
+  for ( record = 0 ; record < cache->nrecord ; record++ )
+    cache_hash_record( cache, record );
+
+  return KNIFE_SUCCESS;
+}
+
+int cache_find( Cache cache, int kind, int a, int b, int c, int d )
+{
+  int slot;
+
+  if ( NULL == cache || NULL == cache->hash ) return EMPTY;
+
+  slot = cache_record_slot(kind,a,b,c,d,cache->nhash);
+  while ( EMPTY != cache->hash[slot] )
+    {
+      if ( cache_record_is(cache,cache->hash[slot],kind,a,b,c,d) ) 
+	return cache->hash[slot];
+      slot = (slot+1) & (cache->nhash-1);
+    }
+
+  return EMPTY;
+}
+
+/* grow *data to hold at least needed items of size bytes */
+static KNIFE_STATUS cache_reserve( void **data, int *allocated, 
+				   int needed, size_t size )
+{
+  void *new_data;
+  int new_allocated;
+
+  if ( needed <= *allocated ) return KNIFE_SUCCESS;
+
+  new_allocated = MAX( 2*(*allocated), MAX( needed, 1024 ) );
+  new_data = realloc( *data, (size_t)new_allocated * size );
+  if (NULL == new_data) {
+    printf("%s: %d: realloc failed in cache_reserve\n",
+	   __FILE__,__LINE__);
+    return KNIFE_MEMORY;
+  }
+  *data = new_data;
+  *allocated = new_allocated;
+
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS cache_add( Cache cache, int kind, int a, int b, int c, int d,
+			KNIFE_STATUS status,
+			int nint, int *ints, int ndouble, double *doubles )
+{
+  int *r;
+
+  if ( EMPTY != cache_find( cache, kind, a, b, c, d ) ) return KNIFE_SUCCESS;
+
+  TRY( cache_reserve( (void **)&(cache->record), &(cache->nrecord_allocated),
+		      CACHE_RECORD_SIZE*(cache->nrecord+1), sizeof(int) ), 
+       "record" );
+  TRY( cache_reserve( (void **)&(cache->ints), &(cache->nint_allocated),
+		      cache->nint+nint, sizeof(int) ), "ints" );
+  TRY( cache_reserve( (void **)&(cache->doubles), 
+		      &(cache->ndouble_allocated),
+		      cache->ndouble+ndouble, sizeof(double) ), "doubles" );
+
+  r = &(cache->record[CACHE_RECORD_SIZE*cache->nrecord]);
+  r[0] = kind; r[1] = a; r[2] = b; r[3] = c; r[4] = d;
+  r[5] = status;
+  r[6] = cache->nint;
+  r[7] = nint;
+  r[8] = cache->ndouble;
+  r[9] = ndouble;
+  if ( nint > 0 ) 
+    memcpy( &(cache->ints[cache->nint]), ints, nint*sizeof(int) );
+  if ( ndouble > 0 ) 
+    memcpy( &(cache->doubles[cache->ndouble]), doubles, 
+	    ndouble*sizeof(double) );
+  cache->nint += nint;
+  cache->ndouble += ndouble;
+  cache->nrecord++;
+
+  /* keep the hash at most half full */
+  if ( 2*cache->nrecord > cache->nhash ) return cache_rehash( cache );
+  cache_hash_record( cache, cache->nrecord-1 );
+
+  return KNIFE_SUCCESS;
+}
+
+/* subtri of a poly region: 13 doubles (node0, node1, node2, normal as
+ * 3n blocks, then area) per subtri, and the sensitivity ints and
+ * doubles per subtri of each kind */
+#define CACHE_SUBTRI_DOUBLES (13)
+
+static KNIFE_STATUS cache_add_subtri( Cache cache, int kind, 
+				      int a, int b, int c, int d,
+				      KNIFE_STATUS status, int nsubtri,
+				      int ints_per_subtri,
+				      int doubles_per_subtri,
+				      int *ints, double *doubles )
+{
+  if ( KNIFE_SUCCESS != status ) nsubtri = 0;
+  return cache_add( cache, kind, a, b, c, d, status, 
+		    ints_per_subtri*nsubtri, ints, 
+		    doubles_per_subtri*nsubtri, doubles );
+}
+
+static KNIFE_STATUS cache_allocate( int nsubtri, int nint, int ndouble,
+				    int **ints, double **doubles )
+{
+  *ints = (int *)malloc( MAX(nint*nsubtri,1) * sizeof(int) );
+  *doubles = (double *)malloc( MAX(ndouble*nsubtri,1) * sizeof(double) );
+  if ( NULL == (*ints) || NULL == (*doubles) )
+    {
+      printf("%s: %d: malloc failed in cache_allocate\n",__FILE__,__LINE__);
+      if ( NULL != (*ints) ) free( *ints );
+      if ( NULL != (*doubles) ) free( *doubles );
+      return KNIFE_MEMORY;
+    }
+  return KNIFE_SUCCESS;
+}
+
+static KNIFE_STATUS cache_gather_surface( Cache cache, Poly poly, 
+					  int poly_index, int region,
+					  Surface surface )
+{
+  int nsubtri;
+  int *ints;
+  double *d;
+  KNIFE_STATUS status;
+
+  status = poly_surface_nsubtri( poly, region, &nsubtri );
+  if ( KNIFE_SUCCESS != status ) nsubtri = 0;
+
+  TRY( cache_allocate( nsubtri, 4, 27, &ints, &d ), "alloc" );
+
+  if ( KNIFE_SUCCESS == status )
+    status = poly_surface_subtri( poly, region, nsubtri, 
+				  &d[0], &d[3*nsubtri], &d[6*nsubtri], 
+				  &d[9*nsubtri], &d[12*nsubtri], ints );
+  TRY( cache_add_subtri( cache, CACHE_SURFACE, poly_index, region, 0, 0,
+			 status, nsubtri, 1, CACHE_SUBTRI_DOUBLES, 
+			 ints, d ), "surface" );
+
+  if ( KNIFE_SUCCESS == status )
+    status = poly_surface_sens( poly, region, nsubtri, ints, d, surface );
+  TRY( cache_add_subtri( cache, CACHE_SURFACE_SENS, poly_index, region, 0, 0,
+			 status, nsubtri, 4, 27, ints, d ), "surface sens" );
+
+  free( ints );
+  free( d );
+
+  return KNIFE_SUCCESS;
+}
+
+static KNIFE_STATUS cache_gather_boundary( Cache cache, Poly poly, 
+					   int poly_index, int face, 
+					   int region, Surface surface )
+{
+  int nsubtri;
+  int *ints;
+  double *d;
+  KNIFE_STATUS status;
+
+  status = poly_boundary_nsubtri( poly, face, region, &nsubtri );
+  if ( KNIFE_SUCCESS != status ) nsubtri = 0;
+
+  TRY( cache_allocate( nsubtri, 9, CACHE_SUBTRI_DOUBLES, &ints, &d ), 
+       "alloc" );
+
+  if ( KNIFE_SUCCESS == status )
+    status = poly_boundary_subtri( poly, face, region, nsubtri, 
+				   &d[0], &d[3*nsubtri], &d[6*nsubtri], 
+				   &d[9*nsubtri], &d[12*nsubtri] );
+  TRY( cache_add_subtri( cache, CACHE_BOUNDARY, poly_index, region, face, 0,
+			 status, nsubtri, 0, CACHE_SUBTRI_DOUBLES, 
+			 ints, d ), "boundary" );
+
+  if ( KNIFE_SUCCESS == status )
+    status = poly_boundary_sens( poly, face, region, nsubtri, 
+				 ints, d, surface );
+  TRY( cache_add_subtri( cache, CACHE_BOUNDARY_SENS, 
+			 poly_index, region, face, 0,
+			 status, nsubtri, 9, 9, ints, d ), "boundary sens" );
+
+  free( ints );
+  free( d );
+
+  return KNIFE_SUCCESS;
+}
+
+static KNIFE_STATUS cache_gather_between( Cache cache, 
+					  Poly poly1, int poly_index1, 
+					  int region1, 
+					  Poly poly2, int poly_index2, 
+					  int region2,
+					  Node node, Surface surface )
+{
+  int nsubtri;
+  int *ints;
+  double *d;
+  KNIFE_STATUS status;
+
+  if ( EMPTY != cache_find( cache, CACHE_BETWEEN, poly_index1, region1,
+			    poly_index2, region2 ) ) return KNIFE_SUCCESS;
+
+  status = poly_nsubtri_between( poly1, region1, poly2, region2, 
+				 node, &nsubtri );
+  if ( KNIFE_SUCCESS != status ) nsubtri = 0;
+
+  TRY( cache_allocate( nsubtri, 9, CACHE_SUBTRI_DOUBLES, &ints, &d ), 
+       "alloc" );
+
+  if ( KNIFE_SUCCESS == status )
+    status = poly_subtri_between( poly1, region1, poly2, region2, 
+				  node, nsubtri, 
+				  &d[0], &d[3*nsubtri], &d[6*nsubtri], 
+				  &d[9*nsubtri], &d[12*nsubtri] );
+  TRY( cache_add_subtri( cache, CACHE_BETWEEN, 
+			 poly_index1, region1, poly_index2, region2,
+			 status, nsubtri, 0, CACHE_SUBTRI_DOUBLES, 
+			 ints, d ), "between" );
+
+  if ( KNIFE_SUCCESS == status )
+    status = poly_between_sens( poly1, region1, poly2, region2,
+				node, nsubtri, ints, d, surface );
+  TRY( cache_add_subtri( cache, CACHE_BETWEEN_SENS, 
+			 poly_index1, region1, poly_index2, region2,
+			 status, nsubtri, 9, 9, ints, d ), "between sens" );
+
+  free( ints );
+  free( d );
+
+  return KNIFE_SUCCESS;
+}
+
+static KNIFE_STATUS cache_gather_poly( Cache cache, Domain domain, 
+				       int poly_index )
+{
+  Primal primal;
+  Surface surface;
+  Poly poly, other;
+  int regions, other_regions;
+  int region, other_region;
+  double xyz[3], center[4];
+  KNIFE_STATUS status;
+  AdjIterator it;
+  int cell, cell_edge, edge, edge_nodes[2], other_index;
+  Node node;
+
+  primal = domain_primal(domain);
+  surface = domain_surface(domain);
+  poly = domain_poly(domain,poly_index);
+  NOT_NULL( poly, "cut poly NULL" );
+
+  status = poly_regions( poly, &regions );
+  TRY( cache_add( cache, CACHE_REGIONS, poly_index, 0, 0, 0, status,
+		  1, &regions, 0, NULL ), "regions" );
+  if ( KNIFE_SUCCESS != status ) return KNIFE_SUCCESS;
+
+  for ( region = 1 ; region <= regions ; region++ )
+    {
+      TRY( primal_xyz( primal, poly_index, xyz ), "primal_xyz" );
+      center[0] = xyz[0];
+      center[1] = xyz[1];
+      center[2] = xyz[2];
+      status = poly_centroid_volume( poly, region, xyz, center, &center[3] );
+      TRY( cache_add( cache, CACHE_CENTROID_VOLUME, poly_index, region, 0, 0,
+		      status, 0, NULL, 4, center ), "centroid volume" );
+
+      TRY( cache_gather_surface( cache, poly, poly_index, region, surface ),
+	   "surface" );
+
+      for ( it = adj_first(primal_face_adj(primal), poly_index);
+	    adj_valid(it);
+	    it = adj_next(it) )
+	TRY( cache_gather_boundary( cache, poly, poly_index, adj_item(it), 
+				    region, surface ), "boundary" );
+    }
+
+  for ( it = adj_first(primal_cell_adj(primal), poly_index);
+	adj_valid(it);
+	it = adj_next(it) )
+    {
+      cell = adj_item(it);
+      for ( cell_edge = 0 ; cell_edge < 6 ; cell_edge++ )
+	{
+	  edge = primal_c2e(primal,cell,cell_edge);
+	  TRY( primal_edge( primal, edge, edge_nodes ), "primal_edge" );
+	  if ( poly_index != edge_nodes[0] && poly_index != edge_nodes[1] )
+	    continue;
+	  other_index = ( poly_index == edge_nodes[0] ? 
+			  edge_nodes[1] : edge_nodes[0] );
+	  if ( NULL == domain_poly( domain, other_index ) )
+	    TRY( domain_add_interior_poly( domain, other_index ), 
+		 "add interior other" );
+	  other = domain_poly( domain, other_index );
+	  NOT_NULL( other, "other poly NULL" );
+	  node = domain_node_at_edge_center( domain, edge );
+	  NOT_NULL( node, "edge node NULL" );
+	  TRY( poly_regions( other, &other_regions ), "other regions" );
+	  for ( region = 1 ; region <= regions ; region++ )
+	    for ( other_region = 1 ; 
+		  other_region <= other_regions ; 
+		  other_region++ )
+	      {
+		TRY( cache_gather_between( cache, 
+					   poly, poly_index, region,
+					   other, other_index, other_region,
+					   node, surface ), "between" );
+		TRY( cache_gather_between( cache, 
+					   other, other_index, other_region,
+					   poly, poly_index, region,
+					   node, surface ), "between" );
+	      }
+	}
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS cache_gather( Cache cache, Domain domain )
+{
+  int poly_index;
+
+  NOT_NULL( cache, "cache NULL" );
+  NOT_NULL( domain, "domain NULL" );
+
+  if ( NULL != cache->topo ) free( cache->topo );
+  cache->npoly = domain_npoly(domain);
+  cache->topo = (int *)malloc( MAX(cache->npoly,1) * sizeof(int) );
+  NOT_NULL( cache->topo, "cache topo NULL" );
+  for ( poly_index = 0 ; poly_index < cache->npoly ; poly_index++ )
+    cache->topo[poly_index] = domain_topo(domain,poly_index);
+
+  for ( poly_index = 0 ; poly_index < cache->npoly ; poly_index++ )
+    if ( domain_cut(domain,poly_index) )
+      TRY( cache_gather_poly( cache, domain, poly_index ), "gather poly" );
+
+  return KNIFE_SUCCESS;
+}
+
+/* stands in for domain_set_dual_topology when the cut is not repeated */
+KNIFE_STATUS cache_restore_topo( Cache cache, Domain domain )
+{
+  int poly_index;
+
+  NOT_NULL( cache, "cache NULL" );
+  NOT_NULL( domain, "domain NULL" );
+
+  if ( cache->npoly != domain_npoly(domain) )
+    {
+      printf("%s: %d: cache has %d polys, domain %d\n",
+	     __FILE__,__LINE__,cache->npoly,domain_npoly(domain));
+      return KNIFE_INCONSISTENT;
+    }
+
+  if ( NULL != domain->topo ) free( domain->topo );
+  domain->topo = (POLY_TOPO *)malloc( MAX(domain_npoly(domain),1) * 
+				      sizeof(POLY_TOPO) );
+  NOT_NULL( domain->topo, "domain->topo NULL" );
+  for ( poly_index = 0 ; poly_index < domain_npoly(domain) ; poly_index++ )
+    domain->topo[poly_index] = cache->topo[poly_index];
+
+  return KNIFE_SUCCESS;
+}
+
+/* magic, CACHE_NHEADER ints (version, byte order, counts), the key,
+ * then topo, records, ints and doubles as whole blocks.  Written to a
+ * temporary name and renamed so a reader never sees a partial file */
+KNIFE_STATUS cache_export( Cache cache, char *filename )
+{
+  FILE *f;
+  char temporary[1100];
+  int header[CACHE_NHEADER];
+  KnifeBool ok;
+
+  NOT_NULL( cache, "cache NULL" );
+
+  memset( header, 0, CACHE_NHEADER*sizeof(int) );
+  header[0] = CACHE_VERSION;
+  header[1] = 1;
+  header[2] = cache->npoly;
+  header[3] = cache->nrecord;
+  header[4] = cache->nint;
+  header[5] = cache->ndouble;
+
+  sprintf( temporary, "%.1024s.tmp", filename );
+  f = fopen( temporary, "wb" );
+  if ( NULL == f )
+    {
+      printf("%s: %d: unable to write cache %s\n",__FILE__,__LINE__,temporary);
+      return KNIFE_FILE_ERROR;
+    }
+
+  ok = (KnifeBool)
+    ( 1 == fwrite( CACHE_MAGIC, 8, 1, f ) &&
+      1 == fwrite( header, CACHE_NHEADER*sizeof(int), 1, f ) &&
+      1 == fwrite( &(cache->key), sizeof(unsigned long long), 1, f ) &&
+      (size_t)cache->npoly == 
+      fwrite( cache->topo, sizeof(int), cache->npoly, f ) &&
+      (size_t)(CACHE_RECORD_SIZE*cache->nrecord) == 
+      fwrite( cache->record, sizeof(int), CACHE_RECORD_SIZE*cache->nrecord, f ) &&
+      (size_t)cache->nint == 
+      fwrite( cache->ints, sizeof(int), cache->nint, f ) &&
+      (size_t)cache->ndouble == 
+      fwrite( cache->doubles, sizeof(double), cache->ndouble, f ) );
+  if ( 0 != fclose( f ) ) ok = FALSE;
+
+  if ( !ok || 0 != rename( temporary, filename ) )
+    {
+      printf("%s: %d: unable to write cache %s\n",__FILE__,__LINE__,filename);
+      remove( temporary );
+      return KNIFE_FILE_ERROR;
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+/* records of a read cache must stay inside its ints and doubles */
+static KnifeBool cache_records_valid( Cache cache )
+{
+  int record;
+  int *r;
+
+  for ( record = 0 ; record < cache->nrecord ; record++ )
+    {
+      r = &(cache->record[CACHE_RECORD_SIZE*record]);
+      if ( r[0] < 0 || r[0] >= CACHE_NKIND ||
+	   r[6] < 0 || r[7] < 0 || r[6] > cache->nint - r[7] ||
+	   r[8] < 0 || r[9] < 0 || r[8] > cache->ndouble - r[9] )
+	return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* NULL when there is no usable cache for key in filename */
+Cache cache_from_file( char *filename, unsigned long long key )
+{
+  FILE *f;
+  Cache cache;
+  char magic[8];
+  int header[CACHE_NHEADER];
+  unsigned long long file_key;
+  KnifeBool ok;
+
+  f = fopen( filename, "rb" );
+  if ( NULL == f ) return NULL;
+
+  if ( 1 != fread( magic, 8, 1, f ) ||
+       0 != memcmp( magic, CACHE_MAGIC, 8 ) ||
+       1 != fread( header, CACHE_NHEADER*sizeof(int), 1, f ) ||
+       1 != fread( &file_key, sizeof(unsigned long long), 1, f ) ||
+       CACHE_VERSION != header[0] || 1 != header[1] || key != file_key ||
+       header[2] < 0 || header[3] < 0 || header[4] < 0 || header[5] < 0 )
+    {
+      printf("%s: %d: ignoring stale or foreign cache %s\n",
+	     __FILE__,__LINE__,filename);
+      fclose( f );
+      return NULL;
+    }
+
+  cache = cache_create( );
+  if ( NULL == cache ) 
+    {
+      fclose( f );
+      return NULL;
+    }
+  cache->key = key;
+  cache->npoly = header[2];
+  cache->nrecord = cache->nrecord_allocated = header[3];
+  cache->nint = cache->nint_allocated = header[4];
+  cache->ndouble = cache->ndouble_allocated = header[5];
+  cache->topo = (int *)malloc( MAX(cache->npoly,1)*sizeof(int) );
+  cache->record = (int *)malloc( MAX(CACHE_RECORD_SIZE*cache->nrecord,1)*
+				 sizeof(int) );
+  cache->ints = (int *)malloc( MAX(cache->nint,1)*sizeof(int) );
+  cache->doubles = (double *)malloc( MAX(cache->ndouble,1)*sizeof(double) );
+
+  ok = (KnifeBool)
+    ( NULL != cache->topo && NULL != cache->record && 
+      NULL != cache->ints && NULL != cache->doubles &&
+      (size_t)cache->npoly == 
+      fread( cache->topo, sizeof(int), cache->npoly, f ) &&
+      (size_t)(CACHE_RECORD_SIZE*cache->nrecord) == 
+      fread( cache->record, sizeof(int), CACHE_RECORD_SIZE*cache->nrecord, f ) &&
+      (size_t)cache->nint == 
+      fread( cache->ints, sizeof(int), cache->nint, f ) &&
+      (size_t)cache->ndouble == 
+      fread( cache->doubles, sizeof(double), cache->ndouble, f ) );
+  fclose( f );
+  if ( ok ) ok = cache_records_valid( cache );
+  if ( ok ) ok = (KnifeBool)( KNIFE_SUCCESS == cache_rehash( cache ) );
+
+  if ( !ok )
+    {
+      printf("%s: %d: unable to read cache %s\n",__FILE__,__LINE__,filename);
+      cache_free( cache );
+      return NULL;
+    }
+
+  return cache;
+}
@@ -0,0 +1,114 @@
+/* persistent cut results of one partition, keyed on its inputs */
+
+/* Copyright 2007 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space
+ * Administration. No copyright is claimed in the United States under
+ * Title 17, U.S. Code.  All Other Rights Reserved.
+ *
+ * The knife platform is licensed under the Apache License, Version
+ * 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "knife_definitions.h"
+
+BEGIN_C_DECLORATION
+typedef struct CacheStruct CacheStruct;
+typedef CacheStruct * Cache;
+END_C_DECLORATION
+
+#include "primal.h"
+#include "domain.h"
+
+BEGIN_C_DECLORATION
+
+/* answers of the fortran API queries about cut polys, recorded after
+ * domain_boolean_subtract so a run with the same inputs can replay them
+ * instead of cutting.  Each record is found by its kind and up to four
+ * ints (node, region, other node or face, other region), keeps the
+ * status the query returned and its int and double output arrays */
+
+#define CACHE_REGIONS         (0)
+#define CACHE_CENTROID_VOLUME (1)
+#define CACHE_SURFACE         (2)
+#define CACHE_SURFACE_SENS    (3)
+#define CACHE_BOUNDARY        (4)
+#define CACHE_BOUNDARY_SENS   (5)
+#define CACHE_BETWEEN         (6)
+#define CACHE_BETWEEN_SENS    (7)
+#define CACHE_NKIND           (8)
+
+/* kind, four keys, status, int offset, nint, double offset, ndouble */
+#define CACHE_RECORD_SIZE (10)
+
+struct CacheStruct {
+  unsigned long long key;
+
+  int npoly;
+  int *topo;
+
+  int nrecord, nrecord_allocated;
+  int *record;
+
+  int nint, nint_allocated;
+  int *ints;
+
+  int ndouble, ndouble_allocated;
+  double *doubles;
+
+  int nhash;
+  int *hash;
+};
+
+Cache cache_create( void );
+void cache_free( Cache );
+
+unsigned long long cache_hash( unsigned long long hash, 
+			       void *data, size_t bytes );
+#define CACHE_HASH_START (14695981039346656037ULL)
+unsigned long long cache_hash_primal( unsigned long long hash, Primal );
+unsigned long long cache_hash_file( unsigned long long hash, char *filename );
+
+KNIFE_STATUS cache_filename( char *directory, int partition, 
+			     unsigned long long key, char *filename );
+
+KNIFE_STATUS cache_add( Cache, int kind, int a, int b, int c, int d,
+			KNIFE_STATUS status,
+			int nint, int *ints, int ndouble, double *doubles );
+int cache_find( Cache, int kind, int a, int b, int c, int d );
+
+#define cache_status(cache,record_index) \
+  ((cache)->record[5+CACHE_RECORD_SIZE*(record_index)])
+#define cache_nint(cache,record_index) \
+  ((cache)->record[7+CACHE_RECORD_SIZE*(record_index)])
+#define cache_ints(cache,record_index) \
+  (&((cache)->ints[(cache)->record[6+CACHE_RECORD_SIZE*(record_index)]]))
+#define cache_ndouble(cache,record_index) \
+  ((cache)->record[9+CACHE_RECORD_SIZE*(record_index)])
+#define cache_doubles(cache,record_index) \
+  (&((cache)->doubles[(cache)->record[8+CACHE_RECORD_SIZE*(record_index)]]))
+
+#define cache_topo(cache,poly_index) \
+  ( ((poly_index) < 0 || (poly_index) >= (cache)->npoly ) ? \
+    POLY_EXTERIOR : (cache)->topo[(poly_index)] )
+#define cache_cut(cache,poly_index) \
+  (POLY_CUT == cache_topo(cache,poly_index))
+
+KNIFE_STATUS cache_gather( Cache, Domain );
+KNIFE_STATUS cache_restore_topo( Cache, Domain );
+
+KNIFE_STATUS cache_export( Cache, char *filename );
+Cache cache_from_file( char *filename, unsigned long long key );
+
+END_C_DECLORATION
+
+#endif /* CACHE_H */
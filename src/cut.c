@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "cut.h"
+#include "profile.h"
 
 #define TRY(fcn,msg)					      \
   {							      \
@@ -48,6 +49,8 @@ KNIFE_STATUS cut_establish_between( Triangle triangle0, Triangle triangle1 )
 
   if ( NULL == triangle0 || NULL == triangle1 ) return KNIFE_NULL;
 
+  profile_count( PROFILE_CANDIDATE, 1 );
+
   intersection  = NULL;
   intersection0 = NULL;
   intersection1 = NULL;
@@ -97,11 +100,26 @@ KNIFE_STATUS cut_establish_between( Triangle triangle0, Triangle triangle1 )
 
       cut->intersection0 = intersection0;
       cut->intersection1 = intersection1;
+
+      profile_count( PROFILE_CUT, 1 );
     }
 
   return KNIFE_SUCCESS; 
 }
 
+/* take the cut out of both of its triangles and free it */
+KNIFE_STATUS cut_remove( Cut cut )
+{
+  if ( NULL == cut ) return KNIFE_NULL;
+
+  TRY( array_remove( cut->triangle0->cut, (ArrayItem)cut ), "remove tri0");
+  TRY( array_remove( cut->triangle1->cut, (ArrayItem)cut ), "remove tri1");
+
+  cut_free( cut );
+
+  return KNIFE_SUCCESS;
+}
+
 void cut_free( Cut cut )
 {
   if ( NULL == cut ) return;
@@ -39,6 +39,7 @@ struct CutStruct {
 };
 
 KNIFE_STATUS cut_establish_between( Triangle, Triangle );
+KNIFE_STATUS cut_remove( Cut );
 void cut_free( Cut );
 
 #define cut_other_triangle(cut,triangle)				\
@@ -24,9 +24,17 @@
 #include "cut.h"
 #include "near.h"
 #include "logger.h"
+#include "profile.h"
 
 #define DOMAIN_LOGGER_LEVEL (0)
 
+/* a named step of the cut pipeline, logged and profiled */
+static void domain_phase( char *name )
+{
+  logger_message( DOMAIN_LOGGER_LEVEL, name );
+  profile_phase( name );
+}
+
 #define TRY(fcn,msg)					      \
   {							      \
     KNIFE_STATUS code;					      \
@@ -70,55 +78,83 @@ Domain domain_create( Primal primal, Surface surface)
   domain->surface = surface;
 
   domain->nnode = EMPTY;
-  domain->node = NULL;
+  domain->node_remap = NULL;
+  domain->nnode_used = 0;
+  domain->nnode_block = 0;
+  domain->node_block = NULL;
 
   domain->nsegment = EMPTY;
-  domain->segment = NULL;
+  domain->segment_remap = NULL;
+  domain->nsegment_used = 0;
+  domain->nsegment_block = 0;
+  domain->segment_block = NULL;
 
   domain->ntriangle = EMPTY;
-  domain->triangle = NULL;
+  domain->triangle_remap = NULL;
+  domain->ntriangle_used = 0;
+  domain->ntriangle_block = 0;
+  domain->triangle_block = NULL;
 
   domain->npoly = EMPTY;
   domain->poly = NULL;
 
   domain->topo = NULL;
+  domain->topo_method = DOMAIN_TOPO_FLOOD;
 
   domain->nside = EMPTY;
   domain->f2s = NULL;
   domain->s2fs = NULL;
 
+  domain->edge_near = NULL;
+
+  domain->t2e = NULL;
+  domain->f2t = NULL;
+
   return domain;
 }
 
-void domain_free( Domain domain )
+/* dual elements with their cuts and the polys made of them */
+static void domain_release_dual( Domain domain )
 {
   int i;
-  if ( NULL == domain ) return;
 
   /* FIXME find a consistant way to free cuts and intersections */
   /* segments have list of intersections */
   /* triangles have list of cuts */
 
-  if ( NULL != domain->node )
-    {
-      for ( i = 0 ; i < domain->nnode ; i++ ) 
-	node_free(domain->node[i]);
-      free( domain->node );
-    }
-
-  if ( NULL != domain->segment )
-    {
-      for ( i = 0 ; i < domain->nsegment ; i++ ) 
-	segment_free(domain->segment[i]);
-      free( domain->segment );
-    }
-
-  if ( NULL != domain->triangle )
-    {
-      for ( i = 0 ; i < domain->ntriangle ; i++ ) 
-	triangle_free(domain->triangle[i]);
-      free( domain->triangle );
-    }
+  if ( NULL != domain->node_remap ) free( domain->node_remap );
+  for ( i = 0 ; i < domain->nnode_block ; i++ ) 
+    free( domain->node_block[i] );
+  if ( NULL != domain->node_block ) free( domain->node_block );
+  domain->nnode = EMPTY;
+  domain->node_remap = NULL;
+  domain->nnode_used = 0;
+  domain->nnode_block = 0;
+  domain->node_block = NULL;
+
+  for ( i = 0 ; i < domain->nsegment_used ; i++ ) 
+    segment_release( domain_used_segment(domain,i) );
+  if ( NULL != domain->segment_remap ) free( domain->segment_remap );
+  for ( i = 0 ; i < domain->nsegment_block ; i++ ) 
+    free( domain->segment_block[i] );
+  if ( NULL != domain->segment_block ) free( domain->segment_block );
+  domain->nsegment = EMPTY;
+  domain->segment_remap = NULL;
+  domain->nsegment_used = 0;
+  domain->nsegment_block = 0;
+  domain->segment_block = NULL;
+
+  for ( i = 0 ; i < domain->ntriangle_used ; i++ ) 
+    triangle_release( domain_used_triangle(domain,i) );
+  if ( NULL != domain->triangle_remap ) free( domain->triangle_remap );
+  for ( i = 0 ; i < domain->ntriangle_block ; i++ ) 
+    free( domain->triangle_block[i] );
+  if ( NULL != domain->triangle_block ) free( domain->triangle_block );
+  domain->ntriangle = EMPTY;
+  domain->triangle_remap = NULL;
+  domain->ntriangle_used = 0;
+  domain->ntriangle_block = 0;
+  domain->triangle_block = NULL;
 
   if ( NULL != domain->poly )
     {
@@ -126,15 +162,134 @@ void domain_free( Domain domain )
 	poly_free(domain->poly[i]);
       free( domain->poly );
     }
+  domain->poly = NULL;
+}
+
+void domain_free( Domain domain )
+{
+  if ( NULL == domain ) return;
+
+  domain_release_dual( domain );
 
   if ( NULL != domain->topo ) free( domain->topo );
   
   if ( NULL != domain->f2s )  free( domain->f2s );
   if ( NULL != domain->s2fs ) free( domain->s2fs );
 
+  if ( NULL != domain->edge_near ) free( domain->edge_near );
+
+  if ( NULL != domain->t2e ) free( domain->t2e );
+  if ( NULL != domain->f2t ) free( domain->f2t );
+
   free(domain);
 }
 
+KNIFE_STATUS domain_reset( Domain domain, Surface surface )
+{
+  NOT_NULL( domain, "domain NULL" );
+  NOT_NULL( surface, "surface NULL" );
+
+  domain_release_dual( domain );
+  domain->surface = surface;
+
+  /* the surface moved, the next required scan finds the near edges */
+  if ( NULL != domain->edge_near ) free( domain->edge_near );
+  domain->edge_near = NULL;
+
+  return KNIFE_SUCCESS;
+}
+
+static Node domain_store_node( Domain domain, int node_index, 
+			       double *xyz )
+{
+  Node node;
+
+  if ( domain->nnode_used == DOMAIN_BLOCK_SIZE*domain->nnode_block )
+    {
+      domain->node_block = (NodeStruct **)
+	realloc( domain->node_block, 
+		 (domain->nnode_block+1) * sizeof(NodeStruct *) );
+      NOT_NULLN(domain->node_block,"realloc node_block NULL");
+      domain->node_block[domain->nnode_block] = (NodeStruct *)
+	malloc( DOMAIN_BLOCK_SIZE * sizeof(NodeStruct) );
+      NOT_NULLN(domain->node_block[domain->nnode_block],"malloc node block");
+      domain->nnode_block++;
+    }
+
+  node = domain_used_node(domain,domain->nnode_used);
+  TRYN( node_initialize( node, xyz ), "node_initialize" );
+
+  domain->node_remap[node_index] = domain->nnode_used;
+  domain->nnode_used++;
+
+  return node;
+}
+
+static Segment domain_store_segment( Domain domain, int segment_index, 
+				     Node node0, Node node1 )
+{
+  Segment segment;
+
+  NOT_NULLN(node0,"node0 NULL in domain_store_segment");
+  NOT_NULLN(node1,"node1 NULL in domain_store_segment");
+
+  if ( domain->nsegment_used == DOMAIN_BLOCK_SIZE*domain->nsegment_block )
+    {
+      domain->segment_block = (SegmentStruct **)
+	realloc( domain->segment_block, 
+		 (domain->nsegment_block+1) * sizeof(SegmentStruct *) );
+      NOT_NULLN(domain->segment_block,"realloc segment_block NULL");
+      domain->segment_block[domain->nsegment_block] = (SegmentStruct *)
+	malloc( DOMAIN_BLOCK_SIZE * sizeof(SegmentStruct) );
+      NOT_NULLN(domain->segment_block[domain->nsegment_block],
+		"malloc segment block");
+      domain->nsegment_block++;
+    }
+
+  segment = domain_used_segment(domain,domain->nsegment_used);
+  TRYN( segment_initialize( segment, node0, node1 ), "segment_initialize" );
+
+  domain->segment_remap[segment_index] = domain->nsegment_used;
+  domain->nsegment_used++;
+
+  return segment;
+}
+
+static Triangle domain_store_triangle( Domain domain, int triangle_index, 
+				       Segment segment0, 
+				       Segment segment1, 
+				       Segment segment2,
+				       int boundary_face_index )
+{
+  Triangle triangle;
+
+  NOT_NULLN(segment0,"segment0 NULL in domain_store_triangle");
+  NOT_NULLN(segment1,"segment1 NULL in domain_store_triangle");
+  NOT_NULLN(segment2,"segment2 NULL in domain_store_triangle");
+
+  if ( domain->ntriangle_used == DOMAIN_BLOCK_SIZE*domain->ntriangle_block )
+    {
+      domain->triangle_block = (TriangleStruct **)
+	realloc( domain->triangle_block, 
+		 (domain->ntriangle_block+1) * sizeof(TriangleStruct *) );
+      NOT_NULLN(domain->triangle_block,"realloc triangle_block NULL");
+      domain->triangle_block[domain->ntriangle_block] = (TriangleStruct *)
+	malloc( DOMAIN_BLOCK_SIZE * sizeof(TriangleStruct) );
+      NOT_NULLN(domain->triangle_block[domain->ntriangle_block],
+		"malloc triangle block");
+      domain->ntriangle_block++;
+    }
+
+  triangle = domain_used_triangle(domain,domain->ntriangle_used);
+  TRYN( triangle_initialize( triangle, segment0, segment1, segment2, 
+			     boundary_face_index ), "triangle_initialize" );
+
+  domain->triangle_remap[triangle_index] = domain->ntriangle_used;
+  domain->ntriangle_used++;
+
+  return triangle;
+}
+
 Node domain_node( Domain domain, int node_index )
 {
   int cell, tri, edge;
@@ -148,24 +303,20 @@ Node domain_node( Domain domain, int node_index )
       return NULL;
     }
 
-  if (NULL == domain->node[node_index])
+  if (EMPTY == domain->node_remap[node_index])
     {
       if ( node_index < primal_ncell(domain->primal) )
 	{
 	  cell = node_index;
 	  TRYN( primal_cell_center( domain->primal, cell, xyz), "cell center" );
-	  domain->node[node_index] = node_create( xyz );
-	  NOT_NULLN(domain->node[node_index],"node_create NULL");
-	  return domain->node[node_index];
+	  return domain_store_node( domain, node_index, xyz );
 	}
       if ( node_index < primal_ncell(domain->primal) 
 	              + primal_ntri(domain->primal) )
 	{
 	  tri = node_index - primal_ncell(domain->primal);
 	  TRYN( primal_tri_center( domain->primal, tri, xyz), "tri center" );
-	  domain->node[node_index] = node_create( xyz );
-	  NOT_NULLN(domain->node[node_index],"node_create NULL");
-	  return domain->node[node_index];
+	  return domain_store_node( domain, node_index, xyz );
 	}
       if ( node_index < primal_ncell(domain->primal) 
 	              + primal_ntri(domain->primal) 
@@ -174,9 +325,7 @@ Node domain_node( Domain domain, int node_index )
 	  edge = node_index - primal_ncell(domain->primal) 
 	                    - primal_ntri(domain->primal);
 	  TRYN( primal_edge_center( domain->primal, edge, xyz), "edge center" );
-	  domain->node[node_index] = node_create( xyz );
-	  NOT_NULLN(domain->node[node_index],"node_create NULL");
-	  return domain->node[node_index];
+	  return domain_store_node( domain, node_index, xyz );
 	}
       if ( node_index < primal_ncell(domain->primal) 
 	              + primal_ntri(domain->primal) 
@@ -188,16 +337,14 @@ Node domain_node( Domain domain, int node_index )
                                     - primal_nedge(domain->primal);
 	  volume_node = primal_surface_volume_node(domain->primal,surface_node);
 	  TRYN( primal_xyz(domain->primal,volume_node,xyz), "surf node xyz");
-	  domain->node[node_index] = node_create( xyz );
-	  NOT_NULLN(domain->node[node_index],"node_create NULL");
-	  return domain->node[node_index];
+	  return domain_store_node( domain, node_index, xyz );
 	}
       printf("%s: %d: array bound error %d\n",
 	     __FILE__,__LINE__, node_index);
       return NULL;
     }
 
-  return domain->node[node_index];
+  return domain_used_node(domain,domain->node_remap[node_index]);
 }
 
 Node domain_node_at_edge_center( Domain domain, int edge_index )
@@ -222,6 +369,7 @@ Segment domain_segment( Domain domain, int segment_index )
   int tri_nodes[3];
   int face, node, face_nodes[4], node_index;
   int face_side, node0, node1;
+  int tri_side;
 
   if ( 0 > segment_index || domain_nsegment(domain) <= segment_index ) 
     {
@@ -230,7 +378,7 @@ Segment domain_segment( Domain domain, int segment_index )
       return NULL;
     }
 
-  if (NULL == domain->segment[segment_index])
+  if (EMPTY == domain->segment_remap[segment_index])
     {
       if ( segment_index < 10*primal_ncell(domain->primal) )
 	{
@@ -241,10 +389,9 @@ Segment domain_segment( Domain domain, int segment_index )
 	    {
 	      tri = primal_c2t(domain->primal,cell,side);
 	      tri_center = tri + primal_ncell(domain->primal);
-	      domain->segment[segment_index] = 
-		segment_create( domain_node(domain,cell_center),
-				domain_node(domain,tri_center));
-		NOT_NULLN(domain->segment[segment_index],"segment_create NULL");
+	      return domain_store_segment( domain, segment_index,
+					   domain_node(domain,cell_center),
+					   domain_node(domain,tri_center) );
 	    }
 	  else
 	    {
@@ -252,12 +399,10 @@ Segment domain_segment( Domain domain, int segment_index )
 	      edge_index = primal_c2e(domain->primal,cell,edge);
 	      edge_center = edge_index + primal_ntri(domain->primal) 
 		                       + primal_ncell(domain->primal);
-	      domain->segment[segment_index] = 
-		segment_create( domain_node(domain,cell_center),
-				domain_node(domain,edge_center) );
-	      NOT_NULLN(domain->segment[segment_index],"segment_create NULL");
+	      return domain_store_segment( domain, segment_index,
+					   domain_node(domain,cell_center),
+					   domain_node(domain,edge_center) );
 	    }
-	  return domain->segment[segment_index];
 	}
       if ( segment_index < 10*primal_ncell(domain->primal) 
 	                 +  3*primal_ntri(domain->primal) )
@@ -266,18 +411,23 @@ Segment domain_segment( Domain domain, int segment_index )
 	  tri_center = tri + primal_ncell(domain->primal);
 	  TRYN( primal_tri(domain->primal,tri,tri_nodes), "primal_tri" );
 	  side = segment_index - 3*tri - 10 * primal_ncell(domain->primal);
-	  TRYN( primal_find_edge( domain->primal, 
-				  tri_nodes[primal_face_side_node0(side)], 
-				  tri_nodes[primal_face_side_node1(side)], 
-				  &edge_index ), "tri seg find edge" );
+	  if ( NULL != domain->t2e && EMPTY != domain->t2e[side+3*tri] )
+	    {
+	      edge_index = domain->t2e[side+3*tri];
+	    }
+	  else
+	    {
+	      TRYN( primal_find_edge( domain->primal, 
+				      tri_nodes[primal_face_side_node0(side)], 
+				      tri_nodes[primal_face_side_node1(side)], 
+				      &edge_index ), "tri seg find edge" );
+	    }
 	  edge_center = edge_index + primal_ntri(domain->primal) 
 	                           + primal_ncell(domain->primal);
 
-	  domain->segment[segment_index] = 
-	    segment_create( domain_node(domain,tri_center),
-			    domain_node(domain,edge_center) );
-	  NOT_NULLN(domain->segment[segment_index],"segment_create NULL");
-	  return domain->segment[segment_index];
+	  return domain_store_segment( domain, segment_index,
+				       domain_node(domain,tri_center),
+				       domain_node(domain,edge_center) );
 	}
       if ( segment_index < 10*primal_ncell(domain->primal) 
 	                 +  3*primal_ntri(domain->primal) 
@@ -289,20 +439,25 @@ Segment domain_segment( Domain domain, int segment_index )
                                - 3  * primal_ntri(domain->primal)
                                - 10 * primal_ncell(domain->primal); 
 	  primal_face(domain->primal, face, face_nodes);
-	  TRYN( primal_find_tri( domain->primal, 
-				 face_nodes[0], face_nodes[1], face_nodes[2],
-				 &tri ), "find tri for face" );
+	  if ( NULL != domain->f2t && EMPTY != domain->f2t[face] )
+	    {
+	      tri = domain->f2t[face];
+	    }
+	  else
+	    {
+	      TRYN( primal_find_tri( domain->primal, 
+				     face_nodes[0], face_nodes[1], face_nodes[2],
+				     &tri ), "find tri for face" );
+	    }
 	  tri_center = tri + primal_ncell(domain->primal);;
 	  node_index =
 	    primal_surface_node(domain->primal,face_nodes[node]) + 
 	    primal_nedge(domain->primal) + 
 	    primal_ntri(domain->primal) + 
 	    primal_ncell(domain->primal);
-	  domain->segment[segment_index] = 
-	    segment_create( domain_node(domain,tri_center),
-			    domain_node(domain,node_index) );
-	  NOT_NULLN(domain->segment[segment_index],"segment_create NULL");
-	  return domain->segment[segment_index];
+	  return domain_store_segment( domain, segment_index,
+				       domain_node(domain,tri_center),
+				       domain_node(domain,node_index) );
 	}
       if ( segment_index < 10*primal_ncell(domain->primal) 
 	                 +  3*primal_ntri(domain->primal) 
@@ -317,8 +472,16 @@ Segment domain_segment( Domain domain, int segment_index )
 	  primal_face(domain->primal, face, face_nodes);
 	  node0 = face_nodes[primal_face_side_node0(side)];
 	  node1 = face_nodes[primal_face_side_node1(side)];
-	  TRYN( primal_find_edge( domain->primal, node0, node1, 
-				  &edge_index ), "face seg find edge" );
+	  edge_index = EMPTY;
+	  if ( NULL != domain->f2t && EMPTY != domain->f2t[face] &&
+	       KNIFE_SUCCESS == primal_find_tri_side( domain->primal, 
+						      domain->f2t[face], 
+						      node0, node1, 
+						      &tri_side ) )
+	    edge_index = domain->t2e[tri_side+3*domain->f2t[face]];
+	  if ( EMPTY == edge_index )
+	    TRYN( primal_find_edge( domain->primal, node0, node1, 
+				    &edge_index ), "face seg find edge" );
 	  edge_center = edge_index + primal_ntri(domain->primal) 
 		+ primal_ncell(domain->primal);
 	  if ( 0 == segment_index - 2*face_side - 
@@ -331,10 +494,9 @@ Segment domain_segment( Domain domain, int segment_index )
 		primal_nedge(domain->primal) + 
 		primal_ntri(domain->primal) + 
 		primal_ncell(domain->primal);
-	      domain->segment[segment_index] = 
-		segment_create( domain_node(domain,node_index),
-				domain_node(domain,edge_center) );
-	      
+	      return domain_store_segment( domain, segment_index,
+					   domain_node(domain,node_index),
+					   domain_node(domain,edge_center) );
 	    }
 	  else
 	    {
@@ -343,19 +505,17 @@ Segment domain_segment( Domain domain, int segment_index )
 		primal_nedge(domain->primal) + 
 		primal_ntri(domain->primal) + 
 		primal_ncell(domain->primal);
-	      domain->segment[segment_index] = 
-		segment_create( domain_node(domain,edge_center),
-				domain_node(domain,node_index) );
+	      return domain_store_segment( domain, segment_index,
+					   domain_node(domain,edge_center),
+					   domain_node(domain,node_index) );
 	    }
-	  NOT_NULLN(domain->segment[segment_index],"segment_create NULL");
-	  return domain->segment[segment_index];	  
 	}
       printf("%s: %d: array bound error %d\n",
 	     __FILE__,__LINE__, segment_index);
       return NULL;
     }
 
-  return domain->segment[segment_index];
+  return domain_used_segment(domain,domain->segment_remap[segment_index]);
 }
 
 Triangle domain_triangle( Domain domain, int triangle_index )
@@ -366,7 +526,7 @@ Triangle domain_triangle( Domain domain, int triangle_index )
   int node0, node1;
   int segment0, segment1, segment2;
   int face, side;
-  int other_face, other_side;
+  KnifeBool other_face_first;
   int face_nodes[4];
   int first_side;
 
@@ -377,7 +537,7 @@ Triangle domain_triangle( Domain domain, int triangle_index )
       return NULL;
     }
 
-  if (NULL == domain->triangle[triangle_index])
+  if (EMPTY == domain->triangle_remap[triangle_index])
     {
       if ( triangle_index < 12*primal_ncell(domain->primal) )
 	{
@@ -406,13 +566,10 @@ Triangle domain_triangle( Domain domain, int triangle_index )
 	      segment1 = cell_edge + 4 + 10 * cell;
 	      segment2 = tri_side + 3 * tri + 10 * primal_ncell(domain->primal);
 	    }
-	  domain->triangle[triangle_index] = 
-	    triangle_create( domain_segment(domain,segment0),
-			     domain_segment(domain,segment1),
-			     domain_segment(domain,segment2), EMPTY );
-	  
-	  NOT_NULLN(domain->triangle[triangle_index],"triangle_create NULL");
-	  return domain->triangle[triangle_index];
+	  return domain_store_triangle( domain, triangle_index,
+					domain_segment(domain,segment0),
+					domain_segment(domain,segment1),
+					domain_segment(domain,segment2), EMPTY );
 	}
       if ( triangle_index < 12*primal_ncell(domain->primal) 
                           +  6*primal_nface(domain->primal) )
@@ -422,13 +579,20 @@ Triangle domain_triangle( Domain domain, int triangle_index )
 	  primal_face(domain->primal, face, face_nodes);
 	  node0 = face_nodes[primal_face_side_node0(side)];
 	  node1 = face_nodes[primal_face_side_node1(side)];
-	  /* the other face may not be there if not watertight (parallel) */
-	  other_face = EMPTY;
-	  primal_find_face_side(domain->primal, node1, node0, 
-				&other_face, &other_side);
-	  TRYN( primal_find_tri( domain->primal, 
-				face_nodes[0], face_nodes[1], face_nodes[2],
-				&tri ), "find tri for triangle init" );
+	  /* a shared side is owned by the lower face index (domain_face_sides),
+	   * the other face may not be there if not watertight (parallel) */
+	  other_face_first = 
+	    ( face != domain->s2fs[0+2*domain->f2s[side+3*face]] );
+	  if ( NULL != domain->f2t && EMPTY != domain->f2t[face] )
+	    {
+	      tri = domain->f2t[face];
+	    }
+	  else
+	    {
+	      TRYN( primal_find_tri( domain->primal, 
+				     face_nodes[0], face_nodes[1], face_nodes[2],
+				     &tri ), "find tri for triangle init" );
+	    }
 	  TRYN( primal_find_tri_side( domain->primal, tri, node0, node1,
 				     &tri_side ), "dual int find rt tri side");
 	  first_side =  10 * primal_ncell(domain->primal) +
@@ -442,33 +606,31 @@ Triangle domain_triangle( Domain domain, int triangle_index )
 		3 *primal_ntri(domain->primal) + 
 		10 * primal_ncell(domain->primal);
 	      segment2 = 0 + first_side + 2*domain->f2s[side+3*face];
-	      if ( EMPTY != other_face && other_face < face) 
+	      if ( other_face_first ) 
 		segment2 = 1 + first_side + 2*domain->f2s[side+3*face];
 	    }
 	  else
 	    {
 	      segment0 = tri_side + 3 * tri + 10 * primal_ncell(domain->primal);
 	      segment1 = 1 + first_side + 2*domain->f2s[side+3*face];
-	      if ( EMPTY != other_face && other_face < face) 
+	      if ( other_face_first ) 
 		segment1 = 0 + first_side + 2*domain->f2s[side+3*face];
 	      segment2 = primal_face_side_node1(side) + 3 * face + 
 		3 *primal_ntri(domain->primal) + 
 		10 * primal_ncell(domain->primal);
 
 	    }
-	  domain->triangle[triangle_index] =
-	    triangle_create( domain_segment(domain,segment0),
-			     domain_segment(domain,segment1),
-			     domain_segment(domain,segment2), face);
-	  NOT_NULLN(domain->triangle[triangle_index],"triangle_create NULL");
-	  return domain->triangle[triangle_index];
+	  return domain_store_triangle( domain, triangle_index,
+					domain_segment(domain,segment0),
+					domain_segment(domain,segment1),
+					domain_segment(domain,segment2), face );
 	}
       printf("%s: %d: array bound error %d\n",
 	     __FILE__,__LINE__, triangle_index);
       return NULL;
     }
 
-  return domain->triangle[triangle_index];
+  return domain_used_triangle(domain,domain->triangle_remap[triangle_index]);
 }
 
 KNIFE_STATUS domain_face_sides( Domain domain )
@@ -528,6 +690,124 @@ KNIFE_STATUS domain_face_sides( Domain domain )
   return (KNIFE_SUCCESS);
 }
 
+static KNIFE_STATUS domain_bulk_elements( Domain domain )
+{
+  int cell, side, tri, tri_side, cell_edge, edge;
+  int face, node;
+  int cell_nodes[4], tri_nodes[3], face_nodes[4];
+  int node0, node1;
+  int ncell, ntri, nedge;
+  int *needed;
+
+  ncell = primal_ncell(domain->primal);
+  ntri  = primal_ntri(domain->primal);
+  nedge = primal_nedge(domain->primal);
+
+  needed = (int *)malloc( ncell * sizeof(int) );
+  domain_test_malloc(needed,"domain_bulk_elements needed");
+
+  domain->t2e = (int *)malloc( 3 * ntri * sizeof(int) );
+  domain_test_malloc(domain->t2e,"domain_bulk_elements t2e");
+  for ( tri = 0 ; tri < 3*ntri ; tri++ ) domain->t2e[tri] = EMPTY;
+
+  domain->f2t = (int *)malloc( primal_nface(domain->primal) * sizeof(int) );
+  domain_test_malloc(domain->f2t,"domain_bulk_elements f2t");
+  for ( face = 0 ; face < primal_nface(domain->primal) ; face++ ) 
+    domain->f2t[face] = EMPTY;
+
+  /* cells with a poly at any node contribute dual triangles,
+   * their tri sides are matched to cell edges without a search */
+  for ( cell = 0 ; cell < ncell ; cell++ )
+    {
+      TRY( primal_cell(domain->primal,cell,cell_nodes), "primal_cell");
+      needed[cell] = ( NULL != domain_poly(domain,cell_nodes[0]) ||
+		       NULL != domain_poly(domain,cell_nodes[1]) ||
+		       NULL != domain_poly(domain,cell_nodes[2]) ||
+		       NULL != domain_poly(domain,cell_nodes[3]) );
+      if ( !needed[cell] ) continue;
+      for ( side = 0 ; side < 4 ; side++ )
+	{
+	  tri = primal_c2t(domain->primal,cell,side);
+	  if ( EMPTY != domain->t2e[0+3*tri] ) continue;
+	  TRY( primal_tri(domain->primal,tri,tri_nodes), "primal_tri");
+	  for ( tri_side = 0 ; tri_side < 3 ; tri_side++ )
+	    {
+	      node0 = tri_nodes[primal_face_side_node0(tri_side)];
+	      node1 = tri_nodes[primal_face_side_node1(tri_side)];
+	      for ( cell_edge = 0 ; cell_edge < 6 ; cell_edge++ )
+		if ( ( node0 == cell_nodes[primal_cell_edge_node0(cell_edge)] &&
+		       node1 == cell_nodes[primal_cell_edge_node1(cell_edge)] ) ||
+		     ( node1 == cell_nodes[primal_cell_edge_node0(cell_edge)] &&
+		       node0 == cell_nodes[primal_cell_edge_node1(cell_edge)] ) )
+		  domain->t2e[tri_side+3*tri] = 
+		    primal_c2e(domain->primal,cell,cell_edge);
+	    }
+	}
+    }
+
+  /* dual node centers, one sweep per node type */
+  for ( cell = 0 ; cell < ncell ; cell++ )
+    if ( needed[cell] )
+      NOT_NULL( domain_node( domain, cell ), "cell center" );
+
+  /* only edges with a poly at an end carry dual triangles, and those
+   * touch the edge center and the centers of the two tris beside it */
+  for ( cell = 0 ; cell < ncell ; cell++ )
+    if ( needed[cell] )
+      {
+	TRY( primal_cell(domain->primal,cell,cell_nodes), "primal_cell");
+	for ( cell_edge = 0 ; cell_edge < 6 ; cell_edge++ )
+	  {
+	    node0 = cell_nodes[primal_cell_edge_node0(cell_edge)];
+	    node1 = cell_nodes[primal_cell_edge_node1(cell_edge)];
+	    if ( NULL == domain_poly(domain,node0) &&
+		 NULL == domain_poly(domain,node1) ) continue;
+	    tri = primal_c2t(domain->primal,cell,
+			     primal_cell_edge_left_side(cell_edge));
+	    NOT_NULL( domain_node( domain, tri + ncell ), "tri center" );
+	    tri = primal_c2t(domain->primal,cell,
+			     primal_cell_edge_right_side(cell_edge));
+	    NOT_NULL( domain_node( domain, tri + ncell ), "tri center" );
+	  }
+      }
+
+  for ( cell = 0 ; cell < ncell ; cell++ )
+    if ( needed[cell] )
+      {
+	TRY( primal_cell(domain->primal,cell,cell_nodes), "primal_cell");
+	for ( cell_edge = 0 ; cell_edge < 6 ; cell_edge++ )
+	  {
+	    node0 = cell_nodes[primal_cell_edge_node0(cell_edge)];
+	    node1 = cell_nodes[primal_cell_edge_node1(cell_edge)];
+	    if ( NULL == domain_poly(domain,node0) &&
+		 NULL == domain_poly(domain,node1) ) continue;
+	    edge = primal_c2e(domain->primal,cell,cell_edge);
+	    NOT_NULL( domain_node( domain, edge + ntri + ncell ), 
+		      "edge center" );
+	  }
+      }
+
+  free( needed );
+
+  for ( face = 0 ; face < primal_nface(domain->primal) ; face++ )
+    {
+      TRY( primal_face(domain->primal, face, face_nodes), "primal_face" );
+      if ( NULL == domain_poly(domain,face_nodes[0]) &&
+	   NULL == domain_poly(domain,face_nodes[1]) &&
+	   NULL == domain_poly(domain,face_nodes[2]) ) continue;
+      TRY( primal_find_tri( domain->primal, 
+			    face_nodes[0], face_nodes[1], face_nodes[2],
+			    &(domain->f2t[face]) ), "find tri for face" );
+      for ( node = 0 ; node < 3 ; node++ )
+	NOT_NULL( domain_node( domain, 
+			       primal_surface_node(domain->primal,
+						   face_nodes[node]) +
+			       nedge + ntri + ncell ), "surface node" );
+    }
+
+  return (KNIFE_SUCCESS);
+}
+
 KNIFE_STATUS domain_dual_elements( Domain domain )
 {
   int node;
@@ -546,7 +826,8 @@ KNIFE_STATUS domain_dual_elements( Domain domain )
       return KNIFE_NULL;
     }
 
-  TRY( domain_face_sides( domain ), "domain_face_sides" );
+  if ( NULL == domain->f2s )
+    TRY( domain_face_sides( domain ), "domain_face_sides" );
 
   domain->nnode = 
     primal_ncell(domain->primal) +
@@ -554,11 +835,11 @@ KNIFE_STATUS domain_dual_elements( Domain domain )
     primal_nedge(domain->primal) +
     primal_surface_nnode(domain->primal);
 
-  domain->node = (Node *)malloc( domain->nnode * sizeof(Node));
-  domain_test_malloc(domain->node,
+  domain->node_remap = (int *)malloc( domain->nnode * sizeof(int));
+  domain_test_malloc(domain->node_remap,
 		     "domain_tetrahedral_elements node");
   for ( node =0 ; node < domain->nnode ; node++ )
-    domain->node[node] = NULL;
+    domain->node_remap[node] = EMPTY;
 
   domain->nsegment = 
     10 * primal_ncell(domain->primal) +
@@ -566,21 +847,23 @@ KNIFE_STATUS domain_dual_elements( Domain domain )
     3  * primal_nface(domain->primal)+
     2  * domain->nside;
 
-  domain->segment = (Segment *)malloc( domain->nsegment * sizeof(Segment));
-  domain_test_malloc(domain->segment,
+  domain->segment_remap = (int *)malloc( domain->nsegment * sizeof(int));
+  domain_test_malloc(domain->segment_remap,
 		     "domain_tetrahedral_elements segment");
   for ( segment_index = 0 ; 
 	segment_index < domain_nsegment(domain); 
-	segment_index++ ) domain->segment[ segment_index ] = NULL;
+	segment_index++ ) domain->segment_remap[ segment_index ] = EMPTY;
 
   domain->ntriangle = 12*primal_ncell(domain->primal)
                     +  6*primal_nface(domain->primal);
 
-  domain->triangle = (Triangle *)malloc( domain->ntriangle * sizeof(Triangle));
-  domain_test_malloc(domain->triangle,"domain_dual_elements triangle");
+  domain->triangle_remap = (int *)malloc( domain->ntriangle * sizeof(int));
+  domain_test_malloc(domain->triangle_remap,"domain_dual_elements triangle");
   for ( triangle_index = 0 ; 
 	triangle_index < domain_ntriangle(domain); 
-	triangle_index++ ) domain->triangle[ triangle_index ] = NULL;
+	triangle_index++ ) domain->triangle_remap[ triangle_index ] = EMPTY;
+
+  TRY( domain_bulk_elements( domain ), "domain_bulk_elements" );
 	  
   for ( cell = 0 ; cell < primal_ncell(domain->primal) ; cell++)
     {
@@ -652,6 +935,9 @@ KNIFE_STATUS domain_dual_elements( Domain domain )
 	}
     }
 
+  free( domain->t2e ); domain->t2e = NULL;
+  free( domain->f2t ); domain->f2t = NULL;
+
   return (KNIFE_SUCCESS);
 }
 
@@ -668,9 +954,9 @@ KNIFE_STATUS domain_add_interior_poly( Domain domain, int poly_index )
   AdjIterator it;
 
   if ( NULL == domain->poly || 
-       NULL == domain->node || 
-       NULL == domain->segment || 
-       NULL == domain->triangle ||
+       NULL == domain->node_remap || 
+       NULL == domain->segment_remap || 
+       NULL == domain->triangle_remap ||
        NULL == domain->f2s ||
        NULL == domain->s2fs )
     {
@@ -782,6 +1068,53 @@ KNIFE_STATUS domain_all_dual( Domain domain )
   return (KNIFE_SUCCESS);
 }
 
+/* box around the surface nodes, padded for round off */
+static KNIFE_STATUS domain_surface_extent( Domain domain, 
+					   double *lower, double *upper )
+{
+  int node_index, i;
+  double *xyz, pad;
+
+  for ( i = 0 ; i < 3 ; i++ )
+    {
+      lower[i] =  1.0e300;
+      upper[i] = -1.0e300;
+    }
+  for ( node_index = 0 ; 
+	node_index < surface_nnode(domain->surface) ; 
+	node_index++ )
+    {
+      xyz = surface_node(domain->surface,node_index)->xyz;
+      for ( i = 0 ; i < 3 ; i++ )
+	{
+	  lower[i] = MIN( lower[i], xyz[i] );
+	  upper[i] = MAX( upper[i], xyz[i] );
+	}
+    }
+
+  pad = 0.0;
+  for ( i = 0 ; i < 3 ; i++ )
+    pad = MAX( pad, upper[i]-lower[i] );
+  pad *= 1.0e-8;
+  for ( i = 0 ; i < 3 ; i++ )
+    {
+      lower[i] -= pad;
+      upper[i] += pad;
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+static KnifeBool domain_sphere_outside( double *center, double radius,
+					double *lower, double *upper )
+{
+  int i;
+  for ( i = 0 ; i < 3 ; i++ )
+    if ( center[i]+radius < lower[i] || center[i]-radius > upper[i] ) 
+      return TRUE;
+  return FALSE;
+}
+
 KNIFE_STATUS domain_required_local_dual( Domain domain, int *required )
 {
   int triangle_index;
@@ -806,12 +1139,16 @@ KNIFE_STATUS domain_required_local_dual( Domain domain, int *required )
   double dx, dy, dz;
   KNIFE_STATUS intersection_status;
   int nrequired;
+  double lower[3], upper[3], reach;
 
+  domain_phase( "required:surface near" );
   for ( poly_index = 0 ; 
 	poly_index < primal_nnode(domain->primal); 
 	poly_index++)
     required[poly_index] = 0;
 
+  TRY( domain_surface_extent( domain, lower, upper ), "surface extent" );
+
   triangle_tree = (NearStruct *)malloc( surface_ntriangle(domain->surface) * 
 					sizeof(NearStruct));
   NOT_NULL( triangle_tree, "out of memory, could not malloc triangle_tree");
@@ -830,13 +1167,28 @@ KNIFE_STATUS domain_required_local_dual( Domain domain, int *required )
 					   &(triangle_tree[triangle_index]) );
     }
 
+  /* a sphere that touches a triangle sphere comes within reach of the
+   * box around the surface (triangle centers are inside it) */
+  reach = 0.0;
+  for (triangle_index=0;
+       triangle_index<surface_ntriangle(domain->surface);
+       triangle_index++)
+    reach = MAX( reach, triangle_tree[triangle_index].radius );
+
   max_touched = surface_ntriangle(domain->surface);
 
   touched = (int *) malloc( max_touched * sizeof(int) );
   NOT_NULL( touched, "touched NULL");
 
+  if ( NULL != domain->edge_near ) free( domain->edge_near );
+  domain->edge_near = (KnifeBool *)malloc( MAX(primal_nedge(domain->primal),1)*
+					   sizeof(KnifeBool) );
+  NOT_NULL( domain->edge_near, "edge_near NULL");
+
+  domain_phase( "required:edges" );
   for (edge_index=0;edge_index<primal_nedge(domain->primal);edge_index++)
     {
+      domain->edge_near[edge_index] = FALSE;
       primal_edge(domain->primal,edge_index,edge_nodes);
       primal_xyz(domain->primal,edge_nodes[0],xyz0);
       primal_xyz(domain->primal,edge_nodes[1],xyz1);
@@ -845,12 +1197,15 @@ KNIFE_STATUS domain_required_local_dual( Domain domain, int *required )
       dz = xyz0[2]-xyz1[2];
       diameter = 0.5000001*sqrt(dx*dx+dy*dy+dz*dz);
       primal_edge_center( domain->primal, edge_index, center);
+      if ( domain_sphere_outside( center, diameter+reach, lower, upper ) )
+	continue;
       near_initialize( &target, 
 		       EMPTY, 
 		       center[0], center[1], center[2], 
 		       diameter );
       ntouched = 0;
       near_touched(triangle_tree, &target, &ntouched, max_touched, touched);
+      domain->edge_near[edge_index] = (KnifeBool)( ntouched > 0 );
       for (i=0;i<ntouched;i++)
 	{
 	  triangle = surface_triangle(domain->surface,touched[i]);
@@ -893,6 +1248,7 @@ KNIFE_STATUS domain_required_local_dual( Domain domain, int *required )
   free(touched);
   free(triangle_tree);
 
+  domain_phase( "required:segment near" );
   segment_tree = (NearStruct *)malloc( surface_nsegment(domain->surface) * 
 				       sizeof(NearStruct));
   NOT_NULL( segment_tree, "segment_tree NULL");
@@ -911,11 +1267,18 @@ KNIFE_STATUS domain_required_local_dual( Domain domain, int *required )
 					  &(segment_tree[segment_index]) );
     }
 
+  reach = 0.0;
+  for (segment_index=0;
+       segment_index<surface_nsegment(domain->surface);
+       segment_index++)
+    reach = MAX( reach, segment_tree[segment_index].radius );
+
   max_touched = surface_nsegment(domain->surface);
   
   touched = (int *) malloc( max_touched * sizeof(int) );
   NOT_NULL( touched, "touched NULL");
   
+  domain_phase( "required:tris" );
   for (tri_index=0;tri_index<primal_ntri(domain->primal);tri_index++)
     {
       primal_tri(domain->primal,tri_index,tri_nodes);
@@ -937,6 +1300,9 @@ KNIFE_STATUS domain_required_local_dual( Domain domain, int *required )
       dx = xyz2[0]-center[0];dy = xyz2[1]-center[1];dz = xyz2[2]-center[2];
       diameter = MAX(diameter,sqrt(dx*dx+dy*dy+dz*dz));
 
+      if ( domain_sphere_outside( center, diameter+reach, lower, upper ) )
+	continue;
+
       near_initialize( &target, 
 		       EMPTY, 
 		       center[0], center[1], center[2], 
@@ -993,6 +1359,8 @@ KNIFE_STATUS domain_required_local_dual( Domain domain, int *required )
         poly_index++)
     if ( 0 != required[poly_index]) nrequired++;
 
+  profile_end( );
+
   return (KNIFE_SUCCESS);
 }
 
@@ -1233,26 +1601,154 @@ KNIFE_STATUS domain_required_dual( Domain domain )
   return (KNIFE_SUCCESS);
 }
 
+static KNIFE_STATUS domain_establish_cut( Triangle triangle, 
+					  Triangle surface_triangle )
+{
+  KNIFE_STATUS cut_status;
+
+  cut_status = cut_establish_between( triangle, surface_triangle );
+  if ( KNIFE_SUCCESS != cut_status)
+    {
+      triangle_tecplot( triangle );
+      triangle_tecplot( surface_triangle );
+    }
+
+  return cut_status;
+}
+
+/* the dual triangle lies in a cell (or on a boundary face) whose edges
+ * the required scan found clear of the surface */
+static KnifeBool domain_triangle_clear( Domain domain, int triangle_index )
+{
+  Primal primal;
+  int cell, cell_edge, face, side, face_nodes[4], edge;
+
+  primal = domain->primal;
+  if ( NULL == domain->edge_near || NULL == primal->c2e ) return FALSE;
+
+  if ( triangle_index < 12*primal_ncell(primal) )
+    {
+      cell = triangle_index / 12;
+      for ( cell_edge = 0 ; cell_edge < 6 ; cell_edge++ )
+	if ( domain->edge_near[primal_c2e(primal,cell,cell_edge)] ) 
+	  return FALSE;
+      return TRUE;
+    }
+
+  face = ( triangle_index - 12*primal_ncell(primal) ) / 6;
+  primal_face(primal, face, face_nodes);
+  for ( side = 0 ; side < 3 ; side++ )
+    {
+      if ( KNIFE_SUCCESS != 
+	   primal_find_edge( primal,
+			     face_nodes[primal_face_side_node0(side)],
+			     face_nodes[primal_face_side_node1(side)],
+			     &edge ) ) return FALSE;
+      if ( domain->edge_near[edge] ) return FALSE;
+    }
+  return TRUE;
+}
+
+/* the dual triangles of a cell (12) or a boundary face (6) are tested
+ * against the surface tree with one sphere around all of their spheres,
+ * each triangle then only keeps the surface triangles of that list its
+ * own sphere touches (the criterion of near_touched, in tree order) */
+#define DOMAIN_MAX_GROUP (12)
+static KNIFE_STATUS domain_cut_group( Domain domain, 
+				      int first, int ngroup,
+				      NearStruct *triangle_tree,
+				      int max_touched, int *group_touched,
+				      int *touched, int *stats )
+{
+  int triangle_index[DOMAIN_MAX_GROUP];
+  NearStruct target[DOMAIN_MAX_GROUP];
+  NearStruct group;
+  double center[3], diameter, radius;
+  int n, ntriangle, i, ntouched, nfound;
+  Near near;
+
+  ntriangle = 0;
+  for ( n = 0 ; n < ngroup ; n++ )
+    {
+      if ( !domain_triangle_exists(domain,first+n) ) continue;
+      if ( domain_triangle_clear( domain, first+n ) )
+	{
+	  stats[0]++;
+	  continue;
+	}
+      triangle_index[ntriangle] = first+n;
+      triangle_extent(domain_triangle(domain,first+n), center, &diameter);
+      near_initialize( &(target[ntriangle]), EMPTY, 
+		       center[0], center[1], center[2], diameter );
+      ntriangle++;
+    }
+  if ( 0 == ntriangle ) return KNIFE_SUCCESS;
+
+  center[0] = center[1] = center[2] = 0.0;
+  for ( n = 0 ; n < ntriangle ; n++ )
+    {
+      center[0] += target[n].x / (double)ntriangle;
+      center[1] += target[n].y / (double)ntriangle;
+      center[2] += target[n].z / (double)ntriangle;
+    }
+  near_initialize( &group, EMPTY, center[0], center[1], center[2], 0.0 );
+  radius = 0.0;
+  for ( n = 0 ; n < ntriangle ; n++ )
+    {
+      near = &(target[n]);
+      radius = MAX( radius, near_distance( (&group), near ) + near->radius );
+    }
+  group.radius = radius * ( 1.0 + 1.0e-12 );
+
+  stats[1]++;
+  nfound = 0;
+  near_touched(triangle_tree, &group, &nfound, max_touched, group_touched);
+  if ( 0 == nfound )
+    {
+      stats[2]++;
+      stats[3] += ntriangle;
+      return KNIFE_SUCCESS;
+    }
+
+  for ( n = 0 ; n < ntriangle ; n++ )
+    {
+      stats[4]++;
+      near = &(target[n]);
+      ntouched = 0;
+      for ( i = 0 ; i < nfound ; i++ )
+	if ( triangle_tree[group_touched[i]].radius >= 
+	     near_distance( (&(triangle_tree[group_touched[i]])), near ) - 
+	     near->radius )
+	  touched[ntouched++] = group_touched[i];
+      for ( i = 0 ; i < ntouched ; i++ )
+	TRY( domain_establish_cut( domain_triangle(domain,triangle_index[n]),
+				   surface_triangle( domain->surface,
+						     touched[i] ) ),
+	     "cut establishment failed" );
+    }
+
+  return KNIFE_SUCCESS;
+}
+
 KNIFE_STATUS domain_boolean_subtract( Domain domain )
 {
   int triangle_index;
-  int i;
   NearStruct *triangle_tree;
   double center[3], diameter;
-  int max_touched, ntouched;
-  int *touched;
-  NearStruct target;
-
-  KNIFE_STATUS cut_status;
+  int max_touched;
+  int *touched, *group_touched;
+  int cell, face;
+  int stats[5];
+  char message[1025];
 
-  logger_message( DOMAIN_LOGGER_LEVEL, "subtract:dual_elements");
+  domain_phase( "subtract:dual_elements" );
   TRY( domain_dual_elements( domain ), "domain_dual_elements" );
 
   triangle_tree = (NearStruct *)malloc( surface_ntriangle(domain->surface) * 
 					sizeof(NearStruct));
   NOT_NULL( triangle_tree, "triangle_tree NULL");
 
-  logger_message( DOMAIN_LOGGER_LEVEL, "subtract:surface near");
+  domain_phase( "subtract:surface near" );
   for (triangle_index=0;
        triangle_index<surface_ntriangle(domain->surface);
        triangle_index++)
@@ -1271,56 +1767,318 @@ KNIFE_STATUS domain_boolean_subtract( Domain domain )
 
   touched = (int *) malloc( max_touched * sizeof(int) );
   NOT_NULL( touched, "touched NULL");
-
-  logger_message( DOMAIN_LOGGER_LEVEL, "subtract:cut");
-  for ( triangle_index = 0;
-	triangle_index < domain_ntriangle(domain); 
-	triangle_index++)
-    if (NULL != domain->triangle[triangle_index] )
-      {
-	triangle_extent(domain_triangle(domain,triangle_index),
-			center, &diameter);
-	near_initialize( &target, 
-			 EMPTY, 
-			 center[0], center[1], center[2], 
-			 diameter );
-	ntouched = 0;
-	near_touched(triangle_tree, &target, &ntouched, max_touched, touched);
-	for (i=0;i<ntouched;i++)
-	  {
-	    cut_status = 
-	      cut_establish_between( domain_triangle( domain,triangle_index ),
-				     surface_triangle( domain->surface,
-						       touched[i] ) );
-	    if ( KNIFE_SUCCESS != cut_status)
-	      {
-		triangle_tecplot( domain_triangle( domain,triangle_index ) );
-		triangle_tecplot( surface_triangle( domain->surface,
-						    touched[i] ) );
-	      }
-	    TRY( cut_status, "cut establishment failed" );
-	  }
-      }
-
+  group_touched = (int *) malloc( max_touched * sizeof(int) );
+  NOT_NULL( group_touched, "group_touched NULL");
+
+  domain_phase( "subtract:cut" );
+  /* pruned by the required scan, groups tested, groups culled, triangles
+   * in culled groups, triangles tested */
+  for ( cell = 0 ; cell < 5 ; cell++ ) stats[cell] = 0;
+  for ( cell = 0 ; cell < primal_ncell(domain->primal) ; cell++ )
+    TRY( domain_cut_group( domain, 12*cell, 12, triangle_tree, 
+			   max_touched, group_touched, touched, stats ),
+	 "cell group" );
+  for ( face = 0 ; face < primal_nface(domain->primal) ; face++ )
+    TRY( domain_cut_group( domain, 12*primal_ncell(domain->primal)+6*face, 6,
+			   triangle_tree, 
+			   max_touched, group_touched, touched, stats ),
+	 "face group" );
+
+  free(group_touched);
   free(touched);
   free(triangle_tree);
 
-  logger_message( DOMAIN_LOGGER_LEVEL, "subtract:triangulate");
+  sprintf( message, 
+	   "subtract:cut pruned %d culled %d of %d groups (%d dual triangles)"
+	   " searched %d dual triangles",
+	   stats[0], stats[2], stats[1], stats[3], stats[4] );
+  logger_message( DOMAIN_LOGGER_LEVEL, message );
+
+  domain_phase( "subtract:triangulate" );
   TRY( domain_triangulate(domain), "domain_triangulate\n--> the triangulation step of the cut cell process failed <--" );
 
-  logger_message( DOMAIN_LOGGER_LEVEL, "subtract:gather_surf");
+  domain_phase( "subtract:gather_surf" );
   TRY( domain_gather_surf(domain), "domain_gather_surf" );
 
-  logger_message( DOMAIN_LOGGER_LEVEL, "subtract:active");
+  domain_phase( "subtract:active" );
   TRY( domain_determine_active_subtri(domain), 
        "domain_determine_active_subtri" );
 
-  logger_message( DOMAIN_LOGGER_LEVEL, "subtract:set_dual_topology");
+  domain_phase( "subtract:set_dual_topology" );
   TRY( domain_set_dual_topology( domain ), "domain_set_dual_topology" );
 
+  profile_end( );
+
   return (KNIFE_SUCCESS);
 }
 
+/* cut triangle with the surface triangles of tree that it touches,
+ * both are added to changed when they get a new cut */
+static KNIFE_STATUS domain_cut_touched( Domain domain, Triangle triangle,
+					NearStruct *tree, 
+					int max_touched, int *touched, 
+					Array changed )
+{
+  double center[3], diameter;
+  int i, ntouched, ncut;
+  NearStruct target;
+  Triangle other;
+
+  triangle_extent(triangle, center, &diameter);
+  near_initialize( &target, 
+		   EMPTY, 
+		   center[0], center[1], center[2], 
+		   diameter );
+  ntouched = 0;
+  near_touched(tree, &target, &ntouched, max_touched, touched);
+  for (i=0;i<ntouched;i++)
+    {
+      other = surface_triangle( domain->surface, touched[i] );
+      ncut = triangle_ncut( other );
+      TRY( domain_establish_cut( triangle, other ), 
+	   "cut establishment failed" );
+      if ( triangle_ncut( other ) > ncut )
+	{
+	  TRY( array_add( changed, (ArrayItem)triangle ), "changed dual" );
+	  TRY( array_add( changed, (ArrayItem)other ), "changed surface" );
+	}
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+static int domain_compare_triangle( const void *a, const void *b )
+{
+  size_t triangle_a, triangle_b;
+  triangle_a = (size_t)(*(const Triangle *)a);
+  triangle_b = (size_t)(*(const Triangle *)b);
+  if ( triangle_a < triangle_b ) return -1;
+  if ( triangle_a > triangle_b ) return 1;
+  return 0;
+}
+
+static KnifeBool domain_poly_changed( Poly poly, 
+				      int nchanged, Triangle *changed )
+{
+  int mask_index;
+  Triangle triangle;
+
+  for ( mask_index = 0; mask_index < poly_nmask(poly); mask_index++)
+    {
+      triangle = mask_triangle(poly_mask(poly, mask_index));
+      if ( NULL != bsearch( &triangle, changed, nchanged, sizeof(Triangle),
+			    domain_compare_triangle ) ) return TRUE;
+    }
+  for ( mask_index = 0; mask_index < poly_nsurf(poly); mask_index++)
+    {
+      triangle = mask_triangle(poly_surf(poly, mask_index));
+      if ( NULL != bsearch( &triangle, changed, nchanged, sizeof(Triangle),
+			    domain_compare_triangle ) ) return TRUE;
+    }
+
+  return FALSE;
+}
+
+#define domain_surface_node_moved(domain,moved,node)	\
+  (moved[surface_node_index((domain)->surface,(node))])
+
+/* the surface nodes flagged in moved were moved in place (see
+ * surface_update_xyz) after domain_boolean_subtract.  Only the cuts of
+ * the moved surface triangles are found again, only the triangles
+ * whose cuts changed are triangulated again and only the polys holding
+ * them are gathered and painted again.  required is set as by
+ * domain_required_local_dual and the polys it adds are created. */
+KNIFE_STATUS domain_recut_moved( Domain domain, KnifeBool *moved, 
+				 int *required )
+{
+  Surface surface;
+  Triangle triangle, other;
+  Segment segment;
+  Cut cut;
+  Poly poly;
+  Array changed;
+  int nchanged;
+  Triangle *sorted;
+  KnifeBool *new_poly;
+  int nmoved, *moved_triangle;
+  NearStruct *tree;
+  double center[3], diameter;
+  int max_touched;
+  int *touched;
+  int triangle_index, segment_index, used_index, poly_index;
+  int i;
+  int ntriangle_used0;
+
+  if ( NULL == domain->poly || NULL == domain->topo )
+    {
+      printf("%s: %d: domain_recut_moved before domain_boolean_subtract\n",
+	     __FILE__,__LINE__);
+      return KNIFE_INCONSISTENT;
+    }
+  surface = domain->surface;
+
+  /* the surface moved since the required scan */
+  if ( NULL != domain->edge_near ) free( domain->edge_near );
+  domain->edge_near = NULL;
+
+  changed = array_create( 100, 100 );
+  NOT_NULL( changed, "changed NULL" );
+
+  moved_triangle = (int *)malloc( MAX(surface_ntriangle(surface),1) * 
+				  sizeof(int) );
+  NOT_NULL( moved_triangle, "moved_triangle NULL" );
+
+  domain_phase( "recut:drop" );
+  /* the cuts of the moved triangles, and the intersections they made
+   * with the segments of the dual triangles, are stale */
+  nmoved = 0;
+  for (triangle_index=0;
+       triangle_index<surface_ntriangle(surface);
+       triangle_index++)
+    {
+      triangle = surface_triangle(surface,triangle_index);
+      if ( !domain_surface_node_moved(domain,moved,triangle_node0(triangle)) &&
+	   !domain_surface_node_moved(domain,moved,triangle_node1(triangle)) &&
+	   !domain_surface_node_moved(domain,moved,triangle_node2(triangle)) )
+	continue;
+      moved_triangle[nmoved] = triangle_index;
+      nmoved++;
+      TRY( array_add( changed, (ArrayItem)triangle ), "changed surface" );
+      while ( triangle_ncut(triangle) > 0 )
+	{
+	  cut = triangle_cut(triangle,triangle_ncut(triangle)-1);
+	  other = cut_other_triangle(cut,triangle);
+	  for ( segment_index = 0 ; segment_index < 3 ; segment_index++ )
+	    TRY( segment_drop_intersection( triangle_segment(other,
+							     segment_index),
+					    triangle ), "drop intersection" );
+	  TRY( array_add( changed, (ArrayItem)other ), "changed dual" );
+	  TRY( cut_remove( cut ), "cut_remove" );
+	}
+    }
+
+  for (segment_index=0;
+       segment_index<surface_nsegment(surface);
+       segment_index++)
+    {
+      segment = surface_segment(surface,segment_index);
+      if ( domain_surface_node_moved(domain,moved,segment->node0) ||
+	   domain_surface_node_moved(domain,moved,segment->node1) )
+	TRY( segment_drop_intersections( segment ), "drop intersections" );
+    }
+
+  domain_phase( "recut:required" );
+  ntriangle_used0 = domain_ntriangle_used(domain);
+  TRY( domain_required_local_dual( domain, required ), 
+       "domain_required_local_dual" );
+
+  new_poly = (KnifeBool *)malloc( domain_npoly(domain) * sizeof(KnifeBool) );
+  NOT_NULL( new_poly, "new_poly NULL" );
+  for (poly_index = 0 ; poly_index < domain_npoly(domain) ; poly_index++)
+    {
+      new_poly[poly_index] = FALSE;
+      if ( 0 == required[poly_index] || 
+	   NULL != domain_poly(domain,poly_index) ) continue;
+      TRY( domain_add_interior_poly( domain, poly_index ), 
+	   "domain_add_interior_poly" );
+      new_poly[poly_index] = TRUE;
+    }
+
+  domain_phase( "recut:cut" );
+  max_touched = surface_ntriangle(surface);
+  touched = (int *) malloc( MAX(max_touched,1) * sizeof(int) );
+  NOT_NULL( touched, "touched NULL");
+  tree = (NearStruct *)malloc( MAX(surface_ntriangle(surface),1) * 
+			       sizeof(NearStruct));
+  NOT_NULL( tree, "tree NULL");
+
+  /* the dual triangles cut before only meet the moved triangles anew */
+  for ( i = 0 ; i < nmoved ; i++ )
+    {
+      triangle_extent(surface_triangle(surface,moved_triangle[i]),
+		      center, &diameter);
+      near_initialize( &(tree[i]), moved_triangle[i], 
+		       center[0], center[1], center[2], diameter );
+      if (i > 0) near_insert( tree, &(tree[i]) );
+    }
+  if ( nmoved > 0 )
+    for ( used_index = 0 ; used_index < ntriangle_used0 ; used_index++ )
+      TRY( domain_cut_touched( domain, 
+			       domain_used_triangle(domain,used_index),
+			       tree, max_touched, touched, changed ),
+	   "cut moved" );
+
+  /* the dual triangles of the added polys meet every surface triangle */
+  for (triangle_index=0;
+       triangle_index<surface_ntriangle(surface);
+       triangle_index++)
+    {
+      triangle_extent(surface_triangle(surface,triangle_index),
+		      center, &diameter);
+      near_initialize( &(tree[triangle_index]), triangle_index, 
+		       center[0], center[1], center[2], diameter );
+      if (triangle_index > 0) near_insert( tree, &(tree[triangle_index]) );
+    }
+  for ( used_index = ntriangle_used0 ; 
+	used_index < domain_ntriangle_used(domain) ; 
+	used_index++ )
+    TRY( domain_cut_touched( domain, 
+			     domain_used_triangle(domain,used_index),
+			     tree, max_touched, touched, changed ),
+	 "cut added" );
+
+  free( tree );
+  free( touched );
+  free( moved_triangle );
+
+  domain_phase( "recut:triangulate" );
+  sorted = (Triangle *)malloc( MAX(array_size(changed),1) * sizeof(Triangle) );
+  NOT_NULL( sorted, "sorted NULL");
+  for ( i = 0 ; i < array_size(changed) ; i++ )
+    sorted[i] = (Triangle)array_item(changed,i);
+  qsort( sorted, array_size(changed), sizeof(Triangle), 
+	 domain_compare_triangle );
+  nchanged = 0;
+  for ( i = 0 ; i < array_size(changed) ; i++ )
+    if ( 0 == nchanged || sorted[i] != sorted[nchanged-1] )
+      {
+	sorted[nchanged] = sorted[i];
+	nchanged++;
+      }
+  array_free( changed );
+
+  for ( i = 0 ; i < nchanged ; i++ )
+    {
+      TRY( triangle_reset_subtri( sorted[i] ), "triangle_reset_subtri" );
+      TRY( triangle_triangulate_cuts( sorted[i] ), 
+	   "triangulate_cuts\n--> the triangulation step of the cut cell process failed <--" );
+    }
+
+  domain_phase( "recut:gather_surf" );
+  for (poly_index = 0 ; poly_index < domain_npoly(domain) ; poly_index++)
+    {
+      poly = domain_poly(domain,poly_index);
+      if ( NULL == poly ) continue;
+      if ( !new_poly[poly_index] && 
+	   !domain_poly_changed( poly, nchanged, sorted ) ) continue;
+      TRY( poly_reset_surf( poly ), "poly_reset_surf" );
+      TRY( poly_gather_surf( poly ), "poly_gather_surf" );
+      if ( poly_index < domain_npoly0(domain) && poly_has_surf( poly ) )
+	TRY( poly_determine_active_subtri( poly ),
+	     "poly_determine_active_subtri" );
+    }
+
+  free( new_poly );
+  free( sorted );
+
+  domain_phase( "recut:set_dual_topology" );
+  TRY( domain_set_dual_topology( domain ), "domain_set_dual_topology" );
+
+  profile_end( );
+
+  return KNIFE_SUCCESS;
+}
+
 KNIFE_STATUS domain_triangulate( Domain domain )
 {
   int triangle_index;
@@ -1330,7 +2088,7 @@ KNIFE_STATUS domain_triangulate( Domain domain )
   for ( triangle_index = 0;
 	triangle_index < domain_ntriangle(domain); 
 	triangle_index++)
-    if (NULL != domain->triangle[triangle_index] )
+    if ( domain_triangle_exists(domain,triangle_index) )
       TRY( triangle_triangulate_cuts( domain_triangle(domain, 
 						      triangle_index) ), 
 	   "volume triangulate_cuts" );
@@ -1372,21 +2130,294 @@ KNIFE_STATUS domain_determine_active_subtri( Domain domain )
   return KNIFE_SUCCESS;
 }
 
-KNIFE_STATUS domain_set_dual_topology( Domain domain )
+/* topo of an edge end that is not cut, once the other end is cut.
+ * The edge center is surrounded by inactive subtri of a cut poly when
+ * the uncut end is inside the body */
+static KNIFE_STATUS domain_topo_across_cut_edge( Domain domain, int edge,
+						 int *edge_nodes, 
+						 int *exterior )
 {
-  int poly_index;
-  int edge;
-  int edge_nodes[2];
   Poly poly0, poly1;
   POLY_TOPO topo0, topo1;
   int node_index;
   Node node;
   KnifeBool active;
 
+  *exterior = EMPTY;
+
+  poly0 = domain_poly(domain,edge_nodes[0]);
+  poly1 = domain_poly(domain,edge_nodes[1]);
+  if ( NULL == poly0 || NULL == poly1 ) return KNIFE_SUCCESS;
+
+  node_index = edge + 
+    primal_ntri(domain->primal) + primal_ncell(domain->primal);
+  node = domain_node(domain,node_index);
+  topo0 = domain->topo[edge_nodes[0]];
+  topo1 = domain->topo[edge_nodes[1]];
+
+  if ( POLY_CUT == topo0 &&  
+       ( POLY_INTERIOR == topo1 || POLY_GHOST == topo1 ) )
+    {
+      TRY( poly_mask_surrounding_node_activity( poly0, node,
+						&active ), "active01");
+      if ( !active ) *exterior = edge_nodes[1];
+    }
+
+  if ( POLY_CUT == topo1 && 
+       ( POLY_INTERIOR == topo0 || POLY_GHOST == topo0 ) )
+    {
+      TRY( poly_mask_surrounding_node_activity( poly1, node,
+						&active ), "active10");
+      if ( !active ) *exterior = edge_nodes[0];
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+/* exterior[node] is set for the original primal nodes behind the
+ * surface, where the surface winds about them more than about the far
+ * field.  The far field is behind the surface when the surface
+ * normals point into the volume it encloses (negative volume). */
+KNIFE_STATUS domain_classify_nodes( Domain domain, KnifeBool *exterior )
+{
+  Surface surface;
+  Triangle triangle;
+  double *a, *b, *c;
+  double volume;
+  double *xyz;
+  int *winding;
+  int triangle_index, node, far_field;
+
+  surface = domain->surface;
+
+  volume = 0.0;
+  for (triangle_index=0;
+       triangle_index<surface_ntriangle(surface);
+       triangle_index++)
+    {
+      triangle = surface_triangle(surface,triangle_index);
+      a = triangle_xyz0(triangle);
+      b = triangle_xyz1(triangle);
+      c = triangle_xyz2(triangle);
+      volume += a[0]*(b[1]*c[2]-b[2]*c[1]) 
+	      + a[1]*(b[2]*c[0]-b[0]*c[2]) 
+	      + a[2]*(b[0]*c[1]-b[1]*c[0]);
+    }
+  far_field = ( volume < 0.0 ? 1 : 0 );
+
+  xyz = (double *)malloc( 3 * MAX(domain_npoly0(domain),1) * sizeof(double) );
+  NOT_NULL( xyz, "xyz NULL" );
+  winding = (int *)malloc( MAX(domain_npoly0(domain),1) * sizeof(int) );
+  NOT_NULL( winding, "winding NULL" );
+
+  for ( node = 0 ; node < domain_npoly0(domain) ; node++ )
+    TRY( primal_xyz( domain->primal, node, &(xyz[3*node]) ), "primal_xyz" );
+
+  TRY( surface_winding( surface, domain_npoly0(domain), xyz, winding ),
+       "surface_winding" );
+
+  for ( node = 0 ; node < domain_npoly0(domain) ; node++ )
+    exterior[node] = ( winding[node] + far_field > 0 );
+
+  free( winding );
+  free( xyz );
+
+  return KNIFE_SUCCESS;
+}
+
+/* the uncut original polys that are not already exterior from a cut
+ * neighbor are exterior when their node is behind the surface */
+static KNIFE_STATUS domain_classified_topology( Domain domain )
+{
+  KnifeBool *exterior;
+  int poly_index;
+
+  exterior = (KnifeBool *)malloc( MAX(domain_npoly0(domain),1) * 
+				  sizeof(KnifeBool) );
+  NOT_NULL( exterior, "exterior NULL" );
+  TRY( domain_classify_nodes( domain, exterior ), "domain_classify_nodes" );
+
+  for ( poly_index = 0; 
+	poly_index < domain_npoly0(domain); 
+	poly_index++ )
+    if ( POLY_INTERIOR == domain->topo[poly_index] && exterior[poly_index] )
+      domain->topo[poly_index] = POLY_EXTERIOR;
+
+  free( exterior );
+
+  return KNIFE_SUCCESS;
+}
+
+/* report the uncut original polys where the flood fill and the surface
+ * winding number disagree */
+static KNIFE_STATUS domain_check_topology( Domain domain )
+{
+  KnifeBool *exterior;
+  int poly_index, nuncut, ndisagree;
+  POLY_TOPO topo;
+
+  exterior = (KnifeBool *)malloc( MAX(domain_npoly0(domain),1) * 
+				  sizeof(KnifeBool) );
+  NOT_NULL( exterior, "exterior NULL" );
+  TRY( domain_classify_nodes( domain, exterior ), "domain_classify_nodes" );
+
+  nuncut = 0;
+  ndisagree = 0;
+  for ( poly_index = 0; 
+	poly_index < domain_npoly0(domain); 
+	poly_index++ )
+    {
+      topo = domain->topo[poly_index];
+      if ( POLY_CUT == topo ) continue;
+      nuncut++;
+      if ( ( POLY_EXTERIOR == topo ) != exterior[poly_index] ) ndisagree++;
+    }
+
+  free( exterior );
+
+  if ( ndisagree > 0 )
+    printf("%s: %d: %d of %d uncut polys flood filled against winding\n",
+	   __FILE__,__LINE__,ndisagree,nuncut);
+
+  return KNIFE_SUCCESS;
+}
+
+/* the topology left by domain_reset is turned back to its starting
+ * state (only cut and exterior polys differ from it) and the exterior
+ * is flooded from the new cut through the cells, instead of sweeping
+ * every edge until nothing changes.  The result is the same as a full
+ * domain_set_dual_topology */
+static KNIFE_STATUS domain_update_dual_topology( Domain domain )
+{
+  int poly_index, npoly0;
+  int *queue, nqueue, iqueue;
+  int *cut, ncut, icut;
+  int edge, edge_nodes[2], exterior;
+  int cell, cell_edge;
+  AdjIterator it;
+  Primal primal;
+  KNIFE_STATUS status;
+
+  primal = domain->primal;
+  npoly0 = domain_npoly0(domain);
+
+  queue = (int *)malloc( MAX(domain_npoly(domain),1) * sizeof(int) );
+  NOT_NULL( queue, "queue NULL");
+  cut = (int *)malloc( MAX(domain_npoly(domain),1) * sizeof(int) );
+  if ( NULL == cut ) free( queue );
+  NOT_NULL( cut, "cut NULL");
+
+  ncut = 0;
+  for ( poly_index = 0;
+	poly_index < domain_npoly(domain); 
+	poly_index++)
+    {
+      if ( POLY_CUT == domain->topo[poly_index] ||
+	   POLY_EXTERIOR == domain->topo[poly_index] )
+	domain->topo[poly_index] = 
+	  ( poly_index < npoly0 ? POLY_INTERIOR : POLY_GHOST );
+      if ( poly_index < npoly0 &&
+	   NULL != domain_poly(domain,poly_index) &&
+	   poly_has_surf( domain_poly( domain, poly_index ) ) )
+	{
+	  domain->topo[poly_index] = POLY_CUT;
+	  cut[ncut] = poly_index;
+	  ncut++;
+	}
+    }
+
+  status = KNIFE_SUCCESS;
+  nqueue = 0;
+  for ( icut = 0 ; KNIFE_SUCCESS == status && icut < ncut ; icut++ )
+    for ( it = adj_first(primal_cell_adj(primal), cut[icut]);
+	  KNIFE_SUCCESS == status && adj_valid(it);
+	  it = adj_next(it) )
+      {
+	cell = adj_item(it);
+	for ( cell_edge = 0 ; cell_edge < 6 ; cell_edge++ )
+	  {
+	    edge = primal_c2e(primal,cell,cell_edge);
+	    status = primal_edge( primal, edge, edge_nodes );
+	    if ( KNIFE_SUCCESS != status ) break;
+	    if ( cut[icut] != edge_nodes[0] && 
+		 cut[icut] != edge_nodes[1] ) continue;
+	    status = domain_topo_across_cut_edge( domain, edge, edge_nodes, 
+						  &exterior );
+	    if ( KNIFE_SUCCESS != status ) break;
+	    if ( EMPTY == exterior ) continue;
+	    domain->topo[exterior] = POLY_EXTERIOR;
+	    if ( exterior < npoly0 ) 
+	      {
+		queue[nqueue] = exterior;
+		nqueue++;
+	      }
+	  }
+      }
+  free( cut );
+  if ( KNIFE_SUCCESS != status )
+    {
+      free( queue );
+      return status;
+    }
+
+  if ( DOMAIN_TOPO_CLASSIFY == domain->topo_method )
+    {
+      free( queue );
+      return domain_classified_topology( domain );
+    }
+
+  for ( iqueue = 0 ; iqueue < nqueue ; iqueue++ )
+    for ( it = adj_first(primal_cell_adj(primal), queue[iqueue]);
+	  adj_valid(it);
+	  it = adj_next(it) )
+      {
+	cell = adj_item(it);
+	for ( cell_edge = 0 ; cell_edge < 6 ; cell_edge++ )
+	  {
+	    edge = primal_c2e(primal,cell,cell_edge);
+	    primal_edge( primal, edge, edge_nodes );
+	    if ( queue[iqueue] == edge_nodes[0] && 
+		 edge_nodes[1] < npoly0 &&
+		 POLY_INTERIOR == domain->topo[edge_nodes[1]] )
+	      {
+		domain->topo[edge_nodes[1]] = POLY_EXTERIOR;
+		queue[nqueue] = edge_nodes[1];
+		nqueue++;
+	      }
+	    if ( queue[iqueue] == edge_nodes[1] && 
+		 edge_nodes[0] < npoly0 &&
+		 POLY_INTERIOR == domain->topo[edge_nodes[0]] )
+	      {
+		domain->topo[edge_nodes[0]] = POLY_EXTERIOR;
+		queue[nqueue] = edge_nodes[0];
+		nqueue++;
+	      }
+	  }
+      }
+
+  free( queue );
+
+  if ( DOMAIN_TOPO_CHECK == domain->topo_method )
+    TRY( domain_check_topology( domain ), "domain_check_topology" );
+
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS domain_set_dual_topology( Domain domain )
+{
+  int poly_index;
+  int edge;
+  int edge_nodes[2];
+  POLY_TOPO topo0, topo1;
+  int exterior;
+
   KnifeBool requires_another_sweep;
 
   if (NULL == domain) return KNIFE_NULL;
 
+  /* left by domain_reset */
+  if ( NULL != domain->topo ) return domain_update_dual_topology( domain );
+
   domain->topo = (POLY_TOPO *)malloc( domain_npoly(domain) * sizeof(POLY_TOPO));
   NOT_NULL( domain->topo, "domain->topo NULL");
 
@@ -1411,37 +2442,16 @@ KNIFE_STATUS domain_set_dual_topology( Domain domain )
 
   for (edge = 0 ; edge < primal_nedge(domain->primal) ; edge++)
     {
-      node_index = edge + 
-	primal_ntri(domain->primal) + primal_ncell(domain->primal);
-      node = domain_node(domain,node_index);
       TRY( primal_edge( domain->primal, edge, edge_nodes), 
 	   "dual_topo cut int primal_edge" );
-      poly0 = domain_poly(domain,edge_nodes[0]);
-      poly1 = domain_poly(domain,edge_nodes[1]);
-      if ( NULL != poly0 && NULL != poly1 )
-	{
-	  topo0 = domain->topo[edge_nodes[0]];
-	  topo1 = domain->topo[edge_nodes[1]];
-
-	  if ( POLY_CUT == topo0 &&  
-	       ( POLY_INTERIOR == topo1 || POLY_GHOST == topo1 ) )
-	    {
-	      TRY( poly_mask_surrounding_node_activity( poly0, node,
-							&active ), "active01");
-	      if ( !active ) domain->topo[edge_nodes[1]] = POLY_EXTERIOR;
-	    }
-
-	  if ( POLY_CUT == topo1 && 
-	       ( POLY_INTERIOR == topo0 || POLY_GHOST == topo0 ) )
-	    {
-	      TRY( poly_mask_surrounding_node_activity( poly1, node,
-							&active ), "active10");
-	      if ( !active ) domain->topo[edge_nodes[0]] = POLY_EXTERIOR;
-	    }
-	}
-
+      TRY( domain_topo_across_cut_edge( domain, edge, edge_nodes, 
+					&exterior ), "across cut edge" );
+      if ( EMPTY != exterior ) domain->topo[exterior] = POLY_EXTERIOR;
     }
 
+  if ( DOMAIN_TOPO_CLASSIFY == domain->topo_method )
+    return domain_classified_topology( domain );
+
   requires_another_sweep = TRUE;
   while (requires_another_sweep) 
     {
@@ -1492,6 +2502,9 @@ KNIFE_STATUS domain_set_dual_topology( Domain domain )
       }
 
   }
+
+  if ( DOMAIN_TOPO_CHECK == domain->topo_method )
+    TRY( domain_check_topology( domain ), "domain_check_topology" );
   
   return KNIFE_SUCCESS;
 }
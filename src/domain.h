@@ -43,28 +43,60 @@ typedef int POLY_TOPO;
 #define POLY_INTERIOR (2)
 #define POLY_GHOST    (3)
 
+/* how domain_set_dual_topology finds the exterior polys that are not
+ * next to a cut poly: flood fill from the cut, the surface winding
+ * number of the primal node (domain_classify_nodes) or flood fill
+ * checked against the winding number */
+#define DOMAIN_TOPO_FLOOD    (0)
+#define DOMAIN_TOPO_CLASSIFY (1)
+#define DOMAIN_TOPO_CHECK    (2)
+
+/* dual elements are only materialized near the cut, so they are stored
+ * contiguously in fixed size blocks (pointers stay valid as the storage
+ * grows) and found through a remap from dual index to storage index */
+#define DOMAIN_BLOCK_SIZE (4096)
+
 struct DomainStruct {
   Primal primal;
 
   Surface surface;
 
   int nnode;
-  Node *node;
+  int *node_remap;
+  int nnode_used;
+  int nnode_block;
+  NodeStruct **node_block;
 
   int nsegment;
-  Segment *segment;
+  int *segment_remap;
+  int nsegment_used;
+  int nsegment_block;
+  SegmentStruct **segment_block;
 
   int ntriangle;
-  Triangle *triangle;
+  int *triangle_remap;
+  int ntriangle_used;
+  int ntriangle_block;
+  TriangleStruct **triangle_block;
 
   int npoly;
   Poly *poly;
 
   POLY_TOPO *topo;
+  int topo_method;
 
   int nside;
   int *f2s;
   int *s2fs;
+
+  /* primal edges whose sphere touched a surface triangle sphere in
+   * domain_required_local_dual, a cell is covered by the spheres of its
+   * edges so a cell with no near edge holds no surface */
+  KnifeBool *edge_near;
+
+  /* lookup tables only present while domain_dual_elements runs */
+  int *t2e;
+  int *f2t;
 };
 
 #define domain_test_malloc(ptr,fcn)		       \
@@ -76,19 +108,43 @@ struct DomainStruct {
 
 Domain domain_create( Primal, Surface );
 void domain_free( Domain );
+/* drop the dual and take a moved surface, keeping the topology as the
+ * starting point of the next domain_set_dual_topology */
+KNIFE_STATUS domain_reset( Domain domain, Surface surface );
 
 #define domain_primal(domain) ((domain)->primal)
 #define domain_surface(domain) ((domain)->surface)
 
+#define domain_block_item(block,used_index)			\
+  (&((block)[(used_index)/DOMAIN_BLOCK_SIZE][(used_index)%DOMAIN_BLOCK_SIZE]))
+
 #define domain_nnode(domain) ((domain)->nnode)
 Node domain_node( Domain, int node_index );
 Node domain_node_at_edge_center( Domain, int edge_index );
+#define domain_node_exists(domain,node_index)				\
+  ( NULL != (domain)->node_remap &&					\
+    EMPTY != (domain)->node_remap[(node_index)] )
+#define domain_nnode_used(domain) ((domain)->nnode_used)
+#define domain_used_node(domain,used_index)		\
+  domain_block_item((domain)->node_block,used_index)
 
 #define domain_nsegment(domain) ((domain)->nsegment)
 Segment domain_segment( Domain, int segment_index );
+#define domain_segment_exists(domain,segment_index)			\
+  ( NULL != (domain)->segment_remap &&					\
+    EMPTY != (domain)->segment_remap[(segment_index)] )
+#define domain_nsegment_used(domain) ((domain)->nsegment_used)
+#define domain_used_segment(domain,used_index)		\
+  domain_block_item((domain)->segment_block,used_index)
 
 #define domain_ntriangle(domain) ((domain)->ntriangle)
 Triangle domain_triangle( Domain, int triangle_index );
+#define domain_triangle_exists(domain,triangle_index)			\
+  ( NULL != (domain)->triangle_remap &&					\
+    EMPTY != (domain)->triangle_remap[(triangle_index)] )
+#define domain_ntriangle_used(domain) ((domain)->ntriangle_used)
+#define domain_used_triangle(domain,used_index)		\
+  domain_block_item((domain)->triangle_block,used_index)
 
 #define domain_npoly0(domain) (primal_nnode0(domain_primal(domain)))
 
@@ -120,11 +176,13 @@ KNIFE_STATUS domain_all_dual( Domain domain );
 KNIFE_STATUS domain_dual_elements( Domain domain );
 
 KNIFE_STATUS domain_boolean_subtract( Domain );
+KNIFE_STATUS domain_recut_moved( Domain, KnifeBool *moved, int *required );
 
 KNIFE_STATUS domain_triangulate( Domain );
 KNIFE_STATUS domain_gather_surf( Domain );
 KNIFE_STATUS domain_determine_active_subtri( Domain );
 KNIFE_STATUS domain_set_dual_topology( Domain );
+KNIFE_STATUS domain_classify_nodes( Domain, KnifeBool *exterior );
 
 KNIFE_STATUS domain_tecplot( Domain, char *filename );
 
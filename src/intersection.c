@@ -30,6 +30,7 @@
 #endif
 
 #include "intersection.h"
+#include "profile.h"
 
 #define TRY(fcn,msg)					      \
   {							      \
@@ -98,6 +99,8 @@ KNIFE_STATUS intersection_of( Triangle triangle, Segment segment,
   intersection->uvw[1] = uvw[1];
   intersection->uvw[2] = uvw[2];
 
+  profile_count( PROFILE_INTERSECTION, 1 );
+
   *returned_intersection = intersection;
 
   return KNIFE_SUCCESS;
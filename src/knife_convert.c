@@ -29,7 +29,7 @@ int main( int argc, char *argv[] )
 
   if ( 2 > argc ) 
     {
-      printf("usage : %s input.{fgrid|tri} [ faceId ... ]\n", argv[0] );
+      printf("usage : %s input.{fgrid|tri|snap} [ faceId ... ]\n", argv[0] );
       
       printf("\n");
       printf("Copyright 2007 United States Government as represented by the\n");
@@ -81,6 +81,9 @@ int main( int argc, char *argv[] )
   TSS( primal_export_fast( primal, NULL ), 
        "primal_export_fast failed in main")
 
+  TSS( primal_export_snapshot( primal, NULL ), 
+       "primal_export_snapshot failed in main")
+
   return 0;
 }
 
@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -40,6 +41,8 @@
 #include "triangle.h"
 #include "loop.h"
 #include "poly.h"
+#include "cache.h"
+#include "profile.h"
 
 #define TRY(fcn,msg)					      \
   {							      \
@@ -53,6 +56,7 @@
       *knife_status = code;				      \
       sprintf(surface_tecplot_filename,"surface%04d.t",partition);    \
       surface_export_tec( surface, surface_tecplot_filename );\
+      knife_shared_abandon( );				      \
       return;						      \
     }							      \
   }
@@ -62,6 +66,7 @@
     printf("%s: %d: %s\n",__FILE__,__LINE__,(msg));	\
     fflush(stdout);					\
     *knife_status = KNIFE_NULL;				\
+    knife_shared_abandon( );				\
     return;						\
   }
 
@@ -80,6 +85,301 @@ static Primal  volume_primal  = NULL;
 static Domain  domain         = NULL;
 static int partition = EMPTY;
 
+/* the surface primal of "shared <name>" in the knife input file is
+ * read and transformed by one process of the node and mapped read
+ * only by the rest */
+static char shared_surface_name[1025] = "";
+static KnifeBool shared_surface_creator = FALSE;
+static KnifeBool shared_surface_published = FALSE;
+
+/* seconds the other processes wait for the creator, "shared_wait" */
+#define KNIFE_SHARED_WAIT (60.0)
+
+/* a creator that fails before primal_publish lets the others go */
+static void knife_shared_abandon( void )
+{
+  if ( !shared_surface_creator || shared_surface_published ) return;
+  primal_abandon( shared_surface_name );
+  shared_surface_creator = FALSE;
+}
+
+/* shared_surface_name and wait from the knife input file and the key of
+ * the shared geometry: the surface file and the transform keywords with
+ * their arguments, in order, the files with their size and time */
+static void knife_shared_scan( FILE *f, 
+			       unsigned long long *key, double *wait )
+{
+  char string[1025];
+  int narg, arg;
+  KnifeBool file_arg;
+
+  shared_surface_name[0] = '\0';
+  *key = CACHE_HASH_START;
+  *wait = KNIFE_SHARED_WAIT;
+
+  while ( 1 == fscanf( f, "%s", string ) )
+    {
+      if ( CACHE_HASH_START == *key )
+	{
+	  *key = cache_hash_file( *key, string );
+	  continue;
+	}
+      if( strcmp(string,"faces") == 0 ) break;
+      if( strcmp(string,"shared") == 0 ) 
+	{
+	  fscanf( f, "%s", shared_surface_name );
+	  continue;
+	}
+      if( strcmp(string,"shared_wait") == 0 ) 
+	{
+	  fscanf( f, "%lf", wait );
+	  continue;
+	}
+      narg = EMPTY;
+      if( strcmp(string,"translate") == 0 ) narg = 3;
+      if( strcmp(string,"rotate") == 0 ) narg = 4;
+      if( strcmp(string,"scale") == 0 ) narg = 1;
+      if( strcmp(string,"flip_yz") == 0 ) narg = 0;
+      if( strcmp(string,"flip_zy") == 0 ) narg = 0;
+      if( strcmp(string,"reflect_y") == 0 ) narg = 0;
+      if( strcmp(string,"massoud") == 0 ) narg = 1;
+      if ( EMPTY == narg ) continue;
+      file_arg = ( strcmp(string,"massoud") == 0 );
+      *key = cache_hash( *key, string, strlen(string)+1 );
+      for ( arg = 0 ; arg < narg && 1 == fscanf( f, "%s", string ) ; arg++ )
+	if ( file_arg ) 
+	  *key = cache_hash_file( *key, string );
+	else
+	  *key = cache_hash( *key, string, strlen(string)+1 );
+    }
+
+  rewind( f );
+}
+
+/* cut results are read from and written to cache_directory when the
+ * knife input file names one */
+static char cache_directory[1025] = "";
+static unsigned long long cache_key = 0;
+static Cache cache = NULL;
+
+/* phase times and counters of the cut are written to
+ * knife_profile<partition>.json when the knife input file says profile */
+static KnifeBool profile_cut = FALSE;
+
+/* knife_move_surface already cut again near the moved surface nodes,
+ * so the knife_cut that follows keeps that cut */
+static KnifeBool surface_recut = FALSE;
+
+/* how the surface is built from surface_primal, kept so a moved
+ * surface is rebuilt the same way by knife_move_surface */
+static Set surface_bcs = NULL;
+static KnifeBool surface_inward = FALSE;
+static KnifeBool surface_cull = FALSE;
+static double surface_cull_margin = 0.0;
+
+/* the cache holds the topology, so the way it was found is in the key */
+static int cut_topo_method = DOMAIN_TOPO_FLOOD;
+
+/* the subtri of the last count query, kept so the fill query that
+ * follows it copies them instead of walking the poly again */
+static int scratch_kind = EMPTY;
+static int scratch_key[4];
+static int scratch_nsubtri = 0;
+static int scratch_max = 0;
+static double *scratch_xyz = NULL;
+static int *scratch_tag = NULL;
+
+/* record answering a query in cache, EMPTY to ask the domain.  Sets
+ * knife_status to the recorded status, or to KNIFE_NOT_FOUND when a
+ * cut poly is missing from the cache (the domain was not cut) */
+static int knife_cached( int kind, int a, int b, int c, int d, 
+			 int *knife_status )
+{
+  int record;
+
+  *knife_status = KNIFE_SUCCESS;
+  if ( NULL == cache ) return EMPTY;
+
+  record = cache_find( cache, kind, a, b, c, d );
+  if ( EMPTY != record )
+    {
+      *knife_status = cache_status( cache, record );
+      return record;
+    }
+
+  if ( cache_cut( cache, a ) || 
+       ( CACHE_BETWEEN <= kind && cache_cut( cache, c ) ) )
+    {
+      printf("%s: %d: kind %d of poly %d region %d not in cache\n",
+	     __FILE__,__LINE__,kind,a+1,b);
+      fflush(stdout);
+      *knife_status = KNIFE_NOT_FOUND;
+    }
+
+  return EMPTY;
+}
+
+/* n subtri packed as node0, node1, node2, normal and area blocks of
+ * stride subtri each */
+static void knife_copy_subtri( double *d, int stride, int n,
+			       double *triangle_node0,
+			       double *triangle_node1,
+			       double *triangle_node2,
+			       double *triangle_normal,
+			       double *triangle_area )
+{
+  memcpy( triangle_node0,  &d[0],         3*n*sizeof(double) );
+  memcpy( triangle_node1,  &d[3*stride],  3*n*sizeof(double) );
+  memcpy( triangle_node2,  &d[6*stride],  3*n*sizeof(double) );
+  memcpy( triangle_normal, &d[9*stride],  3*n*sizeof(double) );
+  memcpy( triangle_area,   &d[12*stride], n*sizeof(double) );
+}
+
+static KNIFE_STATUS knife_cached_subtri( int record, int nsubtri,
+					 double *triangle_node0,
+					 double *triangle_node1,
+					 double *triangle_node2,
+					 double *triangle_normal,
+					 double *triangle_area )
+{
+  int n;
+  double *d;
+
+  n = cache_ndouble( cache, record ) / 13;
+  if ( n > nsubtri ) 
+    {
+      printf("%s: %d: too many subtri found for argument\n",
+	     __FILE__,__LINE__);
+      return KNIFE_ARRAY_BOUND;
+    }
+  d = cache_doubles( cache, record );
+  knife_copy_subtri( d, n, n,
+		     triangle_node0, triangle_node1, triangle_node2,
+		     triangle_normal, triangle_area );
+
+  return KNIFE_SUCCESS;
+}
+
+static KNIFE_STATUS knife_cached_sens( int record, int nsubtri, 
+				       int ints_per_subtri,
+				       int *parent_int, double *parent_xyz )
+{
+  int n;
+
+  n = cache_nint( cache, record ) / ints_per_subtri;
+  if ( n > nsubtri ) 
+    {
+      printf("%s: %d: too many subtri found for argument\n",
+	     __FILE__,__LINE__);
+      return KNIFE_ARRAY_BOUND;
+    }
+  memcpy( parent_int, cache_ints( cache, record ), 
+	  cache_nint( cache, record )*sizeof(int) );
+  memcpy( parent_xyz, cache_doubles( cache, record ), 
+	  cache_ndouble( cache, record )*sizeof(double) );
+
+  return KNIFE_SUCCESS;
+}
+
+static KNIFE_STATUS knife_scratch_grow( int max_subtri )
+{
+  free( scratch_tag );
+  free( scratch_xyz );
+  scratch_max = max_subtri;
+  scratch_xyz = (double *)malloc( 13*scratch_max*sizeof(double) );
+  scratch_tag = (int *)malloc( scratch_max*sizeof(int) );
+  if ( NULL == scratch_xyz || NULL == scratch_tag )
+    {
+      free( scratch_tag );
+      free( scratch_xyz );
+      scratch_tag = NULL;
+      scratch_xyz = NULL;
+      scratch_max = 0;
+      printf("%s: %d: malloc failed in knife_scratch_grow\n",
+	     __FILE__,__LINE__);
+      return KNIFE_MEMORY;
+    }
+  return KNIFE_SUCCESS;
+}
+
+/* walk poly1 (and poly2 for CACHE_BETWEEN) once into the scratch,
+ * growing it and walking again only when it was too small.  The key
+ * a, b, c, d is that of the cache record of kind */
+static KNIFE_STATUS knife_scratch_subtri( int kind, int a, int b, int c, int d,
+					  Poly poly1, Poly poly2, Node node )
+{
+  int n, max_subtri;
+  double *xyz;
+  KNIFE_STATUS status;
+
+  scratch_kind = EMPTY;
+  if ( 0 == scratch_max ) 
+    {
+      status = knife_scratch_grow( 1024 );
+      if ( KNIFE_SUCCESS != status ) return status;
+    }
+
+  do
+    {
+      max_subtri = scratch_max;
+      xyz = scratch_xyz;
+      switch ( kind )
+	{
+	case CACHE_SURFACE:
+	  status = poly_surface_subtri_upto( poly1, b, max_subtri, &n,
+					     &xyz[0], &xyz[3*max_subtri], 
+					     &xyz[6*max_subtri], 
+					     &xyz[9*max_subtri], 
+					     &xyz[12*max_subtri], 
+					     scratch_tag );
+	  break;
+	case CACHE_BOUNDARY:
+	  status = poly_boundary_subtri_upto( poly1, c, b, max_subtri, &n,
+					      &xyz[0], &xyz[3*max_subtri], 
+					      &xyz[6*max_subtri], 
+					      &xyz[9*max_subtri], 
+					      &xyz[12*max_subtri] );
+	  break;
+	case CACHE_BETWEEN:
+	  status = poly_subtri_between_upto( poly1, b, poly2, d, 
+					     node, max_subtri, &n,
+					     &xyz[0], &xyz[3*max_subtri], 
+					     &xyz[6*max_subtri], 
+					     &xyz[9*max_subtri], 
+					     &xyz[12*max_subtri] );
+	  break;
+	default:
+	  status = KNIFE_IMPLEMENT;
+	}
+      if ( KNIFE_SUCCESS != status ) return status;
+      if ( n > scratch_max )
+	{
+	  status = knife_scratch_grow( 2*n );
+	  if ( KNIFE_SUCCESS != status ) return status;
+	}
+    }
+  while ( n > max_subtri );
+
+  scratch_kind = kind;
+  scratch_key[0] = a;
+  scratch_key[1] = b;
+  scratch_key[2] = c;
+  scratch_key[3] = d;
+  scratch_nsubtri = n;
+
+  return KNIFE_SUCCESS;
+}
+
+/* the scratch holds the nsubtri subtri of this query */
+static KnifeBool knife_scratch_holds( int kind, int a, int b, int c, int d,
+				      int nsubtri )
+{
+  return (KnifeBool)( kind == scratch_kind && 
+		      a == scratch_key[0] && b == scratch_key[1] &&
+		      c == scratch_key[2] && d == scratch_key[3] &&
+		      nsubtri == scratch_nsubtri );
+}
+
 void FC_FUNC_(knife_volume,KNIFE_VOLUME)
   ( int *part_id,
     int *nnode0, int *nnode, double *x, double *y, double *z,
@@ -129,6 +429,76 @@ void FC_FUNC_(knife_boundary,KNIFE_BOUNDARY)
   *knife_status = KNIFE_SUCCESS;
 }
 
+/* surface of surface_primal from the surface_ statics, culled to the
+ * faces near this partition when asked */
+static KNIFE_STATUS knife_build_surface( Surface *built )
+{
+  double lower[3], upper[3], margin;
+  KNIFE_STATUS status;
+
+  *built = NULL;
+
+  /* keep only the faces near this partition, surface_cull_margin is a
+   * fraction of the partition bounding box diagonal */
+  if ( surface_cull )
+    {
+      status = primal_bounding_box( volume_primal, lower, upper );
+      if ( KNIFE_SUCCESS != status ) return status;
+      margin = surface_cull_margin * 
+	sqrt( (upper[0]-lower[0])*(upper[0]-lower[0]) +
+	      (upper[1]-lower[1])*(upper[1]-lower[1]) +
+	      (upper[2]-lower[2])*(upper[2]-lower[2]) );
+      lower[0] -= margin; lower[1] -= margin; lower[2] -= margin;
+      upper[0] += margin; upper[1] += margin; upper[2] += margin;
+      *built = surface_from_box( surface_primal, surface_bcs, 
+				 surface_inward, lower, upper );
+      if ( NULL == *built ) return KNIFE_NULL;
+      /* nothing nearby, cut against all of it like an uncull run */
+      if ( 0 == surface_ntriangle(*built) )
+	{
+	  surface_free( *built );
+	  *built = NULL;
+	}
+    }
+  if ( NULL == *built )
+    *built = surface_from( surface_primal, surface_bcs, surface_inward );
+  if ( NULL == *built ) return KNIFE_NULL;
+
+  return KNIFE_SUCCESS;
+}
+
+/* cache_key of everything but the required dual, which knife_cut adds */
+static void knife_surface_cache_key( void )
+{
+  int item, bc;
+
+  cache_key = CACHE_HASH_START;
+  cache_key = cache_hash( cache_key, &partition, sizeof(int) );
+  cache_key = cache_hash_primal( cache_key, volume_primal );
+  cache_key = cache_hash_primal( cache_key, surface_primal );
+  cache_key = cache_hash( cache_key, &surface_inward, sizeof(KnifeBool) );
+  cache_key = cache_hash( cache_key, &surface_cull, sizeof(KnifeBool) );
+  cache_key = cache_hash( cache_key, &surface_cull_margin, sizeof(double) );
+  cache_key = cache_hash( cache_key, &cut_topo_method, sizeof(int) );
+  for ( item = 0 ; item < set_size(surface_bcs) ; item++ )
+    {
+      bc = set_item(surface_bcs,item);
+      cache_key = cache_hash( cache_key, &bc, sizeof(int) );
+    }
+}
+
+/* the profile of everything since knife_required_local_dual */
+static void knife_profile_export( void )
+{
+  char profile_file_name[1025];
+
+  if ( !profile_cut ) return;
+  sprintf( profile_file_name, "knife_profile%04d.json", partition );
+  if ( KNIFE_SUCCESS != profile_json( profile_file_name, partition ) )
+    printf("%s: %d: profile not written, continuing\n",
+	   __FILE__,__LINE__);
+}
+
 void FC_FUNC_(knife_required_local_dual,KNIFE_REQUIRED_LOCAL_DUAL)
   ( char *knife_input_file_name, 
     int *nodedim, int *required,
@@ -142,9 +512,20 @@ void FC_FUNC_(knife_required_local_dual,KNIFE_REQUIRED_LOCAL_DUAL)
   Set bcs;
   int bc, bc_found;
   int end_of_string;
+  KnifeBool transform_surface;
+  KnifeBool cull_surface;
+  double cull_margin;
+  int topo_method;
+  unsigned long long shared_key;
+  double shared_wait;
 
   logger_message( FORTRAN_LOGGER_LEVEL, "req loc dual");
 
+  cache_directory[0] = '\0';
+  profile_cut = FALSE;
+  surface_recut = FALSE;
+  profile_reset( );
+
   if ( *nodedim != primal_nnode(volume_primal)  )
     {
       printf("%s: %d: knife_required_local_dual_ wrong nnode %d %d\n",
@@ -158,16 +539,31 @@ void FC_FUNC_(knife_required_local_dual,KNIFE_REQUIRED_LOCAL_DUAL)
   if ( NULL == f ) printf("filename: %s\n",knife_input_file_name);
   NOT_NULL(f , "could not open knife_input_file_name");
 
+  knife_shared_scan( f, &shared_key, &shared_wait );
+
   fscanf( f, "%s\n", surface_filename);
   end_of_string = strlen(surface_filename);
 
-  surface_primal = primal_from_file(surface_filename);
+  surface_primal = NULL;
+  shared_surface_creator = FALSE;
+  shared_surface_published = FALSE;
+  if ( '\0' != shared_surface_name[0] )
+    surface_primal = primal_attach( shared_surface_name, 
+				    shared_key, shared_wait,
+				    &shared_surface_creator );
+  transform_surface = (NULL == surface_primal);
+
+  if ( NULL == surface_primal ) 
+    surface_primal = primal_from_file(surface_filename);
   if ( NULL == surface_primal ) 
     printf("surface filename: %s\n",surface_filename);
   NOT_NULL(surface_primal, "surface_primal NULL");
   
   inward_pointing_surface_normal = FALSE;
   read_faces = FALSE;
+  cull_surface = FALSE;
+  cull_margin = 0.0;
+  topo_method = DOMAIN_TOPO_FLOOD;
 
   while ( !( feof( f ) || read_faces ) )
     {
@@ -185,44 +581,100 @@ void FC_FUNC_(knife_required_local_dual,KNIFE_REQUIRED_LOCAL_DUAL)
       }
       if( strcmp(string,"translate") == 0 ) {
 	fscanf( f, "%lf %lf %lf\n", &dx, &dy, &dz );
-	TRY( primal_translate( surface_primal, dx, dy, dz ), 
-	     "primal_translate error" );
+	if ( transform_surface )
+	  TRY( primal_translate( surface_primal, dx, dy, dz ), 
+	       "primal_translate error" );
       }
 #define KNIFE_CONVERT_DEGREE_TO_RADIAN(degree) ((degree)*0.0174532925199433)
       if( strcmp(string,"rotate") == 0 ) {
 	fscanf( f, "%lf %lf %lf %lf\n", &dx, &dy, &dz, &angle );
 	angle = KNIFE_CONVERT_DEGREE_TO_RADIAN(angle);
-	TRY( primal_rotate( surface_primal, dx, dy, dz, angle ), 
-	     "primal_translate error" );
+	if ( transform_surface )
+	  TRY( primal_rotate( surface_primal, dx, dy, dz, angle ), 
+	       "primal_translate error" );
       }
       if( strcmp(string,"scale") == 0 ) {
 	fscanf( f, "%lf\n", &scale );
-	TRY( primal_scale_about( surface_primal, 0.0, 0.0, 0.0, scale ), 
-	     "primal_scale_about error" );
+	if ( transform_surface )
+	  TRY( primal_scale_about( surface_primal, 0.0, 0.0, 0.0, scale ), 
+	       "primal_scale_about error" );
       }
       if( strcmp(string,"flip_yz") == 0 ) {
-	TRY( primal_flip_yz( surface_primal ), 
-	     "primal_flip_yz error" );
+	if ( transform_surface )
+	  TRY( primal_flip_yz( surface_primal ), 
+	       "primal_flip_yz error" );
       }
       if( strcmp(string,"flip_zy") == 0 ) {
-	TRY( primal_flip_zy( surface_primal ), 
-	     "primal_flip_zy error" );
+	if ( transform_surface )
+	  TRY( primal_flip_zy( surface_primal ), 
+	       "primal_flip_zy error" );
       }
       if( strcmp(string,"reflect_y") == 0 ) {
-	TRY( primal_reflect_y( surface_primal ), 
-	     "primal_reflect_y error" );
+	if ( transform_surface )
+	  TRY( primal_reflect_y( surface_primal ), 
+	       "primal_reflect_y error" );
       }
       if( strcmp(string,"massoud") == 0 ) {
 	fscanf( f, "%s\n", massoud_filename );
-	TRY( primal_apply_massoud( surface_primal, massoud_filename, 
-				   (0 == partition) ),
-	     "primal_apply_massoud error" );
+	if ( transform_surface )
+	  TRY( primal_apply_massoud( surface_primal, massoud_filename, 
+				     (0 == partition) ),
+	       "primal_apply_massoud error" );
+      }
+      if( strcmp(string,"shared") == 0 ) {
+	fscanf( f, "%s\n", shared_surface_name );
+      }
+      if( strcmp(string,"shared_wait") == 0 ) {
+	fscanf( f, "%lf\n", &shared_wait );
+      }
+      if( strcmp(string,"cull") == 0 ) {
+	fscanf( f, "%lf\n", &cull_margin );
+	cull_surface = TRUE;
+      }
+      if( strcmp(string,"cache") == 0 ) {
+	fscanf( f, "%s\n", cache_directory );
+      }
+      if( strcmp(string,"classify") == 0 ) {
+	topo_method = DOMAIN_TOPO_CLASSIFY;
+      }
+      if( strcmp(string,"classify_check") == 0 ) {
+	topo_method = DOMAIN_TOPO_CHECK;
+      }
+      if( strcmp(string,"profile") == 0 ) {
+	profile_cut = TRUE;
+      }
+      if( strcmp(string,"single_cut_check") == 0 ) {
+	triangle_set_single_cut_check( TRUE );
+      }
+      if( strcmp(string,"cdt_check") == 0 ) {
+	triangle_set_cdt_check( TRUE );
       }
       if( strcmp(string,"faces") == 0 ) {
 	read_faces = TRUE;
       }
     }
 
+  if ( shared_surface_creator )
+    {
+      Primal shared_primal;
+      KnifeBool creator;
+      shared_primal = NULL;
+      if ( KNIFE_SUCCESS == primal_publish( surface_primal, 
+					    shared_surface_name, shared_key ) )
+	{
+	  shared_surface_published = TRUE;
+	  shared_primal = primal_attach( shared_surface_name, 
+					 shared_key, shared_wait, &creator );
+	}
+      else
+	knife_shared_abandon( );
+      if ( NULL != shared_primal )
+	{
+	  primal_free( surface_primal );
+	  surface_primal = shared_primal;
+	}
+    }
+
   if ( read_faces )
     {
       bcs = set_create(10,10);
@@ -246,9 +698,22 @@ void FC_FUNC_(knife_required_local_dual,KNIFE_REQUIRED_LOCAL_DUAL)
       bcs = NULL;
     }
 
-  surface = surface_from( surface_primal, bcs, 
-			  inward_pointing_surface_normal );
-  NOT_NULL(surface, "surface NULL");
+  /* the winding number needs the closed surface, not a culled piece */
+  if ( cull_surface && DOMAIN_TOPO_FLOOD != topo_method )
+    {
+      if ( 0 == partition )
+	printf("classify ignored with cull, using the flood fill\n");
+      topo_method = DOMAIN_TOPO_FLOOD;
+    }
+
+  set_free( surface_bcs );
+  surface_bcs = bcs;
+  surface_inward = inward_pointing_surface_normal;
+  surface_cull = cull_surface;
+  surface_cull_margin = cull_margin;
+  cut_topo_method = topo_method;
+
+  TRY( knife_build_surface( &surface ), "knife_build_surface" );
   if ( 0 == surface_ntriangle(surface) )
     {
       printf("giving up in knife_required_local_dual, surface has no faces\n");
@@ -256,10 +721,13 @@ void FC_FUNC_(knife_required_local_dual,KNIFE_REQUIRED_LOCAL_DUAL)
       return;
     }
 
+  if ( '\0' != cache_directory[0] ) knife_surface_cache_key( );
+
   TRY( primal_establish_all( volume_primal ), "primal_establish_all" );
 
   domain = domain_create( volume_primal, surface );
   NOT_NULL(domain, "domain NULL");
+  domain->topo_method = topo_method;
 
   TRY( domain_required_local_dual( domain, required ), 
        "domain_required_local_dual" );
@@ -267,11 +735,176 @@ void FC_FUNC_(knife_required_local_dual,KNIFE_REQUIRED_LOCAL_DUAL)
   *knife_status = KNIFE_SUCCESS;
 }
 
+/* move the surface nodes to x, y, z (a rigid motion or any other that
+ * keeps the surface connectivity) and prepare the required dual for the
+ * knife_cut that follows.  The last cut is kept away from the moved
+ * nodes and only cut again near them, as knife_massoud does.  The
+ * surface is rebuilt and the domain cut in full from the topology of
+ * the last cut when the surface was culled or the last cut came from
+ * the cache */
+void FC_FUNC_(knife_move_surface,KNIFE_MOVE_SURFACE)
+  ( int *nnode, double *x, double *y, double *z,
+    int *nodedim, int *required,
+    int *knife_status )
+{
+  Surface moved;
+  KnifeBool *moved_node;
+  KNIFE_STATUS status;
+  KnifeBool cut_from_cache;
+
+  logger_message( FORTRAN_LOGGER_LEVEL, "move surface");
+
+  profile_reset( );
+
+  NOT_NULL( domain, "knife_move_surface_ before knife_required_local_dual_");
+  NOT_NULL( surface_primal, "surface_primal NULL");
+
+  if ( *nnode != primal_nnode(surface_primal) )
+    {
+      printf("%s: %d: knife_move_surface_ wrong surface nnode %d %d\n",
+	     __FILE__,__LINE__,*nnode,primal_nnode(surface_primal));
+      *knife_status = KNIFE_ARRAY_BOUND;
+      return;
+    }
+  if ( *nodedim != primal_nnode(volume_primal) )
+    {
+      printf("%s: %d: knife_move_surface_ wrong nnode %d %d\n",
+	     __FILE__,__LINE__,*nodedim,primal_nnode(volume_primal));
+      *knife_status = KNIFE_ARRAY_BOUND;
+      return;
+    }
+
+  TRY( primal_copy_xyz( surface_primal, x, y, z ), "primal_copy_xyz" );
+
+  /* the results of the last cut no longer answer queries */
+  cut_from_cache = ( NULL != cache );
+  scratch_kind = EMPTY;
+  cache_free( cache );
+  cache = NULL;
+  if ( '\0' != cache_directory[0] ) knife_surface_cache_key( );
+
+  surface_recut = FALSE;
+  if ( !surface_cull && !cut_from_cache && 
+       NULL != domain->poly && NULL != domain->topo )
+    {
+      moved_node = (KnifeBool *)malloc( MAX(surface_nnode(surface),1) * 
+					sizeof(KnifeBool) );
+      NOT_NULL( moved_node, "moved_node NULL" );
+      status = surface_update_xyz( surface, surface_primal, moved_node );
+      if ( KNIFE_SUCCESS == status )
+	status = domain_recut_moved( domain, moved_node, required );
+      free( moved_node );
+      TRY( status, "recut moved surface" );
+      surface_recut = TRUE;
+      *knife_status = KNIFE_SUCCESS;
+      return;
+    }
+
+  TRY( knife_build_surface( &moved ), "knife_build_surface" );
+  if ( 0 == surface_ntriangle(moved) )
+    {
+      printf("giving up in knife_move_surface, surface has no faces\n");
+      surface_free( moved );
+      *knife_status = KNIFE_NOT_FOUND;
+      return;
+    }
+
+  TRY( domain_reset( domain, moved ), "domain_reset" );
+  surface_free( surface );
+  surface = moved;
+
+  TRY( domain_required_local_dual( domain, required ), 
+       "domain_required_local_dual" );
+
+  *knife_status = KNIFE_SUCCESS;
+}
+
+/* apply the massoud file of the next design iteration to the surface
+ * and cut again, only near the surface triangles it moved.  The
+ * surface is rebuilt and cut in full when it was culled (moved faces
+ * may enter the partition) or the last cut came from the cache (there
+ * are no cuts to keep).  required is set as by knife_required_local_dual
+ * and knife_cut is not called after this. */
+void FC_FUNC_(knife_massoud,KNIFE_MASSOUD)
+  ( char *massoud_filename, 
+    int *nodedim, int *required,
+    int *knife_status )
+{
+  KnifeBool *moved;
+  KnifeBool cut_from_cache;
+  KNIFE_STATUS status;
+  Surface rebuilt;
+
+  logger_message( FORTRAN_LOGGER_LEVEL, "massoud");
+
+  profile_reset( );
+  surface_recut = FALSE;
+
+  NOT_NULL( domain, "knife_massoud_ before knife_cut_");
+  NOT_NULL( surface_primal, "surface_primal NULL");
+
+  if ( *nodedim != primal_nnode(volume_primal) )
+    {
+      printf("%s: %d: knife_massoud_ wrong nnode %d %d\n",
+	     __FILE__,__LINE__,*nodedim,primal_nnode(volume_primal));
+      *knife_status = KNIFE_ARRAY_BOUND;
+      return;
+    }
+  if ( NULL != surface_primal->shared )
+    {
+      printf("%s: %d: knife_massoud_ shared surface is read only\n",
+	     __FILE__,__LINE__);
+      *knife_status = KNIFE_IMPLEMENT;
+      return;
+    }
+
+  TRY( primal_apply_massoud( surface_primal, massoud_filename, 
+			     (0 == partition) ),
+       "primal_apply_massoud error" );
+
+  /* the results of the last cut no longer answer queries */
+  cut_from_cache = ( NULL != cache );
+  scratch_kind = EMPTY;
+  cache_free( cache );
+  cache = NULL;
+  if ( '\0' != cache_directory[0] ) knife_surface_cache_key( );
+
+  if ( surface_cull || cut_from_cache )
+    {
+      TRY( knife_build_surface( &rebuilt ), "knife_build_surface" );
+      TRY( domain_reset( domain, rebuilt ), "domain_reset" );
+      surface_free( surface );
+      surface = rebuilt;
+      TRY( domain_required_local_dual( domain, required ), 
+	   "domain_required_local_dual" );
+      TRY( domain_create_dual( domain, required ), "domain_create_dual" );
+      TRY( domain_boolean_subtract( domain ), "boolean subtract" );
+      knife_profile_export( );
+      *knife_status = KNIFE_SUCCESS;
+      return;
+    }
+
+  moved = (KnifeBool *)malloc( MAX(surface_nnode(surface),1) * 
+			       sizeof(KnifeBool) );
+  NOT_NULL( moved, "moved NULL" );
+  status = surface_update_xyz( surface, surface_primal, moved );
+  if ( KNIFE_SUCCESS == status )
+    status = domain_recut_moved( domain, moved, required );
+  free( moved );
+  TRY( status, "recut massoud surface" );
+
+  knife_profile_export( );
+
+  *knife_status = KNIFE_SUCCESS;
+}
+
 void FC_FUNC_(knife_cut,KNIFE_CUT)
   ( int *nodedim, int *required,
     int *knife_status )
 {
   char tecplot_file_name[1025];
+  char cache_file_name[1025];
+  unsigned long long key = 0;
   if ( *nodedim != primal_nnode(volume_primal) )
     {
       printf("%s: %d: knife_cut_ wrong nnode %d %d\n",
@@ -280,13 +913,61 @@ void FC_FUNC_(knife_cut,KNIFE_CUT)
       return;
     }
 
-  logger_message( FORTRAN_LOGGER_LEVEL, "create_dual");
+  scratch_kind = EMPTY;
 
-  TRY( domain_create_dual( domain, required ), "domain_required_local_dual" );
+  cache_free( cache );
+  cache = NULL;
+  if ( '\0' != cache_directory[0] )
+    {
+      key = cache_hash( cache_key, required, 
+			(size_t)(*nodedim)*sizeof(int) );
+      TRY( cache_filename( cache_directory, partition, key, 
+			   cache_file_name ), "cache_filename" );
+      if ( !surface_recut ) cache = cache_from_file( cache_file_name, key );
+    }
+
+  if ( surface_recut )
+    {
+      logger_message( FORTRAN_LOGGER_LEVEL, "recut");
+      surface_recut = FALSE;
+    }
+  else
+    {
+      logger_message( FORTRAN_LOGGER_LEVEL, "create_dual");
 
-  logger_message( FORTRAN_LOGGER_LEVEL, "subtract");
+      TRY( domain_create_dual( domain, required ), 
+	   "domain_required_local_dual" );
 
-  TRY( domain_boolean_subtract( domain ), "boolean subtract" );
+      if ( NULL != cache )
+	{
+	  logger_message( FORTRAN_LOGGER_LEVEL, "cached");
+	  TRY( domain_dual_elements( domain ), "domain_dual_elements" );
+	  TRY( cache_restore_topo( cache, domain ), "cache_restore_topo" );
+	  knife_profile_export( );
+	  *knife_status = KNIFE_SUCCESS;
+	  return;
+	}
+
+      logger_message( FORTRAN_LOGGER_LEVEL, "subtract");
+
+      TRY( domain_boolean_subtract( domain ), "boolean subtract" );
+    }
+
+  knife_profile_export( );
+
+  if ( '\0' != cache_directory[0] )
+    {
+      logger_message( FORTRAN_LOGGER_LEVEL, "cache");
+      cache = cache_create( );
+      NOT_NULL( cache, "cache NULL" );
+      cache->key = key;
+      TRY( cache_gather( cache, domain ), "cache_gather" );
+      if ( KNIFE_SUCCESS != cache_export( cache, cache_file_name ) )
+	printf("%s: %d: cut results not cached, continuing\n",
+	       __FILE__,__LINE__);
+      cache_free( cache );
+      cache = NULL;
+    }
 
   if (FALSE) 
     {
@@ -330,12 +1011,22 @@ void FC_FUNC_(knife_make_dual_required,KNIFE_MAKE_DUAL_REQUIRED)
   if ( NULL != domain_poly(domain,(*node)-1) ) return;
   TRY( domain_add_interior_poly( domain, (*node)-1 ), 
        "domain_add_interior_poly" );
+  scratch_kind = EMPTY;
 }
 
 void FC_FUNC_(knife_dual_regions,KNIFE_DUAL_REGIONS)
   ( int *node, int *regions, int *knife_status )
 {
   Poly poly;
+  int record;
+
+  record = knife_cached( CACHE_REGIONS, (*node)-1, 0, 0, 0, knife_status );
+  if ( KNIFE_SUCCESS != *knife_status ) return;
+  if ( EMPTY != record )
+    {
+      *regions = cache_ints( cache, record )[0];
+      return;
+    }
 
   poly = domain_poly( domain, (*node)-1 );
   NOT_NULL( poly, "poly NULL in knife_dual_regions_");
@@ -353,6 +1044,19 @@ void FC_FUNC_(knife_poly_centroid_volume,KNIFE_POLY_CENTRIOD_VOLUME)
 {
   double xyz[3], center[3];
   Poly poly;
+  int record;
+
+  record = knife_cached( CACHE_CENTROID_VOLUME, (*node)-1, *region, 0, 0, 
+			 knife_status );
+  if ( EMPTY != record )
+    {
+      *x = cache_doubles( cache, record )[0];
+      *y = cache_doubles( cache, record )[1];
+      *z = cache_doubles( cache, record )[2];
+      *volume = cache_doubles( cache, record )[3];
+      return;
+    }
+  if ( KNIFE_SUCCESS != *knife_status ) return;
 
   TRY( primal_xyz(domain_primal(domain),(*node)-1,xyz), "primal_xyz" );
 
@@ -376,10 +1080,19 @@ void FC_FUNC_(knife_ntriangles_between_poly,KNIFE_NTRIANGLES_BETWEEN_POLY)
     int *nsubtri,
     int *knife_status )
 {
-  int n;
   int edge;
   Poly poly1, poly2;
   Node node;
+  int record;
+
+  record = knife_cached( CACHE_BETWEEN, (*node1)-1, *region1, 
+			 (*node2)-1, *region2, knife_status );
+  if ( KNIFE_SUCCESS != *knife_status ) return;
+  if ( EMPTY != record )
+    {
+      *nsubtri = cache_ndouble( cache, record ) / 13;
+      return;
+    }
 
   TRY( primal_find_edge( volume_primal, (*node1)-1, (*node2)-1, &edge ), 
        "no edge found by primal_edge_between"); 
@@ -407,10 +1120,11 @@ void FC_FUNC_(knife_ntriangles_between_poly,KNIFE_NTRIANGLES_BETWEEN_POLY)
     }
   NOT_NULL( poly2, "poly2 NULL in knife_ntriangles_between_poly_");
 
-  TRY( poly_nsubtri_between( poly1, *region1, poly2, *region2, node, &n ), 
-       "poly_nsubtri_between" );
+  TRY( knife_scratch_subtri( CACHE_BETWEEN, (*node1)-1, *region1, 
+			      (*node2)-1, *region2, poly1, poly2, node ), 
+       "knife_scratch_subtri" );
   
-  *nsubtri = n;
+  *nsubtri = scratch_nsubtri;
   *knife_status = KNIFE_SUCCESS;
 }
 
@@ -428,6 +1142,28 @@ void FC_FUNC_(knife_triangles_between_poly,KNIFE_TRIANGLES_BETWEEN_POLY)
   int edge;
   Poly poly1, poly2;
   Node node;
+  int record;
+
+  record = knife_cached( CACHE_BETWEEN, (*node1)-1, *region1, 
+			 (*node2)-1, *region2, knife_status );
+  if ( KNIFE_SUCCESS != *knife_status ) return;
+  if ( EMPTY != record )
+    {
+      TRY( knife_cached_subtri( record, *nsubtri, 
+				triangle_node0, triangle_node1, triangle_node2,
+				triangle_normal, triangle_area ), 
+	   "knife_cached_subtri" );
+      return;
+    }
+
+  if ( knife_scratch_holds( CACHE_BETWEEN, (*node1)-1, *region1, 
+			    (*node2)-1, *region2, *nsubtri ) )
+    {
+      knife_copy_subtri( scratch_xyz, scratch_max, *nsubtri,
+			 triangle_node0, triangle_node1, triangle_node2,
+			 triangle_normal, triangle_area );
+      return;
+    }
 
   poly1 = domain_poly( domain, (*node1)-1 );
   NOT_NULL( poly1, "poly1 NULL in knife_ntriangles_between_poly_");
@@ -461,6 +1197,21 @@ void FC_FUNC_(knife_between_poly_sens,KNIFE_BETWEEN_POLY_SENS)
   Poly poly1, poly2;
   Node node;
   int tri;
+  int record;
+
+  record = knife_cached( CACHE_BETWEEN_SENS, (*node1)-1, *region1, 
+			 (*node2)-1, *region2, knife_status );
+  if ( KNIFE_SUCCESS != *knife_status ) return;
+  if ( EMPTY != record )
+    {
+      TRY( knife_cached_sens( record, *nsubtri, 9, parent_int, parent_xyz ), 
+	   "knife_cached_sens" );
+      for ( tri = 0 ; tri < 9*(*nsubtri) ; tri++ )
+	{
+	  parent_int[tri]++;
+	}
+      return;
+    }
 
   poly1 = domain_poly( domain, (*node1)-1 );
   NOT_NULL( poly1, "poly1 NULL in knife_ntriangles_between_sens_");
@@ -486,20 +1237,684 @@ void FC_FUNC_(knife_between_poly_sens,KNIFE_BETWEEN_POLY_SENS)
   *knife_status = KNIFE_SUCCESS;
 }
 
+/* regions of a poly for the batched queries, from the cache when it
+ * has them */
+static KNIFE_STATUS knife_regions( int poly_index, int *regions )
+{
+  int record;
+
+  if ( NULL != cache )
+    {
+      record = cache_find( cache, CACHE_REGIONS, poly_index, 0, 0, 0 );
+      if ( EMPTY != record )
+	{
+	  *regions = cache_ints( cache, record )[0];
+	  return cache_status( cache, record );
+	}
+    }
+
+  if ( NULL == domain_poly( domain, poly_index ) ) return KNIFE_NULL;
+
+  return poly_regions( domain_poly( domain, poly_index ), regions );
+}
+
+/* centroid and volume of every region of a cut poly, the status of
+ * each as knife_poly_centroid_volume would return it */
+static KNIFE_STATUS knife_poly_centroid_volume_regions( int poly_index, 
+							int nregion,
+							double *centroid,
+							double *volume,
+							int *status )
+{
+  double origin[3];
+  int region, record;
+  Poly poly;
+
+  if ( NULL != cache )
+    {
+      for ( region = 1 ; region <= nregion ; region++ )
+	{
+	  record = knife_cached( CACHE_CENTROID_VOLUME, poly_index, region, 
+				 0, 0, &status[region-1] );
+	  if ( EMPTY == record ) continue;
+	  centroid[0+3*(region-1)] = cache_doubles( cache, record )[0];
+	  centroid[1+3*(region-1)] = cache_doubles( cache, record )[1];
+	  centroid[2+3*(region-1)] = cache_doubles( cache, record )[2];
+	  volume[region-1] = cache_doubles( cache, record )[3];
+	}
+      return KNIFE_SUCCESS;
+    }
+
+  poly = domain_poly( domain, poly_index );
+  if ( NULL == poly ) return KNIFE_NULL;
+  if ( KNIFE_SUCCESS != primal_xyz( domain_primal(domain), poly_index, 
+				    origin ) )
+    return KNIFE_ARRAY_BOUND;
+
+  if ( KNIFE_SUCCESS == poly_centroid_volume_regions( poly, nregion, origin,
+						      centroid, volume ) )
+    {
+      for ( region = 1 ; region <= nregion ; region++ )
+	status[region-1] = KNIFE_SUCCESS;
+      return KNIFE_SUCCESS;
+    }
+
+  /* a region failed, find which one by one */
+  for ( region = 1 ; region <= nregion ; region++ )
+    {
+      centroid[0+3*(region-1)] = origin[0];
+      centroid[1+3*(region-1)] = origin[1];
+      centroid[2+3*(region-1)] = origin[2];
+      status[region-1] = poly_centroid_volume( poly, region, origin, 
+					       &centroid[3*(region-1)],
+					       &volume[region-1] );
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+/* every region of every cut poly; entry k is node, region and the
+ * status of its centroid and volume, one based */
+static KNIFE_STATUS knife_centroid_volume_walk( KnifeBool fill, 
+						int *nentry, int max_entry,
+						int *entry, 
+						double *x, double *y, double *z,
+						double *volume )
+{
+  int poly_index, nregion, k;
+  int *start, *region_status;
+  double *centroid;
+  KNIFE_STATUS status, failed;
+
+  start = (int *)malloc( (domain_npoly(domain)+1)*sizeof(int) );
+  if ( NULL == start ) return KNIFE_MEMORY;
+
+  *nentry = 0;
+  for ( poly_index = 0 ; poly_index < domain_npoly(domain) ; poly_index++ )
+    {
+      start[poly_index] = *nentry;
+      if ( !domain_cut(domain,poly_index) ) continue;
+      status = knife_regions( poly_index, &nregion );
+      if ( KNIFE_SUCCESS != status )
+	{
+	  free( start );
+	  return status;
+	}
+      (*nentry) += MAX(nregion,0);
+    }
+  start[domain_npoly(domain)] = *nentry;
+
+  if ( !fill ) 
+    {
+      free( start );
+      return KNIFE_SUCCESS;
+    }
+
+  if ( *nentry > max_entry )
+    {
+      printf("%s: %d: too many regions found for argument\n",
+	     __FILE__,__LINE__);
+      free( start );
+      return KNIFE_ARRAY_BOUND;
+    }
+
+  centroid = (double *)malloc( 3*MAX(*nentry,1)*sizeof(double) );
+  region_status = (int *)malloc( MAX(*nentry,1)*sizeof(int) );
+  if ( NULL == centroid || NULL == region_status )
+    {
+      free( region_status );
+      free( centroid );
+      free( start );
+      return KNIFE_MEMORY;
+    }
+
+  /* polys only read the cut, so they are independent */
+  failed = KNIFE_SUCCESS;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic,64) private(status) reduction(max:failed)
+#endif
+  for ( poly_index = 0 ; poly_index < domain_npoly(domain) ; poly_index++ )
+    {
+      if ( start[poly_index] == start[poly_index+1] ) continue;
+      status = knife_poly_centroid_volume_regions( 
+		 poly_index, start[poly_index+1]-start[poly_index],
+		 &centroid[3*start[poly_index]], &volume[start[poly_index]],
+		 &region_status[start[poly_index]] );
+      if ( KNIFE_SUCCESS != status ) failed = MAX( failed, status );
+    }
+
+  for ( poly_index = 0 ; poly_index < domain_npoly(domain) ; poly_index++ )
+    for ( k = start[poly_index] ; k < start[poly_index+1] ; k++ )
+      {
+	entry[0+3*k] = poly_index+1;
+	entry[1+3*k] = k-start[poly_index]+1;
+	entry[2+3*k] = region_status[k];
+	x[k] = centroid[0+3*k];
+	y[k] = centroid[1+3*k];
+	z[k] = centroid[2+3*k];
+      }
+
+  free( region_status );
+  free( centroid );
+  free( start );
+
+  return failed;
+}
+
+void FC_FUNC_(knife_centroid_volume_dim,KNIFE_CENTROID_VOLUME_DIM)
+  ( int *nentry,
+    int *knife_status )
+{
+  TRY( knife_centroid_volume_walk( FALSE, nentry, 0, 
+				   NULL, NULL, NULL, NULL, NULL ), 
+       "knife_centroid_volume_walk count" );
+
+  *knife_status = KNIFE_SUCCESS;
+}
+
+void FC_FUNC_(knife_centroid_volume_all,KNIFE_CENTROID_VOLUME_ALL)
+  ( int *nentry, int *entry,
+    double *x, double *y, double *z, 
+    double *volume,
+    int *knife_status )
+{
+  int found_entry;
+
+  TRY( knife_centroid_volume_walk( TRUE, &found_entry, *nentry, 
+				   entry, x, y, z, volume ), 
+       "knife_centroid_volume_walk fill" );
+
+  ASSERT_INT_EQ( *nentry, found_entry, "number of centroid entries" );
+
+  *knife_status = KNIFE_SUCCESS;
+}
+
+/* walk each edge with a cut end once, counting (fill FALSE) or packing
+ * the dual face subtri of every region pair that has some.  Entry k is
+ * node1, region1, node2, region2 and its subtri are start[k] to
+ * start[k+1]-1, all one based */
+static KNIFE_STATUS knife_between_walk( KnifeBool fill,
+					int *nentry, int *nsubtri,
+					int max_entry, int max_subtri,
+					int *entry, int *start,
+					double *triangle_node0,
+					double *triangle_node1,
+					double *triangle_node2,
+					double *triangle_normal,
+					double *triangle_area )
+{
+  int edge, edge_nodes[2], end, nregion[2];
+  int region1, region2, pair, npair, record;
+  int *count, *offset, ncount;
+  Node node;
+  KNIFE_STATUS status;
+
+  status = KNIFE_SUCCESS;
+  *nentry = 0;
+  *nsubtri = 0;
+  count = NULL;
+  ncount = 0;
+  node = NULL;
+
+  for ( edge = 0 ; edge < primal_nedge(volume_primal) ; edge++ )
+    {
+      status = primal_edge( volume_primal, edge, edge_nodes );
+      if ( KNIFE_SUCCESS != status ) break;
+      if ( !domain_cut(domain,edge_nodes[0]) && 
+	   !domain_cut(domain,edge_nodes[1]) ) continue;
+
+      for ( end = 0 ; KNIFE_SUCCESS == status && end < 2 ; end++ )
+	{
+	  if ( NULL == domain_poly( domain, edge_nodes[end] ) )
+	    status = domain_add_interior_poly( domain, edge_nodes[end] );
+	  if ( KNIFE_SUCCESS == status )
+	    status = knife_regions( edge_nodes[end], &nregion[end] );
+	}
+      if ( KNIFE_SUCCESS != status ) break;
+
+      npair = MAX(nregion[0],0)*MAX(nregion[1],0);
+      if ( 0 == npair ) continue;
+      if ( npair > ncount )
+	{
+	  ncount = 2*npair;
+	  if ( NULL != count ) free( count );
+	  count = (int *)malloc( 2*ncount*sizeof(int) );
+	  if ( NULL == count ) 
+	    {
+	      status = KNIFE_MEMORY;
+	      break;
+	    }
+	}
+      offset = &(count[ncount]);
+
+      if ( NULL != cache )
+	{
+	  for ( region2 = 1 ; 
+		KNIFE_SUCCESS == status && region2 <= nregion[1] ; 
+		region2++ )
+	    for ( region1 = 1 ; 
+		  KNIFE_SUCCESS == status && region1 <= nregion[0] ; 
+		  region1++ )
+	      {
+		pair = (region1-1)+nregion[0]*(region2-1);
+		record = knife_cached( CACHE_BETWEEN, edge_nodes[0], region1,
+				       edge_nodes[1], region2, &status );
+		count[pair] = ( EMPTY == record ? 0 :
+				cache_ndouble( cache, record ) / 13 );
+	      }
+	}
+      else
+	{
+	  node = domain_node_at_edge_center( domain, edge );
+	  if ( NULL == node ) 
+	    {
+	      status = KNIFE_NULL;
+	      break;
+	    }
+	  status = poly_nsubtri_between_regions( 
+		     domain_poly( domain, edge_nodes[0] ), nregion[0],
+		     domain_poly( domain, edge_nodes[1] ), nregion[1],
+		     node, count );
+	}
+      if ( KNIFE_SUCCESS != status ) break;
+
+      for ( region1 = 1 ; region1 <= nregion[0] ; region1++ )
+	for ( region2 = 1 ; region2 <= nregion[1] ; region2++ )
+	  {
+	    pair = (region1-1)+nregion[0]*(region2-1);
+	    if ( 0 == count[pair] ) continue;
+	    if ( fill )
+	      {
+		if ( *nentry >= max_entry || 
+		     *nsubtri + count[pair] > max_subtri )
+		  {
+		    printf("%s: %d: too many subtri found for argument\n",
+			   __FILE__,__LINE__);
+		    free( count );
+		    return KNIFE_ARRAY_BOUND;
+		  }
+		entry[0+4*(*nentry)] = edge_nodes[0]+1;
+		entry[1+4*(*nentry)] = region1;
+		entry[2+4*(*nentry)] = edge_nodes[1]+1;
+		entry[3+4*(*nentry)] = region2;
+		start[*nentry] = *nsubtri+1;
+	      }
+	    offset[pair] = *nsubtri;
+	    (*nentry)++;
+	    (*nsubtri) += count[pair];
+	  }
+
+      if ( !fill ) continue;
+
+      if ( NULL != cache )
+	{
+	  for ( region1 = 1 ; 
+		KNIFE_SUCCESS == status && region1 <= nregion[0] ; 
+		region1++ )
+	    for ( region2 = 1 ; 
+		  KNIFE_SUCCESS == status && region2 <= nregion[1] ; 
+		  region2++ )
+	      {
+		pair = (region1-1)+nregion[0]*(region2-1);
+		if ( 0 == count[pair] ) continue;
+		record = cache_find( cache, CACHE_BETWEEN, 
+				     edge_nodes[0], region1,
+				     edge_nodes[1], region2 );
+		status = knife_cached_subtri( record, count[pair],
+					      &triangle_node0[3*offset[pair]],
+					      &triangle_node1[3*offset[pair]],
+					      &triangle_node2[3*offset[pair]],
+					      &triangle_normal[3*offset[pair]],
+					      &triangle_area[offset[pair]] );
+	      }
+	}
+      else
+	{
+	  status = poly_subtri_between_regions( 
+		     domain_poly( domain, edge_nodes[0] ), nregion[0],
+		     domain_poly( domain, edge_nodes[1] ), nregion[1],
+		     node, offset,
+		     triangle_node0, triangle_node1, triangle_node2,
+		     triangle_normal, triangle_area );
+	}
+      if ( KNIFE_SUCCESS != status ) break;
+    }
+
+  if ( NULL != count ) free( count );
+  if ( KNIFE_SUCCESS != status ) return status;
+
+  if ( fill ) start[*nentry] = *nsubtri+1;
+
+  return KNIFE_SUCCESS;
+}
+
+void FC_FUNC_(knife_between_poly_dim,KNIFE_BETWEEN_POLY_DIM)
+  ( int *nentry, int *nsubtri,
+    int *knife_status )
+{
+  TRY( knife_between_walk( FALSE, nentry, nsubtri, 0, 0, NULL, NULL,
+			   NULL, NULL, NULL, NULL, NULL ), 
+       "knife_between_walk count" );
+
+  *knife_status = KNIFE_SUCCESS;
+}
+
+void FC_FUNC_(knife_between_poly_all,KNIFE_BETWEEN_POLY_ALL)
+  ( int *nentry, int *entry, int *start,
+    int *nsubtri,
+    double *triangle_node0,
+    double *triangle_node1,
+    double *triangle_node2,
+    double *triangle_normal,
+    double *triangle_area,
+    int *knife_status )
+{
+  int found_entry, found_subtri;
+
+  TRY( knife_between_walk( TRUE, &found_entry, &found_subtri, 
+			   *nentry, *nsubtri, entry, start,
+			   triangle_node0, triangle_node1, triangle_node2,
+			   triangle_normal, triangle_area ), 
+       "knife_between_walk fill" );
+
+  ASSERT_INT_EQ( *nentry, found_entry, "number of between entries" );
+  ASSERT_INT_EQ( *nsubtri, found_subtri, "number of between subtri" );
+
+  *knife_status = KNIFE_SUCCESS;
+}
+
+/* walk every cut poly, counting (fill FALSE) or packing the surface
+ * (boundary FALSE) or boundary subtri of every region that has some,
+ * with their sensitivity parents.  Entry k is node, region for the
+ * surface or node, face, region for the boundary and its subtri are
+ * start[k] to start[k+1]-1, all one based */
+static KNIFE_STATUS knife_subtri_walk( KnifeBool boundary, KnifeBool fill,
+				       int *nentry, int *nsubtri,
+				       int max_entry, int max_subtri,
+				       int *entry, int *start,
+				       double *triangle_node0,
+				       double *triangle_node1,
+				       double *triangle_node2,
+				       double *triangle_normal,
+				       double *triangle_area,
+				       int *triangle_tag,
+				       int *parent_int,
+				       double *parent_xyz )
+{
+  int poly_index, face, nregion, region, record, i;
+  int *count, *offset, ncount;
+  int ints_per_entry, ints_per_subtri, doubles_per_subtri;
+  int subtri_kind, sens_kind;
+  AdjIterator it;
+  KnifeBool more;
+  Poly poly;
+  KNIFE_STATUS status;
+
+  ints_per_entry     = ( boundary ? 3 : 2 );
+  ints_per_subtri    = ( boundary ? 9 : 4 );
+  doubles_per_subtri = ( boundary ? 9 : 27 );
+  subtri_kind = ( boundary ? CACHE_BOUNDARY : CACHE_SURFACE );
+  sens_kind = ( boundary ? CACHE_BOUNDARY_SENS : CACHE_SURFACE_SENS );
+
+  status = KNIFE_SUCCESS;
+  *nentry = 0;
+  *nsubtri = 0;
+  count = NULL;
+  ncount = 0;
+
+  for ( poly_index = 0 ; 
+	KNIFE_SUCCESS == status && poly_index < domain_npoly(domain) ; 
+	poly_index++ )
+    {
+      if ( !domain_cut(domain,poly_index) ) continue;
+      status = knife_regions( poly_index, &nregion );
+      if ( KNIFE_SUCCESS != status ) break;
+      if ( nregion <= 0 ) continue;
+      if ( nregion > ncount )
+	{
+	  ncount = 2*nregion;
+	  if ( NULL != count ) free( count );
+	  count = (int *)malloc( 2*ncount*sizeof(int) );
+	  if ( NULL == count ) 
+	    {
+	      status = KNIFE_MEMORY;
+	      break;
+	    }
+	}
+      offset = &(count[ncount]);
+      poly = domain_poly( domain, poly_index );
+      if ( NULL == cache && NULL == poly )
+	{
+	  status = KNIFE_NULL;
+	  break;
+	}
+
+      /* the surface is visited as a single face */
+      it = NULL;
+      more = TRUE;
+      if ( boundary ) 
+	{
+	  it = adj_first(primal_face_adj(domain_primal(domain)), poly_index);
+	  more = adj_valid(it);
+	}
+      while ( KNIFE_SUCCESS == status && more )
+	{
+	  face = ( boundary ? adj_item(it) : 0 );
+
+	  if ( NULL != cache )
+	    {
+	      for ( region = 1 ; 
+		    KNIFE_SUCCESS == status && region <= nregion ; 
+		    region++ )
+		{
+		  record = knife_cached( subtri_kind, poly_index, region, 
+					 face, 0, &status );
+		  count[region-1] = ( EMPTY == record ? 0 :
+				      cache_ndouble( cache, record ) / 13 );
+		}
+	    }
+	  else
+	    {
+	      status = ( boundary ? 
+			 poly_boundary_nsubtri_regions( poly, face, 
+							nregion, count ) :
+			 poly_surface_nsubtri_regions( poly, nregion, count ) );
+	    }
+	  if ( KNIFE_SUCCESS != status ) break;
+
+	  for ( region = 1 ; region <= nregion ; region++ )
+	    {
+	      if ( 0 == count[region-1] ) continue;
+	      if ( fill )
+		{
+		  if ( *nentry >= max_entry || 
+		       *nsubtri + count[region-1] > max_subtri )
+		    {
+		      printf("%s: %d: too many subtri found for argument\n",
+			     __FILE__,__LINE__);
+		      free( count );
+		      return KNIFE_ARRAY_BOUND;
+		    }
+		  entry[0+ints_per_entry*(*nentry)] = poly_index+1;
+		  if ( boundary ) entry[1+ints_per_entry*(*nentry)] = face+1;
+		  entry[ints_per_entry-1+ints_per_entry*(*nentry)] = region;
+		  start[*nentry] = *nsubtri+1;
+		}
+	      offset[region-1] = *nsubtri;
+	      (*nentry)++;
+	      (*nsubtri) += count[region-1];
+	    }
+
+	  if ( fill && NULL != cache )
+	    {
+	      for ( region = 1 ; 
+		    KNIFE_SUCCESS == status && region <= nregion ; 
+		    region++ )
+		{
+		  if ( 0 == count[region-1] ) continue;
+		  record = cache_find( cache, subtri_kind, 
+				       poly_index, region, face, 0 );
+		  status = knife_cached_subtri( 
+			     record, count[region-1],
+			     &triangle_node0[3*offset[region-1]],
+			     &triangle_node1[3*offset[region-1]],
+			     &triangle_node2[3*offset[region-1]],
+			     &triangle_normal[3*offset[region-1]],
+			     &triangle_area[offset[region-1]] );
+		  if ( KNIFE_SUCCESS != status ) break;
+		  if ( !boundary )
+		    memcpy( &triangle_tag[offset[region-1]], 
+			    cache_ints( cache, record ), 
+			    count[region-1]*sizeof(int) );
+		  record = knife_cached( sens_kind, 
+					 poly_index, region, face, 0, &status );
+		  if ( KNIFE_SUCCESS == status && EMPTY == record ) 
+		    status = KNIFE_NOT_FOUND;
+		  if ( KNIFE_SUCCESS != status ) break;
+		  status = knife_cached_sens( 
+			     record, count[region-1], ints_per_subtri,
+			     &parent_int[ints_per_subtri*offset[region-1]],
+			     &parent_xyz[doubles_per_subtri*offset[region-1]] );
+		}
+	    }
+	  if ( fill && NULL == cache )
+	    {
+	      status = ( boundary ? 
+			 poly_boundary_subtri_regions( 
+			   poly, face, nregion, offset,
+			   triangle_node0, triangle_node1, triangle_node2,
+			   triangle_normal, triangle_area,
+			   parent_int, parent_xyz, surface ) :
+			 poly_surface_subtri_regions( 
+			   poly, nregion, offset,
+			   triangle_node0, triangle_node1, triangle_node2,
+			   triangle_normal, triangle_area, triangle_tag,
+			   parent_int, parent_xyz, surface ) );
+	    }
+
+	  if ( boundary ) 
+	    {
+	      it = adj_next(it);
+	      more = adj_valid(it);
+	    }
+	  else
+	    more = FALSE;
+	}
+    }
+
+  if ( NULL != count ) free( count );
+  if ( KNIFE_SUCCESS != status ) return status;
+
+  if ( fill ) 
+    {
+      start[*nentry] = *nsubtri+1;
+      for ( i = 0 ; i < ints_per_subtri*(*nsubtri) ; i++ ) parent_int[i]++;
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+void FC_FUNC_(knife_surface_subtri_dim,KNIFE_SURFACE_SUBTRI_DIM)
+  ( int *nentry, int *nsubtri,
+    int *knife_status )
+{
+  TRY( knife_subtri_walk( FALSE, FALSE, nentry, nsubtri, 0, 0, NULL, NULL,
+			  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL ), 
+       "knife_subtri_walk surface count" );
+
+  *knife_status = KNIFE_SUCCESS;
+}
+
+void FC_FUNC_(knife_surface_subtri_all,KNIFE_SURFACE_SUBTRI_ALL)
+  ( int *nentry, int *entry, int *start,
+    int *nsubtri,
+    double *triangle_node0,
+    double *triangle_node1,
+    double *triangle_node2,
+    double *triangle_normal,
+    double *triangle_area,
+    int *triangle_tag,
+    int *constraint_type,
+    double *constraint_xyz,
+    int *knife_status )
+{
+  int found_entry, found_subtri;
+
+  TRY( knife_subtri_walk( FALSE, TRUE, &found_entry, &found_subtri, 
+			  *nentry, *nsubtri, entry, start,
+			  triangle_node0, triangle_node1, triangle_node2,
+			  triangle_normal, triangle_area, triangle_tag,
+			  constraint_type, constraint_xyz ), 
+       "knife_subtri_walk surface fill" );
+
+  ASSERT_INT_EQ( *nentry, found_entry, "number of surface entries" );
+  ASSERT_INT_EQ( *nsubtri, found_subtri, "number of surface subtri" );
+
+  *knife_status = KNIFE_SUCCESS;
+}
+
+void FC_FUNC_(knife_boundary_subtri_dim,KNIFE_BOUNDARY_SUBTRI_DIM)
+  ( int *nentry, int *nsubtri,
+    int *knife_status )
+{
+  TRY( knife_subtri_walk( TRUE, FALSE, nentry, nsubtri, 0, 0, NULL, NULL,
+			  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL ), 
+       "knife_subtri_walk boundary count" );
+
+  *knife_status = KNIFE_SUCCESS;
+}
+
+void FC_FUNC_(knife_boundary_subtri_all,KNIFE_BOUNDARY_SUBTRI_ALL)
+  ( int *nentry, int *entry, int *start,
+    int *nsubtri,
+    double *triangle_node0,
+    double *triangle_node1,
+    double *triangle_node2,
+    double *triangle_normal,
+    double *triangle_area,
+    int *parent_int,
+    double *parent_xyz,
+    int *knife_status )
+{
+  int found_entry, found_subtri;
+
+  TRY( knife_subtri_walk( TRUE, TRUE, &found_entry, &found_subtri, 
+			  *nentry, *nsubtri, entry, start,
+			  triangle_node0, triangle_node1, triangle_node2,
+			  triangle_normal, triangle_area, NULL,
+			  parent_int, parent_xyz ), 
+       "knife_subtri_walk boundary fill" );
+
+  ASSERT_INT_EQ( *nentry, found_entry, "number of boundary entries" );
+  ASSERT_INT_EQ( *nsubtri, found_subtri, "number of boundary subtri" );
+
+  *knife_status = KNIFE_SUCCESS;
+}
+
 void FC_FUNC_(knife_number_of_surface_triangles,KNIFE_NUMBER_OF_SURFACE_TRIANGLES)
   ( int *node, int *region,
     int *nsubtri,
     int *knife_status )
 {
-  int n;
   Poly poly;
+  int record;
+
+  record = knife_cached( CACHE_SURFACE, (*node)-1, *region, 0, 0, 
+			 knife_status );
+  if ( KNIFE_SUCCESS != *knife_status ) return;
+  if ( EMPTY != record )
+    {
+      *nsubtri = cache_nint( cache, record );
+      return;
+    }
 
   poly = domain_poly( domain, (*node)-1 );
   NOT_NULL(poly, "poly NULL in knife_number_of_surface_triangles_");
 
-  TRY( poly_surface_nsubtri( poly, *region, &n ), "poly_surface_nsubtri" );
+  TRY( knife_scratch_subtri( CACHE_SURFACE, (*node)-1, *region, 0, 0, 
+			      poly, NULL, NULL ), "knife_scratch_subtri" );
   
-  *nsubtri = n;
+  *nsubtri = scratch_nsubtri;
   *knife_status = KNIFE_SUCCESS;
 }
 
@@ -515,6 +1930,31 @@ void FC_FUNC_(knife_surface_triangles,KNIFE_SURFACE_TRIANGLES)
     int *knife_status )
 {
   Poly poly;
+  int record;
+
+  record = knife_cached( CACHE_SURFACE, (*node)-1, *region, 0, 0, 
+			 knife_status );
+  if ( KNIFE_SUCCESS != *knife_status ) return;
+  if ( EMPTY != record )
+    {
+      TRY( knife_cached_subtri( record, *nsubtri, 
+				triangle_node0, triangle_node1, triangle_node2,
+				triangle_normal, triangle_area ), 
+	   "knife_cached_subtri" );
+      memcpy( triangle_tag, cache_ints( cache, record ), 
+	      cache_nint( cache, record )*sizeof(int) );
+      return;
+    }
+
+  if ( knife_scratch_holds( CACHE_SURFACE, (*node)-1, *region, 0, 0, 
+			    *nsubtri ) )
+    {
+      knife_copy_subtri( scratch_xyz, scratch_max, *nsubtri,
+			 triangle_node0, triangle_node1, triangle_node2,
+			 triangle_normal, triangle_area );
+      memcpy( triangle_tag, scratch_tag, (*nsubtri)*sizeof(int) );
+      return;
+    }
 
   poly = domain_poly( domain, (*node)-1 );
   NOT_NULL(poly, "poly NULL in knife_surface_triangles_");
@@ -535,15 +1975,28 @@ void FC_FUNC_(knife_surface_sens,KNIFE_SURFACE_SENS)
 {
   Poly poly;
   int tri;
+  int record;
 
-  poly = domain_poly( domain, (*node)-1 );
-  NOT_NULL(poly, "poly NULL in knife_surface_triangles_");
-
-  TRY( poly_surface_sens( poly, *region, *nsubtri, 
-			  constraint_type,
-			  constraint_xyz,
-			  surface ), 
-       "poly_surface_sens" );
+  record = knife_cached( CACHE_SURFACE_SENS, (*node)-1, *region, 0, 0, 
+			 knife_status );
+  if ( KNIFE_SUCCESS != *knife_status ) return;
+  if ( EMPTY != record )
+    {
+      TRY( knife_cached_sens( record, *nsubtri, 4, 
+			      constraint_type, constraint_xyz ), 
+	   "knife_cached_sens" );
+    }
+  else
+    {
+      poly = domain_poly( domain, (*node)-1 );
+      NOT_NULL(poly, "poly NULL in knife_surface_triangles_");
+
+      TRY( poly_surface_sens( poly, *region, *nsubtri, 
+			      constraint_type,
+			      constraint_xyz,
+			      surface ), 
+	   "poly_surface_sens" );
+    }
   
   for ( tri = 0 ; tri < (*nsubtri) ; tri++ )
     {
@@ -561,16 +2014,25 @@ void FC_FUNC_(knife_number_of_boundary_triangles,KNIFE_NUMBER_OF_BOUNDARY_TRIANG
     int *nsubtri,
     int *knife_status )
 {
-  int n;
   Poly poly;
+  int record;
+
+  record = knife_cached( CACHE_BOUNDARY, (*node)-1, *region, (*face)-1, 0, 
+			 knife_status );
+  if ( KNIFE_SUCCESS != *knife_status ) return;
+  if ( EMPTY != record )
+    {
+      *nsubtri = cache_ndouble( cache, record ) / 13;
+      return;
+    }
 
   poly = domain_poly( domain, (*node)-1 );
   NOT_NULL(poly, "poly NULL in knife_number_of_boundary_triangles_");
 
-  TRY( poly_boundary_nsubtri( poly, (*face)-1, *region, &n ), 
-       "poly_boundary_nsubtri" );
+  TRY( knife_scratch_subtri( CACHE_BOUNDARY, (*node)-1, *region, (*face)-1, 0,
+			      poly, NULL, NULL ), "knife_scratch_subtri" );
   
-  *nsubtri = n;
+  *nsubtri = scratch_nsubtri;
   *knife_status = KNIFE_SUCCESS;
 }
 
@@ -585,6 +2047,28 @@ void FC_FUNC_(knife_boundary_triangles,KNIFE_BOUNDARY_TRIANGLES)
     int *knife_status )
 {
   Poly poly;
+  int record;
+
+  record = knife_cached( CACHE_BOUNDARY, (*node)-1, *region, (*face)-1, 0, 
+			 knife_status );
+  if ( KNIFE_SUCCESS != *knife_status ) return;
+  if ( EMPTY != record )
+    {
+      TRY( knife_cached_subtri( record, *nsubtri, 
+				triangle_node0, triangle_node1, triangle_node2,
+				triangle_normal, triangle_area ), 
+	   "knife_cached_subtri" );
+      return;
+    }
+
+  if ( knife_scratch_holds( CACHE_BOUNDARY, (*node)-1, *region, (*face)-1, 0,
+			    *nsubtri ) )
+    {
+      knife_copy_subtri( scratch_xyz, scratch_max, *nsubtri,
+			 triangle_node0, triangle_node1, triangle_node2,
+			 triangle_normal, triangle_area );
+      return;
+    }
 
   poly = domain_poly( domain, (*node)-1 );
   NOT_NULL(poly, "poly NULL in knife_boundary_triangles_");
@@ -606,16 +2090,28 @@ void FC_FUNC_(knife_boundary_sens,KNIFE_BOUNDARY_SENS)
 {
   Poly poly;
   int i;
+  int record;
 
-  poly = domain_poly( domain, (*node)-1 );
-  NOT_NULL(poly, "poly NULL in knife_boundary_triangles_");
-
-  TRY( poly_boundary_sens( poly, (*face)-1, *region, 
-			   *nsubtri, 
-			   parent_int,
-			   parent_xyz,
-			   surface ), 
-       "poly_boundary_sens" );
+  record = knife_cached( CACHE_BOUNDARY_SENS, (*node)-1, *region, (*face)-1, 0,
+			 knife_status );
+  if ( KNIFE_SUCCESS != *knife_status ) return;
+  if ( EMPTY != record )
+    {
+      TRY( knife_cached_sens( record, *nsubtri, 9, parent_int, parent_xyz ), 
+	   "knife_cached_sens" );
+    }
+  else
+    {
+      poly = domain_poly( domain, (*node)-1 );
+      NOT_NULL(poly, "poly NULL in knife_boundary_triangles_");
+
+      TRY( poly_boundary_sens( poly, (*face)-1, *region, 
+			       *nsubtri, 
+			       parent_int,
+			       parent_xyz,
+			       surface ), 
+	   "poly_boundary_sens" );
+    }
   
   for ( i = 0 ; i < 9*(*nsubtri) ; i++ )
     {
@@ -681,15 +2177,33 @@ void FC_FUNC_(knife_free,KNIFE_FREE)( int *knife_status )
   primal_free( surface_primal );
   surface_primal = NULL;
 
+  if ( shared_surface_creator )
+    primal_unpublish( shared_surface_name );
+  shared_surface_creator = FALSE;
+  shared_surface_published = FALSE;
+
   surface_free( surface );
   surface = NULL;
 
+  set_free( surface_bcs );
+  surface_bcs = NULL;
+
   primal_free( volume_primal );
   volume_primal = NULL;
 
   domain_free( domain );
   domain = NULL;
 
+  cache_free( cache );
+  cache = NULL;
+
+  free( scratch_tag );
+  free( scratch_xyz );
+  scratch_tag = NULL;
+  scratch_xyz = NULL;
+  scratch_max = 0;
+  scratch_kind = EMPTY;
+
   partition = EMPTY;
 
   *knife_status = KNIFE_SUCCESS;
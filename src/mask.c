@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "mask.h"
+#include "profile.h"
 
 static int mask_tecplot_frame = 0;
 
@@ -56,6 +57,8 @@ Mask mask_create( Triangle traingle, KnifeBool inward_pointing_normal )
   mask->inward_pointing_normal = inward_pointing_normal;
   mask->region   = NULL;
 
+  profile_count( PROFILE_MASK, 1 );
+
   return mask;
 }
 
@@ -457,10 +460,21 @@ KNIFE_STATUS mask_centroid_volume_contribution( Mask mask, int region,
 						double *origin,
 						double *centroid, 
 						double *volume )
+{
+  return mask_centroid_volume_regions( mask, region, 1, 
+				       origin, centroid, volume );
+}
+
+KNIFE_STATUS mask_centroid_volume_regions( Mask mask, 
+					   int first_region, int nregion,
+					   double *origin,
+					   double *centroid, 
+					   double *volume )
 {
   Triangle triangle;
   Subtri subtri;
   int subtri_index;
+  int slot;
 
   double xyz0[3], xyz1[3], xyz2[3];
   double normal[3], triangle_area, area;
@@ -495,8 +509,10 @@ KNIFE_STATUS mask_centroid_volume_contribution( Mask mask, int region,
   for ( subtri_index = 0;
 	subtri_index < triangle_nsubtri(triangle); 
 	subtri_index++)
-    if ( region == mask_subtri_region(mask,subtri_index) )
+    if ( mask_subtri_region(mask,subtri_index) >= first_region &&
+	 mask_subtri_region(mask,subtri_index) < first_region+nregion )
       {
+	slot = mask_subtri_region(mask,subtri_index) - first_region;
 	subtri = triangle_subtri(triangle,subtri_index);
 	area = triangle_area * subtri_reference_area( subtri );
 	for (iquad = 0; iquad<nquad; iquad++)
@@ -519,12 +535,15 @@ KNIFE_STATUS mask_centroid_volume_contribution( Mask mask, int region,
 			       bary[1]*xyz1[i] + 
 			       bary[2]*xyz2[i];
 
-	    (*volume) += weight[iquad]*area*( xyz[0]*normal[0] + 
-					      xyz[1]*normal[1] + 
-					      xyz[2]*normal[2] ) / 3.0;
-	    centroid[0] += weight[iquad]*area*(xyz[0]*xyz[0]*normal[0]) / 2.0;
-	    centroid[1] += weight[iquad]*area*(xyz[1]*xyz[1]*normal[1]) / 2.0;
-	    centroid[2] += weight[iquad]*area*(xyz[2]*xyz[2]*normal[2]) / 2.0;
+	    volume[slot] += weight[iquad]*area*( xyz[0]*normal[0] + 
+						 xyz[1]*normal[1] + 
+						 xyz[2]*normal[2] ) / 3.0;
+	    centroid[0+3*slot] += 
+	      weight[iquad]*area*(xyz[0]*xyz[0]*normal[0]) / 2.0;
+	    centroid[1+3*slot] += 
+	      weight[iquad]*area*(xyz[1]*xyz[1]*normal[1]) / 2.0;
+	    centroid[2+3*slot] += 
+	      weight[iquad]*area*(xyz[2]*xyz[2]*normal[2]) / 2.0;
 
 	  }
       }
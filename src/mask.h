@@ -78,6 +78,13 @@ KNIFE_STATUS mask_centroid_volume_contribution( Mask, int region,
 						double *origin,
 						double *centroid, 
 						double *volume );
+/* regions first_region to first_region+nregion-1 in one pass, each to
+ * its own centroid[3*slot] and volume[slot] */
+KNIFE_STATUS mask_centroid_volume_regions( Mask, 
+					   int first_region, int nregion,
+					   double *origin,
+					   double *centroid, 
+					   double *volume );
 
 KNIFE_STATUS mask_tecplot( Mask );
 
@@ -80,6 +80,11 @@ Poly poly_create( void )
 KNIFE_STATUS poly_initialize( Poly poly )
 {
 
+  poly->nmask_hash = 0;
+  poly->mask_hash = NULL;
+  poly->nsurf_hash = 0;
+  poly->surf_hash = NULL;
+
   poly->mask = array_create(4,40);
   NOT_NULL( poly->mask, "poly mask array null" );
 
@@ -103,6 +108,9 @@ void poly_free( Poly poly )
     mask_free( poly_surf(poly, mask_index) );
   array_free( poly->surf );
 
+  if ( NULL != poly->mask_hash ) free( poly->mask_hash );
+  if ( NULL != poly->surf_hash ) free( poly->surf_hash );
+
   free( poly );
 }
 
@@ -118,46 +126,99 @@ KNIFE_STATUS poly_add_triangle( Poly poly, Triangle triangle,
   return poly_add_mask( poly, mask_create( triangle, inward_pointing_normal ) );
 }
 
-KnifeBool poly_has_surf_triangle( Poly poly, Triangle triangle )
+#define poly_hash_slot(triangle,nhash)				\
+  ((int)((((size_t)(triangle)>>4)*2654435761u)&((size_t)(nhash)-1)))
+
+static Mask poly_hash_lookup( int nhash, Mask *hash, Triangle triangle )
 {
-  int surf_index;
-  for ( surf_index = 0;
-	surf_index < poly_nsurf(poly); 
-	surf_index++)
+  int slot;
+
+  if ( NULL == hash ) return NULL;
+
+  slot = poly_hash_slot( triangle, nhash );
+  while ( NULL != hash[slot] )
     {
-      if ( triangle == mask_triangle( poly_surf(poly, surf_index) ) )
-	   return TRUE;
+      if ( triangle == mask_triangle( hash[slot] ) ) return hash[slot];
+      slot = (slot+1) & (nhash-1);
     }
-  
-  return FALSE;
+
+  return NULL;
 }
 
-KNIFE_STATUS poly_mask_with_triangle( Poly poly, Triangle triangle, Mask *mask )
+static void poly_hash_store( int nhash, Mask *hash, Mask mask )
 {
-  int mask_index;
+  int slot;
 
-  for ( mask_index = 0;
-	mask_index < poly_nsurf(poly); 
-	mask_index++)
+  slot = poly_hash_slot( mask_triangle( mask ), nhash );
+  while ( NULL != hash[slot] )
     {
-      if ( triangle == mask_triangle( poly_surf(poly, mask_index) ) )
-	{
-	  *mask = poly_surf(poly, mask_index);
-	  return KNIFE_SUCCESS;
-	}
+      /* the first mask added with a triangle is the one that is found */
+      if ( mask_triangle( mask ) == mask_triangle( hash[slot] ) ) return;
+      slot = (slot+1) & (nhash-1);
     }
-  
-  for ( mask_index = 0;
-	mask_index < poly_nmask(poly); 
-	mask_index++)
+  hash[slot] = mask;
+}
+
+static KNIFE_STATUS poly_hash_add( Array array, int *nhash, Mask **hash,
+				   Mask mask )
+{
+  int indx, slot;
+
+  TRY( array_add( array, (ArrayItem)mask ), "array add" );
+
+  if ( 2*array_size(array) <= (*nhash) )
     {
-      if ( triangle == mask_triangle( poly_mask(poly, mask_index) ) )
-	{
-	  *mask = poly_mask(poly, mask_index);
-	  return KNIFE_SUCCESS;
-	}
+      poly_hash_store( (*nhash), (*hash), mask );
+      return KNIFE_SUCCESS;
     }
-  
+
+  if ( NULL != (*hash) ) free( (*hash) );
+  (*nhash) = 16;
+  while ( (*nhash) < 4*array_size(array) ) (*nhash) *= 2;
+  (*hash) = (Mask *) malloc( (*nhash) * sizeof(Mask) );
+  if (NULL == (*hash)) {
+    printf("%s: %d: malloc failed in poly_hash_add\n",
+	   __FILE__,__LINE__);
+    (*nhash) = 0;
+    return KNIFE_MEMORY;
+  }
+  for ( slot = 0 ; slot < (*nhash) ; slot++ ) (*hash)[slot] = NULL;
+
+  for ( indx = 0 ; indx < array_size(array) ; indx++ )
+    poly_hash_store( (*nhash), (*hash), (Mask)array_item( array, indx ) );
+
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS poly_add_mask( Poly poly, Mask mask )
+{
+  NOT_NULL( mask, "null mask" );
+  return poly_hash_add( poly->mask, &(poly->nmask_hash), &(poly->mask_hash),
+			mask );
+}
+
+KNIFE_STATUS poly_add_surf( Poly poly, Mask surf )
+{
+  NOT_NULL( surf, "null surf" );
+  return poly_hash_add( poly->surf, &(poly->nsurf_hash), &(poly->surf_hash),
+			surf );
+}
+
+KnifeBool poly_has_surf_triangle( Poly poly, Triangle triangle )
+{
+  return ( NULL != poly_hash_lookup( poly->nsurf_hash, poly->surf_hash,
+				     triangle ) );
+}
+
+KNIFE_STATUS poly_mask_with_triangle( Poly poly, Triangle triangle, Mask *mask )
+{
+
+  *mask = poly_hash_lookup( poly->nsurf_hash, poly->surf_hash, triangle );
+  if ( NULL != (*mask) ) return KNIFE_SUCCESS;
+
+  *mask = poly_hash_lookup( poly->nmask_hash, poly->mask_hash, triangle );
+  if ( NULL != (*mask) ) return KNIFE_SUCCESS;
+
   return KNIFE_NOT_FOUND;
 }
 
@@ -189,6 +250,35 @@ KNIFE_STATUS poly_gather_surf( Poly poly )
   return KNIFE_SUCCESS;
 }
 
+/* back to the state before poly_gather_surf, for a poly whose
+ * triangles have been triangulated again */
+KNIFE_STATUS poly_reset_surf( Poly poly )
+{
+  int mask_index;
+  Mask mask;
+
+  if ( NULL == poly) return KNIFE_NULL;
+
+  for ( mask_index = 0; mask_index < poly_nsurf(poly); mask_index++)
+    mask_free( poly_surf(poly, mask_index) );
+  array_free( poly->surf );
+  poly->surf = array_create(4,40);
+  NOT_NULL( poly->surf, "poly surf array null" );
+
+  if ( NULL != poly->surf_hash ) free( poly->surf_hash );
+  poly->nsurf_hash = 0;
+  poly->surf_hash = NULL;
+
+  for ( mask_index = 0; mask_index < poly_nmask(poly); mask_index++)
+    {
+      mask = poly_mask(poly, mask_index);
+      if ( NULL != mask->region ) free( mask->region );
+      mask->region = NULL;
+    }
+
+  return KNIFE_SUCCESS;
+}
+
 KNIFE_STATUS poly_activate_all_subtri( Poly poly )
 {
   int mask_index;
@@ -998,6 +1088,53 @@ KNIFE_STATUS poly_centroid_volume( Poly poly, int region, double *origin,
   return KNIFE_SUCCESS;
 }
 
+KNIFE_STATUS poly_centroid_volume_regions( Poly poly, int nregion, 
+					   double *origin, 
+					   double *centroid, double *volume )
+{
+  int mask_index;
+  int slot;
+
+  if (NULL == poly) return KNIFE_NULL;
+
+  for ( slot = 0 ; slot < nregion ; slot++ )
+    {
+      centroid[0+3*slot] = 0.0;
+      centroid[1+3*slot] = 0.0;
+      centroid[2+3*slot] = 0.0;
+      volume[slot] = 0.0;
+    }
+
+  for ( mask_index = 0;
+	mask_index < poly_nmask(poly); 
+	mask_index++)
+    TRY(mask_centroid_volume_regions( poly_mask(poly, mask_index), 1, nregion,
+				      origin, centroid, volume),
+	"cent vol mask");
+
+  for ( mask_index = 0;
+	mask_index < poly_nsurf(poly); 
+	mask_index++)
+    TRY(mask_centroid_volume_regions( poly_surf(poly, mask_index), 1, nregion,
+				      origin, centroid, volume),
+	"cent vol surf");
+
+  for ( slot = 0 ; slot < nregion ; slot++ )
+    if ( volume[slot] < 1.0e-14 )
+      {
+	TRY( poly_average_face_center( poly, slot+1, &centroid[3*slot] ), 
+	     "avg face cent");
+      }
+    else
+      {
+	centroid[0+3*slot] = centroid[0+3*slot] / volume[slot] + origin[0];
+	centroid[1+3*slot] = centroid[1+3*slot] / volume[slot] + origin[1];
+	centroid[2+3*slot] = centroid[2+3*slot] / volume[slot] + origin[2];
+      }
+
+  return KNIFE_SUCCESS;
+}
+
 KNIFE_STATUS poly_average_face_center( Poly poly, int region, double *centroid )
 {
   int mask_index;
@@ -1095,22 +1232,67 @@ KNIFE_STATUS poly_nsubtri_between( Poly poly1, int region1,
   return KNIFE_SUCCESS;
 }
 
-KNIFE_STATUS poly_subtri_between( Poly poly1, int region1, 
-				  Poly poly2, int region2,
-				  Node node, int nsubtri,
+/* n subtri were found for an argument sized for nsubtri */
+static KNIFE_STATUS poly_subtri_count_check( int n, int nsubtri )
+{
+  if ( n > nsubtri )
+    {
+      printf("%s: %d: too many subtri found for argument\n",
+	     __FILE__,__LINE__);
+      return KNIFE_ARRAY_BOUND;
+    }
+  if ( n != nsubtri )
+    {
+      printf("%s: %d: not enough subtri found %d of %d\n",
+	     __FILE__,__LINE__, n, nsubtri);
+      return KNIFE_MISSING;
+    }
+  return KNIFE_SUCCESS;
+}
+
+/* geometry of subtri n of a mask, oriented by the mask */
+static void poly_oriented_subtri( Mask mask, Subtri subtri, 
+				  double entire_triangle_area, double *normal,
+				  int n,
 				  double *triangle_node0, 
 				  double *triangle_node1,
 				  double *triangle_node2,
 				  double *triangle_normal,
 				  double *triangle_area )
+{
+  if ( mask_inward_pointing_normal( mask ) )
+    {
+      subnode_xyz( subtri_n1(subtri), &(triangle_node0[3*n]) );
+      subnode_xyz( subtri_n0(subtri), &(triangle_node1[3*n]) );
+      subnode_xyz( subtri_n2(subtri), &(triangle_node2[3*n]) );
+    }
+  else
+    {
+      subnode_xyz( subtri_n0(subtri), &(triangle_node0[3*n]) );
+      subnode_xyz( subtri_n1(subtri), &(triangle_node1[3*n]) );
+      subnode_xyz( subtri_n2(subtri), &(triangle_node2[3*n]) );
+    }
+  triangle_normal[0+3*n]=normal[0];
+  triangle_normal[1+3*n]=normal[1];
+  triangle_normal[2+3*n]=normal[2];
+  triangle_area[n] = entire_triangle_area * subtri_reference_area( subtri );
+}
+
+KNIFE_STATUS poly_subtri_between_upto( Poly poly1, int region1, 
+				       Poly poly2, int region2,
+				       Node node, int max_subtri, int *nsubtri,
+				       double *triangle_node0, 
+				       double *triangle_node1,
+				       double *triangle_node2,
+				       double *triangle_normal,
+				       double *triangle_area )
 {
   int mask_index, subtri_index;
   Mask mask1, mask2;
   Triangle triangle;
-  Subtri subtri;
   int n;
 
-  double normal[3], entire_triangle_area, area;
+  double normal[3], entire_triangle_area;
 
   n = 0;
   for ( mask_index = 0;
@@ -1137,41 +1319,134 @@ KNIFE_STATUS poly_subtri_between( Poly poly1, int region1,
 	    if ( region1 == mask_subtri_region(mask1,subtri_index) &&
 		 region2 == mask_subtri_region(mask2,subtri_index) ) 
 	      {
-		if ( n >= nsubtri )
-		  {
-		    printf("%s: %d: too many subtri found for argument\n",
-			   __FILE__,__LINE__);
-		    return KNIFE_ARRAY_BOUND;
-		  }
-		subtri = triangle_subtri( triangle, subtri_index );
-		if ( mask_inward_pointing_normal( mask1 ) )
-		  {
-		    subnode_xyz( subtri_n1(subtri), &(triangle_node0[3*n]) );
-		    subnode_xyz( subtri_n0(subtri), &(triangle_node1[3*n]) );
-		    subnode_xyz( subtri_n2(subtri), &(triangle_node2[3*n]) );
-		  }
-		else
-		  {
-		    subnode_xyz( subtri_n0(subtri), &(triangle_node0[3*n]) );
-		    subnode_xyz( subtri_n1(subtri), &(triangle_node1[3*n]) );
-		    subnode_xyz( subtri_n2(subtri), &(triangle_node2[3*n]) );
-		  }
-		triangle_normal[0+3*n]=normal[0];
-		triangle_normal[1+3*n]=normal[1];
-		triangle_normal[2+3*n]=normal[2];
-		area = entire_triangle_area * subtri_reference_area( subtri );
-		triangle_area[n] = area;
+		if ( n < max_subtri )
+		  poly_oriented_subtri( mask1, 
+					triangle_subtri( triangle, 
+							 subtri_index ),
+					entire_triangle_area, normal, n,
+					triangle_node0, triangle_node1, 
+					triangle_node2, triangle_normal, 
+					triangle_area );
 		n++;
 	      }
 	} /* shared triangle */
     } /* poly1 masks */
 
-  if ( n != nsubtri )
+  *nsubtri = n;
+
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS poly_subtri_between( Poly poly1, int region1, 
+				  Poly poly2, int region2,
+				  Node node, int nsubtri,
+				  double *triangle_node0, 
+				  double *triangle_node1,
+				  double *triangle_node2,
+				  double *triangle_normal,
+				  double *triangle_area )
+{
+  int n;
+
+  TRY( poly_subtri_between_upto( poly1, region1, poly2, region2,
+				 node, nsubtri, &n,
+				 triangle_node0, triangle_node1, triangle_node2,
+				 triangle_normal, triangle_area ), "upto" );
+
+  return poly_subtri_count_check( n, nsubtri );
+}
+
+KNIFE_STATUS poly_nsubtri_between_regions( Poly poly1, int nregion1,
+					   Poly poly2, int nregion2,
+					   Node node, int *nsubtri )
+{
+  int mask_index, subtri_index;
+  Mask mask1, mask2;
+  Triangle triangle;
+  int region1, region2;
+
+  for ( region1 = 0 ; region1 < nregion1*nregion2 ; region1++ )
+    nsubtri[region1] = 0;
+
+  for ( mask_index = 0;
+	mask_index < poly_nmask(poly1); 
+	mask_index++)
     {
-      printf("%s: %d: not enough subtri found %d of %d\n",
-	     __FILE__,__LINE__, n, nsubtri);
-      return KNIFE_MISSING;
-    }
+      mask1 = poly_mask(poly1,mask_index);
+      triangle = mask_triangle(mask1);
+      if ( triangle_has1(triangle,node) &&
+	   !triangle_on_boundary(triangle) )
+	{
+	  TRY( poly_mask_with_triangle( poly2, triangle, &mask2 ), "mask2");
+	  for ( subtri_index = 0 ; 
+		subtri_index < triangle_nsubtri( triangle);
+		subtri_index++ )
+	    {
+	      region1 = mask_subtri_region(mask1,subtri_index);
+	      region2 = mask_subtri_region(mask2,subtri_index);
+	      if ( region1 >= 1 && region1 <= nregion1 &&
+		   region2 >= 1 && region2 <= nregion2 )
+		nsubtri[(region1-1)+nregion1*(region2-1)]++;
+	    }
+	} /* shared triangle */
+    } /* poly1 masks */
+
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS poly_subtri_between_regions( Poly poly1, int nregion1,
+					  Poly poly2, int nregion2,
+					  Node node, int *offset,
+					  double *triangle_node0, 
+					  double *triangle_node1,
+					  double *triangle_node2,
+					  double *triangle_normal,
+					  double *triangle_area )
+{
+  int mask_index, subtri_index;
+  Mask mask1, mask2;
+  Triangle triangle;
+  int region1, region2;
+
+  double normal[3], entire_triangle_area;
+
+  for ( mask_index = 0;
+	mask_index < poly_nmask(poly1); 
+	mask_index++)
+    {
+      mask1 = poly_mask(poly1,mask_index);
+      triangle = mask_triangle(mask1);
+      if ( triangle_has1(triangle,node) &&
+	   !triangle_on_boundary(triangle) )
+	{
+	  TRY( poly_mask_with_triangle( poly2, triangle, &mask2 ), "mask2");
+	  TRY( triangle_area_normal( triangle, &entire_triangle_area, normal ),
+	       "triangle area normal" );
+	  if ( mask_inward_pointing_normal( mask1 ) )
+	    {
+	      normal[0] = -normal[0];
+	      normal[1] = -normal[1];
+	      normal[2] = -normal[2];
+	    }
+	  for ( subtri_index = 0 ; 
+		subtri_index < triangle_nsubtri( triangle);
+		subtri_index++ )
+	    {
+	      region1 = mask_subtri_region(mask1,subtri_index);
+	      region2 = mask_subtri_region(mask2,subtri_index);
+	      if ( region1 < 1 || region1 > nregion1 ||
+		   region2 < 1 || region2 > nregion2 ) continue;
+	      poly_oriented_subtri( mask1, 
+				    triangle_subtri( triangle, subtri_index ),
+				    entire_triangle_area, normal, 
+				    offset[(region1-1)+nregion1*(region2-1)],
+				    triangle_node0, triangle_node1, 
+				    triangle_node2, triangle_normal, 
+				   triangle_area );
+	      offset[(region1-1)+nregion1*(region2-1)]++;
+	    }
+	} /* shared triangle */
+    } /* poly1 masks */
 
   return KNIFE_SUCCESS;
 }
@@ -1338,22 +1613,22 @@ KNIFE_STATUS poly_surface_nsubtri( Poly poly, int region, int *nsubtri )
   return KNIFE_SUCCESS;
 }
 
-KNIFE_STATUS poly_surface_subtri( Poly poly, int region, int nsubtri, 
-				  double *triangle_node0, 
-				  double *triangle_node1,
-				  double *triangle_node2,
-				  double *triangle_normal,
-				  double *triangle_area,
-				  int *triangle_tag )
+KNIFE_STATUS poly_surface_subtri_upto( Poly poly, int region, 
+				       int max_subtri, int *nsubtri, 
+				       double *triangle_node0, 
+				       double *triangle_node1,
+				       double *triangle_node2,
+				       double *triangle_normal,
+				       double *triangle_area,
+				       int *triangle_tag )
 {
   int surf_index;
   Mask surf;
   Triangle triangle;
   int subtri_index;
-  Subtri subtri;
   int n;
 
-  double normal[3], entire_triangle_area, area;
+  double normal[3], entire_triangle_area;
 
   n = 0;
   for ( surf_index = 0;
@@ -1375,40 +1650,119 @@ KNIFE_STATUS poly_surface_subtri( Poly poly, int region, int nsubtri,
 	    subtri_index++ )
 	if ( region == mask_subtri_region(surf,subtri_index) )
 	  {
-	    if ( n >= nsubtri )
-	      {
-		printf("%s: %d: too many subtri found for argument\n",
-		       __FILE__,__LINE__);
-		return KNIFE_ARRAY_BOUND;
-	      }
-	    subtri = triangle_subtri( triangle, subtri_index );
-	    if ( mask_inward_pointing_normal( surf ) )
-	      {
-		subnode_xyz( subtri_n1(subtri), &(triangle_node0[3*n]) );
-		subnode_xyz( subtri_n0(subtri), &(triangle_node1[3*n]) );
-		subnode_xyz( subtri_n2(subtri), &(triangle_node2[3*n]) );
-	      }
-	    else
+	    if ( n < max_subtri )
 	      {
-		subnode_xyz( subtri_n0(subtri), &(triangle_node0[3*n]) );
-		subnode_xyz( subtri_n1(subtri), &(triangle_node1[3*n]) );
-		subnode_xyz( subtri_n2(subtri), &(triangle_node2[3*n]) );
+		poly_oriented_subtri( surf, 
+				      triangle_subtri( triangle, subtri_index ),
+				      entire_triangle_area, normal, n,
+				      triangle_node0, triangle_node1, 
+				      triangle_node2,
+				      triangle_normal, triangle_area );
+		triangle_tag[n] = triangle_boundary_face_index(triangle);
 	      }
-	    triangle_normal[0+3*n]=normal[0];
-	    triangle_normal[1+3*n]=normal[1];
-	    triangle_normal[2+3*n]=normal[2];
-	    area = entire_triangle_area * subtri_reference_area( subtri );
-	    triangle_area[n] = area;
-	    triangle_tag[n] = triangle_boundary_face_index(triangle);
 	    n++;
 	  }
     }
 
-  if ( n != nsubtri )
+  *nsubtri = n;
+
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS poly_surface_subtri( Poly poly, int region, int nsubtri, 
+				  double *triangle_node0, 
+				  double *triangle_node1,
+				  double *triangle_node2,
+				  double *triangle_normal,
+				  double *triangle_area,
+				  int *triangle_tag )
+{
+  int n;
+
+  TRY( poly_surface_subtri_upto( poly, region, nsubtri, &n,
+				 triangle_node0, triangle_node1, triangle_node2,
+				 triangle_normal, triangle_area, triangle_tag ),
+       "upto" );
+
+  return poly_subtri_count_check( n, nsubtri );
+}
+
+/* constraint of surf subtri n, see poly_surface_sens */
+static KNIFE_STATUS poly_surface_subtri_sens( Mask surf, Subtri subtri, int n,
+					      int *constraint_type,
+					      double *constraint_xyz, 
+					      Surface surface )
+{
+  Triangle triangle, other;
+  Subnode subnode;
+  int subnode_index;
+  Intersection intersection;
+  Segment segment;
+  int ixyz;
+
+  triangle = mask_triangle(surf);
+  constraint_type[3+4*n] = surface_triangle_index(surface,triangle);
+  for ( subnode_index = 0 ; subnode_index < 3 ; subnode_index++ )
     {
-      printf("%s: %d: not enough subtri found %d of %d\n",
-	     __FILE__,__LINE__, n, nsubtri);
-      return KNIFE_MISSING;
+      for ( ixyz = 0 ; ixyz < 9 ; ixyz++ )
+	{
+	  constraint_xyz[ixyz+9*subnode_index+27*n] = 0.0;
+	}
+      if ( mask_inward_pointing_normal( surf ) )
+	{
+	  subnode = 
+	    subtri_subnode(subtri,
+			   inward_subnode_order[subnode_index]);
+	}
+      else
+	{
+	  subnode = 
+	    subtri_subnode(subtri,
+			   outward_subnode_order[subnode_index]);
+	}
+      /* subnode parent is triangle node [0-2] */
+      constraint_type[subnode_index+4*n] = 
+	triangle_node_index(triangle, subnode_node(subnode) );
+      if ( EMPTY == constraint_type[subnode_index+4*n] )
+	{
+	  intersection = subnode_intersection(subnode);
+	  NOT_NULL( intersection,
+		    "subnode (without node) intersection NULL");
+	  segment = intersection_segment( intersection );
+	  constraint_type[subnode_index+4*n] = 
+	    triangle_segment_index( triangle, segment );
+	  if ( EMPTY == constraint_type[subnode_index+4*n] )
+	    {
+	      /* subnode parent is intersection with triangle [6] */
+	      constraint_type[subnode_index+4*n] = 6;
+	      for ( ixyz = 0 ; ixyz < 3 ; ixyz++ )
+		{
+		  constraint_xyz[ixyz+0+9*subnode_index+27*n] = 
+		    segment_xyz0(segment)[ixyz];
+		  constraint_xyz[ixyz+3+9*subnode_index+27*n] = 
+		    segment_xyz1(segment)[ixyz];
+		  constraint_xyz[ixyz+6+9*subnode_index+27*n] = 
+		    segment_xyz0(segment)[ixyz];
+		}
+	    }
+	  else
+	    {
+	      /* subnode parent is intersection with dual tri [3-5]*/
+	      constraint_type[subnode_index+4*n] += 3;
+	      other = intersection_triangle( intersection );
+	      NOT_NULL( other,
+			"intersection other tri NULL");
+	      for ( ixyz = 0 ; ixyz < 3 ; ixyz++ )
+		{
+		  constraint_xyz[ixyz+0+9*subnode_index+27*n] = 
+		    triangle_xyz0(other)[ixyz];
+		  constraint_xyz[ixyz+3+9*subnode_index+27*n] = 
+		    triangle_xyz1(other)[ixyz];
+		  constraint_xyz[ixyz+6+9*subnode_index+27*n] = 
+		    triangle_xyz2(other)[ixyz];
+		}
+	    }
+	}
     }
 
   return KNIFE_SUCCESS;
@@ -1421,14 +1775,9 @@ KNIFE_STATUS poly_surface_sens( Poly poly, int region, int nsubtri,
 {
   int surf_index;
   Mask surf;
-  Triangle triangle, other;
-  Subtri subtri;
+  Triangle triangle;
   int subtri_index;
-  Subnode subnode;
-  int subnode_index;
-  Intersection intersection;
-  Segment segment;
-  int n, ixyz;
+  int n;
 
   n = 0;
   for ( surf_index = 0;
@@ -1448,70 +1797,11 @@ KNIFE_STATUS poly_surface_sens( Poly poly, int region, int nsubtri,
 		       __FILE__,__LINE__);
 		return KNIFE_ARRAY_BOUND;
 	      }
-	    subtri = triangle_subtri( triangle, subtri_index );
-	    constraint_type[3+4*n] = surface_triangle_index(surface,triangle);
-	    for ( subnode_index = 0 ; subnode_index < 3 ; subnode_index++ )
-	      {
-		for ( ixyz = 0 ; ixyz < 9 ; ixyz++ )
-		  {
-		    constraint_xyz[ixyz+9*subnode_index+27*n] = 0.0;
-		  }
-		  if ( mask_inward_pointing_normal( surf ) )
-		    {
-		      subnode = 
-			subtri_subnode(subtri,
-				        inward_subnode_order[subnode_index]);
-		    }
-		  else
-		    {
-		      subnode = 
-			subtri_subnode(subtri,
-				       outward_subnode_order[subnode_index]);
-		    }
-		/* subnode parent is triangle node [0-2] */
-		constraint_type[subnode_index+4*n] = 
-		  triangle_node_index(triangle, subnode_node(subnode) );
-		if ( EMPTY == constraint_type[subnode_index+4*n] )
-		  {
-		    intersection = subnode_intersection(subnode);
-		    NOT_NULL( intersection,
-			      "subnode (without node) intersection NULL");
-		    segment = intersection_segment( intersection );
-		    constraint_type[subnode_index+4*n] = 
-		      triangle_segment_index( triangle, segment );
-		    if ( EMPTY == constraint_type[subnode_index+4*n] )
-		      {
-			/* subnode parent is intersection with triangle [6] */
-			constraint_type[subnode_index+4*n] = 6;
-			for ( ixyz = 0 ; ixyz < 3 ; ixyz++ )
-			  {
-			    constraint_xyz[ixyz+0+9*subnode_index+27*n] = 
-			      segment_xyz0(segment)[ixyz];
-			    constraint_xyz[ixyz+3+9*subnode_index+27*n] = 
-			      segment_xyz1(segment)[ixyz];
-			    constraint_xyz[ixyz+6+9*subnode_index+27*n] = 
-			      segment_xyz0(segment)[ixyz];
-			  }
-		      }
-		    else
-		      {
-			/* subnode parent is intersection with dual tri [3-5]*/
-			constraint_type[subnode_index+4*n] += 3;
-			other = intersection_triangle( intersection );
-			NOT_NULL( other,
-				  "intersection other tri NULL");
-			for ( ixyz = 0 ; ixyz < 3 ; ixyz++ )
-			  {
-			    constraint_xyz[ixyz+0+9*subnode_index+27*n] = 
-			      triangle_xyz0(other)[ixyz];
-			    constraint_xyz[ixyz+3+9*subnode_index+27*n] = 
-			      triangle_xyz1(other)[ixyz];
-			    constraint_xyz[ixyz+6+9*subnode_index+27*n] = 
-			      triangle_xyz2(other)[ixyz];
-			  }
-		      }
-		  }
-	      }
+	    TRY( poly_surface_subtri_sens( surf, 
+					   triangle_subtri( triangle, 
+							    subtri_index ),
+					   n, constraint_type, constraint_xyz,
+					   surface ), "surface subtri sens" );
 	    n++;
 	  }
     }
@@ -1526,6 +1816,91 @@ KNIFE_STATUS poly_surface_sens( Poly poly, int region, int nsubtri,
   return KNIFE_SUCCESS;
 }
 
+KNIFE_STATUS poly_surface_nsubtri_regions( Poly poly, int nregion, 
+					   int *nsubtri )
+{
+  int surf_index;
+  Mask surf;
+  Triangle triangle;
+  int subtri_index, region;
+
+  for ( region = 1 ; region <= nregion ; region++ ) nsubtri[region-1] = 0;
+
+  for ( surf_index = 0;
+	surf_index < poly_nsurf(poly); 
+	surf_index++)
+    {
+      surf = poly_surf(poly,surf_index);
+      triangle = mask_triangle(surf);
+      for ( subtri_index = 0 ; 
+	    subtri_index < triangle_nsubtri( triangle);
+	    subtri_index++ )
+	{
+	  region = mask_subtri_region(surf,subtri_index);
+	  if ( 1 <= region && region <= nregion ) nsubtri[region-1]++;
+	}
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS poly_surface_subtri_regions( Poly poly, int nregion, 
+					  int *offset,
+					  double *triangle_node0, 
+					  double *triangle_node1,
+					  double *triangle_node2,
+					  double *triangle_normal,
+					  double *triangle_area,
+					  int *triangle_tag,
+					  int *constraint_type,
+					  double *constraint_xyz,
+					  Surface surface )
+{
+  int surf_index;
+  Mask surf;
+  Triangle triangle;
+  int subtri_index, region, n;
+  Subtri subtri;
+
+  double normal[3], entire_triangle_area;
+
+  for ( surf_index = 0;
+	surf_index < poly_nsurf(poly); 
+	surf_index++)
+    {
+      surf = poly_surf(poly,surf_index);
+      triangle = mask_triangle(surf);
+      TRY( triangle_area_normal( triangle, &entire_triangle_area, normal ),
+	   "triangle area normal" );
+      if ( mask_inward_pointing_normal( surf ) )
+	{
+	  normal[0] = -normal[0];
+	  normal[1] = -normal[1];
+	  normal[2] = -normal[2];
+	}
+      for ( subtri_index = 0 ; 
+	    subtri_index < triangle_nsubtri( triangle);
+	    subtri_index++ )
+	{
+	  region = mask_subtri_region(surf,subtri_index);
+	  if ( region < 1 || region > nregion ) continue;
+	  n = offset[region-1];
+	  subtri = triangle_subtri( triangle, subtri_index );
+	  poly_oriented_subtri( surf, subtri, entire_triangle_area, normal, n,
+				triangle_node0, triangle_node1, triangle_node2,
+				triangle_normal, triangle_area );
+	  triangle_tag[n] = triangle_boundary_face_index(triangle);
+	  if ( NULL != constraint_type )
+	    TRY( poly_surface_subtri_sens( surf, subtri, n,
+					   constraint_type, constraint_xyz,
+					   surface ), "surface subtri sens" );
+	  offset[region-1]++;
+	}
+    }
+
+  return KNIFE_SUCCESS;
+}
+
 KNIFE_STATUS poly_boundary_nsubtri( Poly poly, int face_index, int region, 
 				    int *nsubtri )
 {
@@ -1554,22 +1929,22 @@ KNIFE_STATUS poly_boundary_nsubtri( Poly poly, int face_index, int region,
   return KNIFE_SUCCESS;
 }
 
-KNIFE_STATUS poly_boundary_subtri( Poly poly, int face_index, int region, 
-				   int nsubtri, 
-				   double *triangle_node0, 
-				   double *triangle_node1,
-				   double *triangle_node2,
-				   double *triangle_normal,
-				   double *triangle_area )
+KNIFE_STATUS poly_boundary_subtri_upto( Poly poly, int face_index, 
+					int region, 
+					int max_subtri, int *nsubtri, 
+					double *triangle_node0, 
+					double *triangle_node1,
+					double *triangle_node2,
+					double *triangle_normal,
+					double *triangle_area )
 {
   int mask_index;
   Mask mask;
   Triangle triangle;
   int subtri_index;
-  Subtri subtri;
   int n;
 
-  double normal[3], entire_triangle_area, area;
+  double normal[3], entire_triangle_area;
 
   n = 0;
   for ( mask_index = 0;
@@ -1592,41 +1967,135 @@ KNIFE_STATUS poly_boundary_subtri( Poly poly, int face_index, int region,
 	      subtri_index++ )
 	  if ( region == mask_subtri_region(mask,subtri_index) )
 	    {
-	      if ( n >= nsubtri )
-		{
-		  printf("%s: %d: too many subtri found for argument\n",
-			 __FILE__,__LINE__);
-		  return KNIFE_ARRAY_BOUND;
-		}
-	      subtri = triangle_subtri( triangle, subtri_index );
-	      if ( mask_inward_pointing_normal( mask ) )
-		{
-		  subnode_xyz( subtri_n1(subtri), &(triangle_node0[3*n]) );
-		  subnode_xyz( subtri_n0(subtri), &(triangle_node1[3*n]) );
-		  subnode_xyz( subtri_n2(subtri), &(triangle_node2[3*n]) );
-		}
-	      else
-		{
-		  subnode_xyz( subtri_n0(subtri), &(triangle_node0[3*n]) );
-		  subnode_xyz( subtri_n1(subtri), &(triangle_node1[3*n]) );
-		  subnode_xyz( subtri_n2(subtri), &(triangle_node2[3*n]) );
-		}
-	      triangle_normal[0+3*n]=normal[0];
-	      triangle_normal[1+3*n]=normal[1];
-	      triangle_normal[2+3*n]=normal[2];
-	      area = entire_triangle_area * subtri_reference_area( subtri );
-	      triangle_area[n] = area;
+	      if ( n < max_subtri )
+		poly_oriented_subtri( mask, 
+				      triangle_subtri( triangle, subtri_index ),
+				      entire_triangle_area, normal, n,
+				      triangle_node0, triangle_node1, 
+				      triangle_node2,
+				      triangle_normal, triangle_area );
 	      n++;
 	    } /* face_index subtri_index region */
     } /* mask_index */
 
-  if ( n != nsubtri )
+  *nsubtri = n;
+
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS poly_boundary_subtri( Poly poly, int face_index, int region, 
+				   int nsubtri, 
+				   double *triangle_node0, 
+				   double *triangle_node1,
+				   double *triangle_node2,
+				   double *triangle_normal,
+				   double *triangle_area )
+{
+  int n;
+
+  TRY( poly_boundary_subtri_upto( poly, face_index, region, nsubtri, &n,
+				  triangle_node0, triangle_node1, 
+				  triangle_node2,
+				  triangle_normal, triangle_area ), "upto" );
+
+  return poly_subtri_count_check( n, nsubtri );
+}
+
+/* parents of boundary mask subtri n, see poly_boundary_sens */
+static KNIFE_STATUS poly_boundary_subtri_sens( Mask mask, Subtri subtri, 
+					       int n,
+					       int *parent_int,
+					       double *parent_xyz, 
+					       Surface surface )
+{
+  int ixyz;
+  int triangle_index;
+  Triangle triangle, other;
+  int subnode_index;
+  Subnode subnode;
+  Intersection intersection;
+  Segment segment;
+
+  triangle = mask_triangle(mask);
+  for ( ixyz = 0 ; ixyz < 3 ; ixyz++ ) 
     {
-      printf("%s: %d: not enough subtri found %d of %d\n",
-	     __FILE__,__LINE__, n, nsubtri);
-      return KNIFE_MISSING;
+      parent_xyz[ixyz+3*0+9*n]=triangle_xyz0(triangle)[ixyz];
+      parent_xyz[ixyz+3*1+9*n]=triangle_xyz1(triangle)[ixyz];
+      parent_xyz[ixyz+3*2+9*n]=triangle_xyz2(triangle)[ixyz];
     }
 
+  for ( subnode_index = 0 ; subnode_index < 3 ; subnode_index++ )
+    {
+      if ( mask_inward_pointing_normal( mask ) )
+	{
+	  subnode = 
+	    subtri_subnode(subtri,
+			   inward_subnode_order[subnode_index]);
+	}
+      else
+	{
+	  subnode = 
+	    subtri_subnode(subtri,
+			   outward_subnode_order[subnode_index]);
+	}
+      intersection = subnode_intersection(subnode);
+      if ( NULL == intersection )
+	{ /* this subnode is a triangle node, no sensitivity */
+	  parent_int[0+3*subnode_index+9*n] = 4;
+	  parent_int[1+3*subnode_index+9*n] = EMPTY;
+	  parent_int[2+3*subnode_index+9*n] = EMPTY;
+	}
+      else
+	{ /* this subnode is an intersection */
+	  segment = intersection_segment( intersection );
+	  parent_int[0+3*subnode_index+9*n] = 
+	    triangle_segment_index( triangle, segment );
+	  if ( EMPTY == parent_int[0+3*subnode_index+9*n] )
+	    { /* this subnode int has background tri */
+	      /* so find cut surface segment nodes */
+	      parent_int[0+3*subnode_index+9*n] = 3;
+	      parent_int[1+3*subnode_index+9*n] =
+		surface_node_index( surface,
+				    segment_node0(segment) );
+	      parent_int[2+3*subnode_index+9*n] =
+		surface_node_index( surface,
+				    segment_node1(segment) );
+			    
+	      if ( ( 0 > parent_int[1+3*subnode_index+9*n] ) || 
+		   ( surface_nsegment(surface) <=
+		     parent_int[1+3*subnode_index+9*n] ) ||
+		   (0 > parent_int[2+3*subnode_index+9*n] ) || 
+		   ( surface_nsegment(surface) <=
+		     parent_int[2+3*subnode_index+9*n] ) )
+		{ /* error, the seg nodes are not in cut surf */
+		  printf("%s: %d: seg node is not in cut surf\n",
+			 __FILE__,__LINE__);
+		  return KNIFE_ARRAY_BOUND;
+		}
+	    }
+	  else
+	    { /* this subnode int has background segment */
+	      /* so find cut surface triangle index */
+	      other = intersection_triangle( intersection );
+	      triangle_index = 
+		surface_triangle_index(surface,other);
+	      if ( 0 <= triangle_index && 
+		   surface_ntriangle(surface) > triangle_index )
+		{ /* this subnode int has surf tri */
+		  parent_int[1+3*subnode_index+9*n] = 
+		    triangle_index;
+		  parent_int[2+3*subnode_index+9*n] = EMPTY;
+		}
+	      else
+		{ /* error, the tri is not part of cut surf */
+		  printf("%s: %d: int tri is not in cut surf\n",
+			 __FILE__,__LINE__);
+		  return KNIFE_ARRAY_BOUND;
+		}
+	    }
+	} 
+    } /* subnode_index */
+
   return KNIFE_SUCCESS;
 }
 
@@ -1638,17 +2107,10 @@ KNIFE_STATUS poly_boundary_sens( Poly poly, int face_index, int region,
 
 {
   int n;
-  int ixyz;
   int mask_index;
   Mask mask;
-  int triangle_index;
-  Triangle triangle, other;
+  Triangle triangle;
   int subtri_index;
-  Subtri subtri;
-  int subnode_index;
-  Subnode subnode;
-  Intersection intersection;
-  Segment segment;
 
   n = 0;
   for ( mask_index = 0;
@@ -1669,85 +2131,11 @@ KNIFE_STATUS poly_boundary_sens( Poly poly, int face_index, int region,
 			 __FILE__,__LINE__);
 		  return KNIFE_ARRAY_BOUND;
 		}
-	      subtri = triangle_subtri( triangle, subtri_index );
-	      for ( ixyz = 0 ; ixyz < 3 ; ixyz++ ) 
-		{
-		  parent_xyz[ixyz+3*0+9*n]=triangle_xyz0(triangle)[ixyz];
-		  parent_xyz[ixyz+3*1+9*n]=triangle_xyz1(triangle)[ixyz];
-		  parent_xyz[ixyz+3*2+9*n]=triangle_xyz2(triangle)[ixyz];
-		}
-
-	      for ( subnode_index = 0 ; subnode_index < 3 ; subnode_index++ )
-		{
-		  if ( mask_inward_pointing_normal( mask ) )
-		    {
-		      subnode = 
-			subtri_subnode(subtri,
-				        inward_subnode_order[subnode_index]);
-		    }
-		  else
-		    {
-		      subnode = 
-			subtri_subnode(subtri,
-				       outward_subnode_order[subnode_index]);
-		    }
-		  intersection = subnode_intersection(subnode);
-		  if ( NULL == intersection )
-		    { /* this subnode is a triangle node, no sensitivity */
-		      parent_int[0+3*subnode_index+9*n] = 4;
-		      parent_int[1+3*subnode_index+9*n] = EMPTY;
-		      parent_int[2+3*subnode_index+9*n] = EMPTY;
-		    }
-		  else
-		    { /* this subnode is an intersection */
-		      segment = intersection_segment( intersection );
-		      parent_int[0+3*subnode_index+9*n] = 
-			triangle_segment_index( triangle, segment );
-		      if ( EMPTY == parent_int[0+3*subnode_index+9*n] )
-			{ /* this subnode int has background tri */
-			  /* so find cut surface segment nodes */
-			  parent_int[0+3*subnode_index+9*n] = 3;
-			  parent_int[1+3*subnode_index+9*n] =
-			    surface_node_index( surface,
-						segment_node0(segment) );
-			  parent_int[2+3*subnode_index+9*n] =
-			    surface_node_index( surface,
-						segment_node1(segment) );
-			    
-			  if ( ( 0 > parent_int[1+3*subnode_index+9*n] ) || 
-			       ( surface_nsegment(surface) <=
-				 parent_int[1+3*subnode_index+9*n] ) ||
-			       (0 > parent_int[2+3*subnode_index+9*n] ) || 
-			       ( surface_nsegment(surface) <=
-				 parent_int[2+3*subnode_index+9*n] ) )
-			    { /* error, the seg nodes are not in cut surf */
-			      printf("%s: %d: seg node is not in cut surf\n",
-				     __FILE__,__LINE__);
-			      return KNIFE_ARRAY_BOUND;
-			    }
-			}
-		      else
-			{ /* this subnode int has background segment */
-			  /* so find cut surface triangle index */
-			  other = intersection_triangle( intersection );
-			  triangle_index = 
-			    surface_triangle_index(surface,other);
-			  if ( 0 <= triangle_index && 
-			       surface_ntriangle(surface) > triangle_index )
-			    { /* this subnode int has surf tri */
-			      parent_int[1+3*subnode_index+9*n] = 
-				triangle_index;
-			      parent_int[2+3*subnode_index+9*n] = EMPTY;
-			    }
-			  else
-			    { /* error, the tri is not part of cut surf */
-			      printf("%s: %d: int tri is not in cut surf\n",
-				     __FILE__,__LINE__);
-			      return KNIFE_ARRAY_BOUND;
-			    }
-			}
-		    } 
-		} /* subnode_index */
+	      TRY( poly_boundary_subtri_sens( mask,
+					      triangle_subtri( triangle, 
+							       subtri_index ),
+					      n, parent_int, parent_xyz,
+					      surface ), "boundary subtri sens" );
 	      n++;
 	    }  /* face_index subtri_index region */
     } /* mask_index */
@@ -1762,6 +2150,91 @@ KNIFE_STATUS poly_boundary_sens( Poly poly, int face_index, int region,
   return KNIFE_SUCCESS;
 }
 
+KNIFE_STATUS poly_boundary_nsubtri_regions( Poly poly, int face_index, 
+					    int nregion, int *nsubtri )
+{
+  int mask_index;
+  Mask mask;
+  Triangle triangle;
+  int subtri_index, region;
+
+  for ( region = 1 ; region <= nregion ; region++ ) nsubtri[region-1] = 0;
+
+  for ( mask_index = 0;
+	mask_index < poly_nmask(poly); 
+	mask_index++)
+    {
+      mask = poly_mask(poly,mask_index);
+      triangle = mask_triangle(mask);
+      if ( face_index == triangle_boundary_face_index(triangle) )
+	for ( subtri_index = 0 ; 
+	      subtri_index < triangle_nsubtri( triangle);
+	      subtri_index++ )
+	  {
+	    region = mask_subtri_region(mask,subtri_index);
+	    if ( 1 <= region && region <= nregion ) nsubtri[region-1]++;
+	  }
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS poly_boundary_subtri_regions( Poly poly, int face_index, 
+					   int nregion, int *offset,
+					   double *triangle_node0, 
+					   double *triangle_node1,
+					   double *triangle_node2,
+					   double *triangle_normal,
+					   double *triangle_area,
+					   int *parent_int,
+					   double *parent_xyz,
+					   Surface surface )
+{
+  int mask_index;
+  Mask mask;
+  Triangle triangle;
+  int subtri_index, region, n;
+  Subtri subtri;
+
+  double normal[3], entire_triangle_area;
+
+  for ( mask_index = 0;
+	mask_index < poly_nmask(poly); 
+	mask_index++)
+    {
+      mask = poly_mask(poly,mask_index);
+      triangle = mask_triangle(mask);
+      if ( face_index != triangle_boundary_face_index(triangle) ) continue;
+      TRY( triangle_area_normal( triangle, &entire_triangle_area, normal ),
+	   "triangle area normal" );
+      if ( mask_inward_pointing_normal( mask ) )
+	{
+	  normal[0] = -normal[0];
+	  normal[1] = -normal[1];
+	  normal[2] = -normal[2];
+	}
+      for ( subtri_index = 0 ; 
+	    subtri_index < triangle_nsubtri( triangle);
+	    subtri_index++ )
+	{
+	  region = mask_subtri_region(mask,subtri_index);
+	  if ( region < 1 || region > nregion ) continue;
+	  n = offset[region-1];
+	  subtri = triangle_subtri( triangle, subtri_index );
+	  poly_oriented_subtri( mask, subtri, entire_triangle_area, normal, n,
+				triangle_node0, triangle_node1, triangle_node2,
+				triangle_normal, triangle_area );
+	  if ( NULL != parent_int )
+	    TRY( poly_boundary_subtri_sens( mask, subtri, n,
+					    parent_int, parent_xyz,
+					    surface ), "boundary subtri sens" );
+	  offset[region-1]++;
+	}
+    }
+
+  return KNIFE_SUCCESS;
+}
+
 KNIFE_STATUS poly_boundary_face_geometry( Poly poly, int face_index, FILE *f )
 {
   int mask_index;
@@ -37,9 +37,15 @@ END_C_DECLORATION
 
 BEGIN_C_DECLORATION
 
+/* open addressed hashes (power of two slots, at most half full) map
+ * the triangle of each mask or surf to its Mask */
 struct PolyStruct {
   Array mask;
   Array surf;
+  int nmask_hash;
+  Mask *mask_hash;
+  int nsurf_hash;
+  Mask *surf_hash;
 };
 
 Poly poly_create( void );
@@ -56,6 +62,7 @@ KnifeBool poly_has_surf_triangle( Poly, Triangle );
 KNIFE_STATUS poly_mask_with_triangle( Poly, Triangle, Mask * );
 
 KNIFE_STATUS poly_gather_surf( Poly );
+KNIFE_STATUS poly_reset_surf( Poly );
 
 KNIFE_STATUS poly_activate_all_subtri( Poly );
 KNIFE_STATUS poly_determine_active_subtri( Poly );
@@ -80,15 +87,13 @@ KnifeBool poly_active_mask_with_nodes( Poly, Node n0, Node n1, Node n2,
 KNIFE_STATUS poly_mask_surrounding_node_activity( Poly, Node,
                                                   KnifeBool *active );
 
-#define poly_add_mask( poly, new_mask )			\
-  array_add( (poly)->mask, (ArrayItem)(new_mask) )
+KNIFE_STATUS poly_add_mask( Poly, Mask );
 #define poly_nmask( poly )			\
   array_size( (poly)->mask )
 #define poly_mask( poly, mask_index )			\
   ((Mask)array_item( (poly)->mask, (mask_index) ))
 
-#define poly_add_surf( poly, new_surf )			\
-  array_add( (poly)->surf, (ArrayItem)(new_surf) )
+KNIFE_STATUS poly_add_surf( Poly, Mask );
 #define poly_nsurf( poly )			\
   array_size( (poly)->surf )
 #define poly_surf( poly, surf_index )			\
@@ -100,6 +105,9 @@ KNIFE_STATUS poly_mask_surrounding_node_activity( Poly, Node,
 KNIFE_STATUS poly_regions( Poly, int *regions );
 KNIFE_STATUS poly_centroid_volume( Poly, int region, double *origin, 
 				   double *centroid, double *volume );
+/* regions 1 to nregion in one pass, region r at centroid[3*(r-1)] */
+KNIFE_STATUS poly_centroid_volume_regions( Poly, int nregion, double *origin, 
+					   double *centroid, double *volume );
 KNIFE_STATUS poly_average_face_center( Poly, int region, double *centroid );
 
 KNIFE_STATUS poly_nsubtri_between( Poly poly1, int region1, 
@@ -114,6 +122,34 @@ KNIFE_STATUS poly_subtri_between( Poly poly1, int region1,
 				  double *triangle_normal,
 				  double *triangle_area );
 
+/* the _upto variants fill at most max_subtri and return the number
+ * found in nsubtri, so a buffer that was large enough is counted and
+ * filled by the same walk */
+KNIFE_STATUS poly_subtri_between_upto( Poly poly1, int region1, 
+				       Poly poly2, int region2,
+				       Node, int max_subtri, int *nsubtri,
+				       double *triangle_node0, 
+				       double *triangle_node1,
+				       double *triangle_node2,
+				       double *triangle_normal,
+				       double *triangle_area );
+
+/* every region pair in one scan of the masks of poly1, pair
+ * (region1,region2) is at (region1-1)+nregion1*(region2-1).  The subtri
+ * of a pair are in poly_subtri_between order and start at its offset,
+ * which is advanced past them */
+KNIFE_STATUS poly_nsubtri_between_regions( Poly poly1, int nregion1,
+					   Poly poly2, int nregion2,
+					   Node, int *nsubtri );
+KNIFE_STATUS poly_subtri_between_regions( Poly poly1, int nregion1,
+					  Poly poly2, int nregion2,
+					  Node, int *offset,
+					  double *triangle_node0, 
+					  double *triangle_node1,
+					  double *triangle_node2,
+					  double *triangle_normal,
+					  double *triangle_area );
+
 KNIFE_STATUS poly_between_sens( Poly poly1, int region1, 
 				Poly poly2, int region2,
 				Node node, int nsubtri,
@@ -130,11 +166,35 @@ KNIFE_STATUS poly_surface_subtri( Poly, int region, int nsubtri,
 				  double *triangle_area,
 				  int *triangle_tag );
 
+KNIFE_STATUS poly_surface_subtri_upto( Poly, int region, 
+				       int max_subtri, int *nsubtri, 
+				       double *triangle_node0, 
+				       double *triangle_node1,
+				       double *triangle_node2,
+				       double *triangle_normal,
+				       double *triangle_area,
+				       int *triangle_tag );
+
 KNIFE_STATUS poly_surface_sens( Poly, int region, int nsubtri, 
 				int *constraint_type,
 				double *constraint_xyz,
 				Surface surface );
 
+/* every region in one scan of the surf, the subtri of a region are in
+ * poly_surface_subtri order and start at its offset, which is advanced
+ * past them.  The constraints are skipped when constraint_type is NULL */
+KNIFE_STATUS poly_surface_nsubtri_regions( Poly, int nregion, int *nsubtri );
+KNIFE_STATUS poly_surface_subtri_regions( Poly, int nregion, int *offset,
+					  double *triangle_node0, 
+					  double *triangle_node1,
+					  double *triangle_node2,
+					  double *triangle_normal,
+					  double *triangle_area,
+					  int *triangle_tag,
+					  int *constraint_type,
+					  double *constraint_xyz,
+					  Surface surface );
+
 KNIFE_STATUS poly_boundary_nsubtri( Poly, int face_index, int region, 
 				    int *nsubtri );
 KNIFE_STATUS poly_boundary_subtri( Poly, int face_index, int region, 
@@ -145,12 +205,35 @@ KNIFE_STATUS poly_boundary_subtri( Poly, int face_index, int region,
 				   double *triangle_normal,
 				   double *triangle_area );
 
+KNIFE_STATUS poly_boundary_subtri_upto( Poly, int face_index, int region, 
+					int max_subtri, int *nsubtri, 
+					double *triangle_node0, 
+					double *triangle_node1,
+					double *triangle_node2,
+					double *triangle_normal,
+					double *triangle_area );
+
 KNIFE_STATUS poly_boundary_sens( Poly, int face_index, int region, 
 				 int nsubtri, 
 				 int *parent_int,
 				 double *parent_xyz, 
 				 Surface surface );
 
+/* as poly_surface_subtri_regions for the masks on face_index, the
+ * parents are skipped when parent_int is NULL */
+KNIFE_STATUS poly_boundary_nsubtri_regions( Poly, int face_index, 
+					    int nregion, int *nsubtri );
+KNIFE_STATUS poly_boundary_subtri_regions( Poly, int face_index, 
+					   int nregion, int *offset,
+					   double *triangle_node0, 
+					   double *triangle_node1,
+					   double *triangle_node2,
+					   double *triangle_normal,
+					   double *triangle_area,
+					   int *parent_int,
+					   double *parent_xyz,
+					   Surface surface );
+
 KNIFE_STATUS poly_boundary_face_geometry( Poly, int face_index, FILE * );
 KNIFE_STATUS poly_surf_geometry( Poly, FILE * );
 
@@ -22,6 +22,31 @@
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+#define PRIMAL_MMAP
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(PRIMAL_MMAP) && defined(HAVE_SHM_OPEN)
+#define PRIMAL_SHM
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "primal.h"
 #include "set.h"
 
@@ -154,6 +179,9 @@ Primal primal_create(int nnode, int nface, int ncell)
   primal->surface_node = NULL;
   primal->surface_volume_node = NULL;
 
+  primal->shared = NULL;
+  primal->shared_bytes = 0;
+
   return primal;
 }
 
@@ -164,7 +192,11 @@ Primal primal_from_file( char *filename )
 
   end_of_string = strlen(filename);
 
-  if( strcmp(&filename[end_of_string-3],"tri") == 0 ) {
+  if( primal_is_snapshot( filename ) ||
+      ( end_of_string >= 4 && 
+	strcmp(&filename[end_of_string-4],"snap") == 0 ) ) {
+    primal = primal_from_snapshot( filename );
+  } else if( strcmp(&filename[end_of_string-3],"tri") == 0 ) {
     primal = primal_from_tri( filename );
   } else if( strcmp(&filename[end_of_string-3],"rid") == 0 ) {
     primal = primal_from_fast( filename );
@@ -178,56 +210,431 @@ Primal primal_from_file( char *filename )
   return primal;
 }
 
+/* whole file in memory: mapped read-only where mmap is available,
+ * otherwise read into a malloc buffer */
+static KNIFE_STATUS primal_map_file( char *filename, 
+				     char **contents, size_t *size )
+{
+#ifdef PRIMAL_MMAP
+  int fd;
+  struct stat info;
+
+  fd = open( filename, O_RDONLY );
+  if ( fd < 0 )
+    {
+      printf("%s: %d: unable to open %s\n",__FILE__,__LINE__,filename);
+      return KNIFE_FILE_ERROR;
+    }
+  if ( 0 != fstat( fd, &info ) || 0 >= info.st_size )
+    {
+      printf("%s: %d: unable to size %s\n",__FILE__,__LINE__,filename);
+      close( fd );
+      return KNIFE_FILE_ERROR;
+    }
+  *size = (size_t)info.st_size;
+  *contents = (char *)mmap( NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close( fd );
+  if ( MAP_FAILED == (void *)(*contents) )
+    {
+      printf("%s: %d: unable to map %s\n",__FILE__,__LINE__,filename);
+      *contents = NULL;
+      return KNIFE_FILE_ERROR;
+    }
+#ifdef MADV_SEQUENTIAL
+  madvise( *contents, *size, MADV_SEQUENTIAL );
+#endif
+#else
+  FILE *file;
+  long length;
+
+  file = fopen(filename,"r");
+  if ( NULL == file )
+    {
+      printf("%s: %d: NULL file pointer to %s\n",
+	     __FILE__,__LINE__,filename);
+      return KNIFE_FILE_ERROR;
+    }
+  if ( 0 != fseek( file, 0, SEEK_END ) || 0 >= ( length = ftell( file ) ) )
+    {
+      printf("%s: %d: unable to size %s\n",__FILE__,__LINE__,filename);
+      fclose( file );
+      return KNIFE_FILE_ERROR;
+    }
+  rewind( file );
+  *size = (size_t)length;
+  *contents = (char *)malloc( *size );
+  if ( NULL == (*contents) )
+    {
+      printf("%s: %d: malloc failed in primal_map_file\n",__FILE__,__LINE__);
+      fclose( file );
+      return KNIFE_MEMORY;
+    }
+  if ( *size != fread( *contents, 1, *size, file ) )
+    {
+      printf("%s: %d: unable to read %s\n",__FILE__,__LINE__,filename);
+      free( *contents );
+      *contents = NULL;
+      fclose( file );
+      return KNIFE_FILE_ERROR;
+    }
+  fclose( file );
+#endif
+
+  return KNIFE_SUCCESS;
+}
+
+static void primal_unmap_file( char *contents, size_t size )
+{
+  if ( NULL == contents ) return;
+#ifdef PRIMAL_MMAP
+  munmap( contents, size );
+#else
+  free( contents );
+#endif
+}
+
+/* ascii .tri and .fgrid files are whitespace separated numbers parsed
+ * by hand from the mapped file; a double with at most 15 significant
+ * digits and a power of ten within 22 is one correctly rounded multiply
+ * or divide of exact values, so it matches strtod (fscanf), anything
+ * else is handed to strtod */
+
+#define PRIMAL_TOKEN_LENGTH (128)
+
+#define primal_space(c) ( ' ' == (c) || '\n' == (c) || '\t' == (c) || \
+			  '\r' == (c) || '\v' == (c) || '\f' == (c) )
+#define primal_digit(c) ( (c) >= '0' && (c) <= '9' )
+
+static double primal_power_of_ten[] = { 
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static char *primal_skip_space( char *cursor, char *end )
+{
+  while ( cursor < end && primal_space(*cursor) ) cursor++;
+  return cursor;
+}
+
+static KNIFE_STATUS primal_parse_int( char **cursor, char *end, int *value )
+{
+  char *c;
+  KnifeBool negative;
+  long sum;
+
+  c = primal_skip_space( *cursor, end );
+  if ( c >= end ) return KNIFE_NOT_FOUND;
+
+  negative = (KnifeBool)( '-' == *c );
+  if ( '-' == *c || '+' == *c ) c++;
+  if ( c >= end || !primal_digit(*c) ) return KNIFE_FILE_ERROR;
+
+  sum = 0;
+  while ( c < end && primal_digit(*c) ) sum = 10*sum + (*c++ - '0');
+  if ( c < end && !primal_space(*c) ) return KNIFE_FILE_ERROR;
+
+  *value = (int)( negative ? -sum : sum );
+  *cursor = c;
+
+  return KNIFE_SUCCESS;
+}
+
+static KNIFE_STATUS primal_parse_double( char **cursor, char *end, 
+					 double *value )
+{
+  char *c, *start, *stop;
+  char token[PRIMAL_TOKEN_LENGTH];
+  KnifeBool negative, exact, any;
+  double mantissa;
+  int digits, exponent, power, power_sign;
+
+  c = primal_skip_space( *cursor, end );
+  if ( c >= end ) return KNIFE_NOT_FOUND;
+  start = c;
+
+  negative = (KnifeBool)( '-' == *c );
+  if ( '-' == *c || '+' == *c ) c++;
+
+  mantissa = 0.0;
+  digits = 0;
+  exponent = 0;
+  exact = TRUE;
+  any = FALSE;
+  while ( c < end && primal_digit(*c) )
+    {
+      any = TRUE;
+      if ( 0 < digits || '0' != *c ) digits++;
+      if ( digits <= 15 ) 
+	mantissa = 10.0*mantissa + (double)(*c - '0');
+      else
+	exact = FALSE;
+      c++;
+    }
+  if ( c < end && '.' == *c )
+    {
+      c++;
+      while ( c < end && primal_digit(*c) )
+	{
+	  any = TRUE;
+	  if ( 0 < digits || '0' != *c ) digits++;
+	  if ( digits <= 15 ) 
+	    {
+	      mantissa = 10.0*mantissa + (double)(*c - '0');
+	      exponent--;
+	    }
+	  else
+	    {
+	      exact = FALSE;
+	    }
+	  c++;
+	}
+    }
+  if ( any && c < end && ( 'e' == *c || 'E' == *c ) )
+    {
+      c++;
+      power_sign = 1;
+      if ( c < end && ( '-' == *c || '+' == *c ) )
+	{
+	  if ( '-' == *c ) power_sign = -1;
+	  c++;
+	}
+      if ( c >= end || !primal_digit(*c) ) any = FALSE;
+      power = 0;
+      while ( c < end && primal_digit(*c) )
+	{
+	  if ( power < 100000 ) power = 10*power + (*c - '0');
+	  c++;
+	}
+      exponent += power_sign*power;
+    }
+
+  if ( any && exact && ( c >= end || primal_space(*c) ) &&
+       exponent >= -22 && exponent <= 22 )
+    {
+      if ( exponent < 0 )
+	*value = mantissa / primal_power_of_ten[-exponent];
+      else
+	*value = mantissa * primal_power_of_ten[exponent];
+      if ( negative ) *value = -(*value);
+      *cursor = c;
+      return KNIFE_SUCCESS;
+    }
+
+  /* inexact, inf, nan, hex, or not a number at all */
+  c = start;
+  while ( c < end && !primal_space(*c) ) c++;
+  if ( c - start >= PRIMAL_TOKEN_LENGTH ) return KNIFE_FILE_ERROR;
+  memcpy( token, start, (size_t)(c - start) );
+  token[c - start] = '\0';
+  *value = strtod( token, &stop );
+  if ( stop != token + (c - start) ) return KNIFE_FILE_ERROR;
+  *cursor = c;
+
+  return KNIFE_SUCCESS;
+}
+
+/* parse the token-th number after the sizes into its place in primal;
+ * .tri has the xyz of each node, .fgrid all x then all y then all z,
+ * followed by face nodes, face ids and (.fgrid) cell nodes */
+static KNIFE_STATUS primal_parse_token( Primal primal, KnifeBool fast,
+					size_t token, 
+					char **cursor, char *end )
+{
+  size_t nnode, nface, ncell;
+  int *value;
+  KNIFE_STATUS status;
+
+  nnode = (size_t)primal->nnode;
+  nface = (size_t)primal->nface;
+  ncell = (size_t)primal->ncell;
+
+  if ( token < 3*nnode )
+    {
+      if ( fast ) token = token/nnode + 3*(token%nnode);
+      return primal_parse_double( cursor, end, &(primal->xyz[token]) );
+    }
+  token -= 3*nnode;
+
+  if ( token < 3*nface )
+    {
+      value = &(primal->f2n[token%3 + 4*(token/3)]);
+      status = primal_parse_int( cursor, end, value );
+      if ( KNIFE_SUCCESS == status ) (*value)--;
+      return status;
+    }
+  token -= 3*nface;
+
+  if ( token < nface )
+    return primal_parse_int( cursor, end, &(primal->f2n[3+4*token]) );
+  token -= nface;
+
+  if ( fast && token < 4*ncell )
+    {
+      value = &(primal->c2n[token%4 + 4*(token/4)]);
+      status = primal_parse_int( cursor, end, value );
+      if ( KNIFE_SUCCESS == status ) (*value)--;
+      return status;
+    }
+
+  /* trailing tokens are ignored, as fscanf never reached them */
+  *cursor = primal_skip_space( *cursor, end );
+  if ( *cursor >= end ) return KNIFE_NOT_FOUND;
+  while ( *cursor < end && !primal_space(**cursor) ) (*cursor)++;
+  return KNIFE_SUCCESS;
+}
+
+/* parse every number in [begin,end) and report how many leading
+ * numbers were read before the first missing or malformed one.  With
+ * OpenMP the text is cut into chunks at whitespace, the numbers in
+ * each chunk are counted to find where each chunk starts, and the
+ * chunks are parsed concurrently */
+static KNIFE_STATUS primal_parse_body( Primal primal, KnifeBool fast,
+				       char *begin, char *end,
+				       size_t *nparsed )
+{
+  int nchunk, chunk;
+  char **chunk_begin;
+  size_t *chunk_token, *chunk_stop;
+
+#ifdef _OPENMP
+  nchunk = 4*omp_get_max_threads();
+  if ( end - begin < 1048576 ) nchunk = 1;
+#else
+  nchunk = 1;
+#endif
+
+  chunk_begin = (char **)malloc( (nchunk+1)*sizeof(char *) );
+  chunk_token = (size_t *)malloc( (nchunk+1)*sizeof(size_t) );
+  chunk_stop  = (size_t *)malloc( nchunk*sizeof(size_t) );
+  if ( NULL == chunk_begin || NULL == chunk_token || NULL == chunk_stop )
+    {
+      printf("%s: %d: malloc failed in primal_parse_body\n",
+	     __FILE__,__LINE__);
+      if ( NULL != chunk_begin ) free( chunk_begin );
+      if ( NULL != chunk_token ) free( chunk_token );
+      if ( NULL != chunk_stop  ) free( chunk_stop  );
+      return KNIFE_MEMORY;
+    }
+
+  chunk_begin[0] = begin;
+  chunk_begin[nchunk] = end;
+  for ( chunk = 1 ; chunk < nchunk ; chunk++ )
+    {
+      chunk_begin[chunk] = begin + (size_t)(end-begin)/nchunk*chunk;
+      if ( chunk_begin[chunk] < chunk_begin[chunk-1] )
+	chunk_begin[chunk] = chunk_begin[chunk-1];
+      while ( chunk_begin[chunk] < end && !primal_space(*chunk_begin[chunk]) )
+	chunk_begin[chunk]++;
+    }
+
+  chunk_token[0] = 0;
+  if ( nchunk > 1 )
+    {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for ( chunk = 0 ; chunk < nchunk ; chunk++ )
+	{
+	  char *c;
+	  size_t count;
+	  count = 0;
+	  for ( c = chunk_begin[chunk] ; c < chunk_begin[chunk+1] ; c++ )
+	    if ( !primal_space(*c) && 
+		 ( c == begin || primal_space(*(c-1)) ) ) count++;
+	  chunk_token[chunk+1] = count;
+	}
+      for ( chunk = 0 ; chunk < nchunk ; chunk++ )
+	chunk_token[chunk+1] += chunk_token[chunk];
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for ( chunk = 0 ; chunk < nchunk ; chunk++ )
+    {
+      char *cursor;
+      size_t token;
+      cursor = chunk_begin[chunk];
+      token = chunk_token[chunk];
+      while ( KNIFE_SUCCESS == primal_parse_token( primal, fast, token, 
+						    &cursor,
+						    chunk_begin[chunk+1] ) )
+	token++;
+      chunk_stop[chunk] = token;
+    }
+
+  /* the first chunk that stopped short of its end stopped the read */
+  *nparsed = chunk_stop[nchunk-1];
+  for ( chunk = 0 ; chunk < nchunk-1 ; chunk++ )
+    if ( chunk_stop[chunk] < chunk_token[chunk+1] )
+      {
+	*nparsed = chunk_stop[chunk];
+	break;
+      }
+
+  free( chunk_begin );
+  free( chunk_token );
+  free( chunk_stop );
+
+  return KNIFE_SUCCESS;
+}
+
 Primal primal_from_fast( char *filename )
 {
   Primal primal;
   int nnode, nface, ncell;
-  int i;
-  FILE *file;
+  char *contents, *cursor;
+  size_t size, nparsed;
+  KNIFE_STATUS status;
 
-  file = fopen(filename,"r");
-  TNN( file, "unable to open fast file");
+  if ( KNIFE_SUCCESS != primal_map_file( filename, &contents, &size ) )
+    {
+      printf("%s: %d: unable to open fast file %s\n",
+	     __FILE__,__LINE__,filename);
+      return NULL;
+    }
 
-  fscanf(file,"%d %d %d",&nnode,&nface,&ncell);
-  primal = primal_create( nnode, nface, ncell );
-  TNN( primal, "unable to create primal");
+  cursor = contents;
+  status = primal_parse_int( &cursor, contents+size, &nnode );
+  if ( KNIFE_SUCCESS == status )
+    status = primal_parse_int( &cursor, contents+size, &nface );
+  if ( KNIFE_SUCCESS == status )
+    status = primal_parse_int( &cursor, contents+size, &ncell );
+  if ( KNIFE_SUCCESS != status )
+    {
+      printf("%s: %d: unable to read fast sizes from %s\n",
+	     __FILE__,__LINE__,filename);
+      primal_unmap_file( contents, size );
+      return NULL;
+    }
 
-  for( i=0; i<nnode ; i++ ) fscanf(file,"%lf",&(primal->xyz[0+3*i]));
-  for( i=0; i<nnode ; i++ ) fscanf(file,"%lf",&(primal->xyz[1+3*i]));
-  for( i=0; i<nnode ; i++ ) fscanf(file,"%lf",&(primal->xyz[2+3*i]));
+  primal = primal_create( nnode, nface, ncell );
+  if ( NULL == primal )
+    {
+      printf("%s: %d: unable to create primal\n",__FILE__,__LINE__);
+      primal_unmap_file( contents, size );
+      return NULL;
+    }
 
-  for( i=0; i<nface ; i++ ) {
-    fscanf(file,"%d",&(primal->f2n[0+4*i]));
-    fscanf(file,"%d",&(primal->f2n[1+4*i]));
-    fscanf(file,"%d",&(primal->f2n[2+4*i]));
-    primal->f2n[0+4*i]--;
-    primal->f2n[1+4*i]--;
-    primal->f2n[2+4*i]--;
-    adj_add( primal->face_adj, primal->f2n[0+4*i], i);
-    adj_add( primal->face_adj, primal->f2n[1+4*i], i);
-    adj_add( primal->face_adj, primal->f2n[2+4*i], i);
-  }
+  status = primal_parse_body( primal, TRUE, cursor, contents+size, &nparsed );
 
-  for( i=0; i<nface ; i++ ) {
-    fscanf(file,"%d",&(primal->f2n[3+4*i]));
-  }
+  primal_unmap_file( contents, size );
 
-  for( i=0; i<ncell ; i++ ) {
-    fscanf(file,"%d",&(primal->c2n[0+4*i]));
-    fscanf(file,"%d",&(primal->c2n[1+4*i]));
-    fscanf(file,"%d",&(primal->c2n[2+4*i]));
-    fscanf(file,"%d",&(primal->c2n[3+4*i]));
-    primal->c2n[0+4*i]--;
-    primal->c2n[1+4*i]--;
-    primal->c2n[2+4*i]--;
-    primal->c2n[3+4*i]--;
-    adj_add( primal->cell_adj, primal->c2n[0+4*i], i);
-    adj_add( primal->cell_adj, primal->c2n[1+4*i], i);
-    adj_add( primal->cell_adj, primal->c2n[2+4*i], i);
-    adj_add( primal->cell_adj, primal->c2n[3+4*i], i);
-  }
+  if ( KNIFE_SUCCESS != status ||
+       nparsed < 3*(size_t)nnode + 4*(size_t)nface + 4*(size_t)ncell )
+    {
+      printf("%s: %d: read error in fast file %s after %lu numbers\n",
+	     __FILE__,__LINE__,filename,(unsigned long)nparsed);
+      primal_free( primal );
+      return NULL;
+    }
 
-  fclose(file);
+  if ( NULL == adj_add_elements( primal->face_adj, nface, 3, 4, primal->f2n ) ||
+       NULL == adj_add_elements( primal->cell_adj, ncell, 4, 4, primal->c2n ) )
+    {
+      printf("%s: %d: unable to build adjacency\n",__FILE__,__LINE__);
+      primal_free( primal );
+      return NULL;
+    }
 
   TSN( primal_establish_all( primal ), "primal_establish_all" );
 
@@ -289,10 +696,138 @@ KNIFE_STATUS primal_interrogate_tri( char *filename )
   return KNIFE_SUCCESS;
 }
 
+/* byte reverse n words in place, written as plain loops over whole
+ * blocks so the compiler can vectorize them */
+static void primal_swap4( void *block, size_t n )
+{
+  unsigned int *word = (unsigned int *)block;
+  size_t i;
+  for ( i = 0 ; i < n ; i++ )
+    word[i] = ( (word[i] >> 24) | ((word[i] >> 8) & 0x0000ff00u) |
+		((word[i] << 8) & 0x00ff0000u) | (word[i] << 24) );
+}
+
+static void primal_swap8( void *block, size_t n )
+{
+  unsigned int *word = (unsigned int *)block;
+  unsigned int high;
+  size_t i;
+  primal_swap4( block, 2*n );
+  for ( i = 0 ; i < n ; i++ )
+    {
+      high = word[2*i];
+      word[2*i] = word[2*i+1];
+      word[2*i+1] = high;
+    }
+}
+
+static int primal_tri_int( char *head, int word, KnifeBool big_endian )
+{
+  int value;
+  memcpy( &value, head+4*word, sizeof(int) );
+  if ( big_endian ) SWAP_INT(value);
+  return value;
+}
+
+/* a record marker past the bytes read so far is left for
+ * primal_tri_record to check */
+static KnifeBool primal_tri_marker( char *head, size_t length, size_t offset,
+				    KnifeBool big_endian, size_t marker )
+{
+  if ( offset + 4 > length ) return TRUE;
+  return (KnifeBool)( marker == 
+		      (size_t)primal_tri_int( head+offset, 0, big_endian ) );
+}
+
+/* recognize the binary .tri layouts from the first length bytes and
+ * the file size: Fortran unformatted records (4 byte markers, trailing
+ * records or padding allowed) or an exact stream of nnode, nface, xyz,
+ * f2n, ids; either endian, 4 or 8 byte reals */
+static KNIFE_STATUS primal_tri_layout( char *head, size_t length, size_t size,
+				       KnifeBool *big_endian,
+				       KnifeBool *records,
+				       int *real_byte_size,
+				       int *nnode, int *nface )
+{
+  int endian, real;
+  size_t xyz, f2n, ids, expected;
+
+  for ( endian = 0 ; endian < 2 ; endian++ )
+    {
+      *big_endian = (KnifeBool)( 1 == endian );
+
+      *records = TRUE;
+      *nnode = primal_tri_int( head, 1, *big_endian );
+      *nface = primal_tri_int( head, 2, *big_endian );
+      if ( 8 == primal_tri_int( head, 0, *big_endian ) &&
+	   8 == primal_tri_int( head, 3, *big_endian ) &&
+	   *nnode > 0 && *nface >= 0 )
+	for ( real = 4 ; real <= 8 ; real += 4 )
+	  {
+	    *real_byte_size = real;
+	    xyz = (size_t)(*nnode)*3*real;
+	    f2n = (size_t)(*nface)*12;
+	    ids = (size_t)(*nface)*4;
+	    expected = 16 + xyz + 8 + f2n + 8 + ids + 8;
+	    if ( xyz == (size_t)primal_tri_int( head, 4, *big_endian ) &&
+		 expected <= size &&
+		 primal_tri_marker( head, length, 20+xyz, *big_endian, xyz ) &&
+		 primal_tri_marker( head, length, 24+xyz, *big_endian, f2n ) &&
+		 primal_tri_marker( head, length, 28+xyz+f2n, 
+				    *big_endian, f2n ) &&
+		 primal_tri_marker( head, length, 32+xyz+f2n, 
+				    *big_endian, ids ) &&
+		 primal_tri_marker( head, length, 36+xyz+f2n+ids, 
+				    *big_endian, ids ) ) 
+	      return KNIFE_SUCCESS;
+	  }
+
+      *records = FALSE;
+      *nnode = primal_tri_int( head, 0, *big_endian );
+      *nface = primal_tri_int( head, 1, *big_endian );
+      if ( *nnode > 0 && *nface >= 0 )
+	for ( real = 4 ; real <= 8 ; real += 4 )
+	  {
+	    *real_byte_size = real;
+	    expected = 8 + (size_t)(*nnode)*3*real + (size_t)(*nface)*16;
+	    if ( expected == size ) return KNIFE_SUCCESS;
+	  }
+    }
+
+  return KNIFE_NOT_FOUND;
+}
+
+/* points data at the next length bytes of contents, checking the
+ * record markers around them when the file has records */
+static KNIFE_STATUS primal_tri_record( char *contents, size_t size, 
+				       size_t *offset,
+				       KnifeBool records, KnifeBool big_endian,
+				       size_t length, char **data )
+{
+  size_t marker;
+
+  marker = ( records ? 4 : 0 );
+  if ( *offset + marker + length + marker > size ) return KNIFE_FILE_ERROR;
+  if ( records &&
+       ( length != (size_t)primal_tri_int( contents+(*offset), 0, 
+					   big_endian ) ||
+	 length != (size_t)primal_tri_int( contents+(*offset)+4+length, 0,
+					   big_endian ) ) )
+    return KNIFE_FILE_ERROR;
+
+  *data = contents + (*offset) + marker;
+  *offset += marker + length + marker;
+
+  return KNIFE_SUCCESS;
+}
+
 Primal primal_from_tri( char *filename )
 {
   FILE *file;
-  int record_header;
+  char head[20];
+  long size;
+  KnifeBool big_endian, records;
+  int real_byte_size, nnode, nface;
   
   file = fopen(filename,"r");
   if ( NULL == file )
@@ -302,17 +837,17 @@ Primal primal_from_tri( char *filename )
       return NULL;
     }
 
-  AEN( 1, fread( &record_header, sizeof(int), 1, file), "record header" );
+  memset( head, 0, 20 );
+  AEN( TRUE, 0 < fread( head, 1, 20, file ), "file head" );
+  AEN( 0, fseek( file, 0, SEEK_END ), "file seek" );
+  size = ftell( file );
 
   fclose( file );
 
-  switch ( record_header )
-    {
-    case 8 : /* two 4 byte integers */
-    case 134217728 :  /* two 4 byte integers - big endian */
-      return primal_from_unformatted_tri( filename );
-      break;
-    }
+  if ( KNIFE_SUCCESS == primal_tri_layout( head, 20, (size_t)size, 
+					   &big_endian, &records,
+					   &real_byte_size, &nnode, &nface ) )
+    return primal_from_unformatted_tri( filename );
 
   return primal_from_ascii_tri( filename );
 }
@@ -322,62 +857,71 @@ Primal primal_from_ascii_tri( char *filename )
   Primal primal;
   int nnode, nface, ncell;
   int i;
-  FILE *file;
+  char *contents, *cursor;
+  size_t size, nparsed, nid;
+  KNIFE_STATUS status;
 
   int greatest_read_face_id;
-  KnifeBool read_error;
 
-  file = fopen(filename,"r");
-  if ( NULL == file )
+  TSN( primal_map_file( filename, &contents, &size ), "map tri file" );
+
+  cursor = contents;
+  status = primal_parse_int( &cursor, contents+size, &nnode );
+  if ( KNIFE_SUCCESS == status )
+    status = primal_parse_int( &cursor, contents+size, &nface );
+  if ( KNIFE_SUCCESS != status )
     {
-      printf("%s: %d: NULL file pointer to %s\n",
+      printf("%s: %d: unable to read tri sizes from %s\n",
 	     __FILE__,__LINE__,filename);
+      primal_unmap_file( contents, size );
       return NULL;
     }
 
-  fscanf(file,"%d %d",&nnode,&nface);
   ncell = 0;
   primal = primal_create( nnode, nface, ncell );
   if ( NULL == primal )
     {
       printf("%s: %d: primal_from_tri: primal creation \n",
 	     __FILE__,__LINE__);
+      primal_unmap_file( contents, size );
       return NULL;
     }
 
-  for( i=0; i<nnode ; i++ ) {
-    AEN( 1, fscanf(file,"%lf",&(primal->xyz[0+3*i])), "x read error" );
-    AEN( 1, fscanf(file,"%lf",&(primal->xyz[1+3*i])), "y read error");
-    AEN( 1, fscanf(file,"%lf",&(primal->xyz[2+3*i])), "z read error");
-  }
+  status = primal_parse_body( primal, FALSE, cursor, contents+size, &nparsed );
 
-  for( i=0; i<nface ; i++ ) {
-    AEN( 1, fscanf(file,"%d",&(primal->f2n[0+4*i])), "face index0 read error");
-    AEN( 1, fscanf(file,"%d",&(primal->f2n[1+4*i])), "face index1 read error");
-    AEN( 1, fscanf(file,"%d",&(primal->f2n[2+4*i])), "face index2 read error");
-    primal->f2n[0+4*i]--;
-    primal->f2n[1+4*i]--;
-    primal->f2n[2+4*i]--;
-    adj_add( primal->face_adj, primal->f2n[0+4*i], i);
-    adj_add( primal->face_adj, primal->f2n[1+4*i], i);
-    adj_add( primal->face_adj, primal->f2n[2+4*i], i);
-  }
+  primal_unmap_file( contents, size );
 
+  if ( KNIFE_SUCCESS != status || 
+       nparsed < 3*(size_t)nnode + 3*(size_t)nface )
+    {
+      printf("%s: %d: xyz or face index read error in %s\n",
+	     __FILE__,__LINE__,filename);
+      primal_free( primal );
+      return NULL;
+    }
+
+  /* face ids are optional; from the first one missing on, each face
+   * gets one more than the greatest id read */
+  nid = nparsed - ( 3*(size_t)nnode + 3*(size_t)nface );
   greatest_read_face_id = 0;
-  read_error = FALSE;
   for( i=0; i<nface ; i++ ) {
-    if ( !read_error && (1 == fscanf(file,"%d",&(primal->f2n[3+4*i]))) )
+    if ( (size_t)i < nid )
       {
 	greatest_read_face_id = MAX(primal->f2n[3+4*i], greatest_read_face_id);
       }
     else
       {
-	read_error = TRUE;
 	primal->f2n[3+4*i] = greatest_read_face_id + 1;
       }
   }
 
-  fclose(file);
+  if ( NULL == adj_add_elements( primal->face_adj, nface, 3, 4, primal->f2n ) )
+    {
+      printf("%s: %d: primal_from_tri: face adjacency \n",
+	     __FILE__,__LINE__);
+      primal_free( primal );
+      return NULL;
+    }
 
   TRYN( primal_establish_all( primal ), "primal_establish_all" );
 
@@ -387,109 +931,112 @@ Primal primal_from_ascii_tri( char *filename )
 Primal primal_from_unformatted_tri( char *filename )
 {
   Primal primal;
-  FILE *file;
-  int record_header, record_footer;
+  char *contents, *data;
+  size_t size, offset;
   int nnode, nface, ncell;
   int real_byte_size;
   float real4;
-  double real8;
+  int *vertex;
   int i,j;
+  KnifeBool big_endian, records;
+  KNIFE_STATUS status;
 
-  KnifeBool big_endian;
+  TSN( primal_map_file( filename, &contents, &size ), "map tri file" );
 
-  file = fopen(filename,"r");
-  if ( NULL == file )
+  if ( size < 20 ||
+       KNIFE_SUCCESS != primal_tri_layout( contents, size, size,
+					   &big_endian, &records,
+					   &real_byte_size, &nnode, &nface ) )
     {
-      printf("%s: %d: NULL file pointer to %s\n",
+      printf("%s: %d: %s is not an unformatted or stream tri file\n",
 	     __FILE__,__LINE__,filename);
+      primal_unmap_file( contents, size );
       return NULL;
     }
 
-  AEN( 1, fread( &record_header, sizeof(int), 1, file), "record header" );
-  AEN( 1, fread( &nnode, sizeof(int), 1, file), "nnode" );
-  AEN( 1, fread( &nface, sizeof(int), 1, file), "nface" );
-  AEN( 1, fread( &record_footer, sizeof(int), 1, file), "record footer" );
-  big_endian = (KnifeBool)( 134217728 == record_header );
-  if ( big_endian ) SWAP_INT(record_header);
-  if ( big_endian ) SWAP_INT(nnode);
-  if ( big_endian ) SWAP_INT(nface);
-  if ( big_endian ) SWAP_INT(record_footer);
-
-  AEN( record_header, record_footer, "sizing record mismatch");
-
   ncell = 0;
   primal = primal_create( nnode, nface, ncell );
   if ( NULL == primal )
     {
       printf("%s: %d: primal_from_tri: primal creation \n",
 	     __FILE__,__LINE__);
+      primal_unmap_file( contents, size );
       return NULL;
     }
 
-  AEN( 1, fread( &record_header, sizeof(int), 1, file), "record header" );
-  if ( big_endian ) SWAP_INT(record_header);
-
-  real_byte_size = record_header / 3 / nnode;
-
-  for( i=0; i<3*nnode ; i++ ) 
+  /* blocks are copied straight from the file into the primal arrays
+   * and swapped there in one pass; the vertex block goes in the tail
+   * of f2n and is spread front to back, never overwriting an unread
+   * vertex */
+  offset = 0;
+  status = primal_tri_record( contents, size, &offset, records, big_endian,
+			      8, &data );
+  if ( KNIFE_SUCCESS == status )
+    status = primal_tri_record( contents, size, &offset, records, 
+				big_endian, (size_t)nnode*3*real_byte_size,
+				&data );
+  if ( KNIFE_SUCCESS == status )
     {
-      switch (real_byte_size )
+      if ( 8 == real_byte_size )
 	{
-	case 4:
-	  AEN( 1, fread( &real4, sizeof(float), 1, file), "4 byte xyz" );
-	  if ( big_endian ) SWAP_FLOAT(real4);
-	  primal->xyz[i] = (double)real4;
-	  break;
-	case 8:
-	  AEN( 1, fread( &real8, sizeof(double), 1, file), "8 byte xyz" );
-	  if ( big_endian ) SWAP_DOUBLE(real8);
-	  primal->xyz[i] = (double)real8;
-	  break;
-	default:
-	  printf("%s: %d: primal_from_tri: xyz byte size %d \n",
-		 __FILE__,__LINE__,real_byte_size);
-	  return NULL;
+	  memcpy( primal->xyz, data, (size_t)nnode*3*sizeof(double) );
+	  if ( big_endian ) primal_swap8( primal->xyz, (size_t)nnode*3 );
+	}
+      else
+	{
+	  for( i=0; i<3*nnode ; i++ )
+	    {
+	      memcpy( &real4, data+4*i, sizeof(float) );
+	      if ( big_endian ) SWAP_FLOAT(real4);
+	      primal->xyz[i] = (double)real4;
+	    }
 	}
     }
 
-  AEN( 1, fread( &record_footer, sizeof(int), 1, file), "record footer" );
-  if ( big_endian ) SWAP_INT(record_footer);
-  AEN( record_header, record_footer, "xyz record mismatch");
-
-  AEN( 1, fread( &record_header, sizeof(int), 1, file), "record header" );
-  if ( big_endian ) SWAP_INT(record_header);
-  AEN( record_header, 3*nface*4, "vertex record wrong size");
+  if ( KNIFE_SUCCESS == status )
+    status = primal_tri_record( contents, size, &offset, records, 
+				big_endian, (size_t)nface*3*sizeof(int),
+				&data );
+  if ( KNIFE_SUCCESS == status )
+    {
+      vertex = primal->f2n + nface;
+      memcpy( vertex, data, (size_t)nface*3*sizeof(int) );
+      if ( big_endian ) primal_swap4( vertex, (size_t)nface*3 );
+      for( j=0; j<nface ; j++ ) 
+	for( i=0; i<3 ; i++ ) 
+	  primal->f2n[i+4*j] = vertex[i+3*j] - 1;
+    }
 
-  for( j=0; j<nface ; j++ ) 
+  if ( KNIFE_SUCCESS == status )
+    status = primal_tri_record( contents, size, &offset, records, 
+				big_endian, (size_t)nface*sizeof(int),
+				&data );
+  if ( KNIFE_SUCCESS == status )
     {
-      for( i=0; i<3 ; i++ ) 
+      for( j=0; j<nface ; j++ ) 
 	{
-	  AEN( 1, fread( &(primal->f2n[i+4*j]), sizeof(int), 1, file), 
-	       "4 byte vertex" );
-	  if ( big_endian ) SWAP_INT(primal->f2n[i+4*j]);
-	  primal->f2n[i+4*j]--;
-	  adj_add( primal->face_adj, primal->f2n[i+4*j], j);
+	  memcpy( &(primal->f2n[3+4*j]), data+4*j, sizeof(int) );
+	  if ( big_endian ) SWAP_INT(primal->f2n[3+4*j]);
 	}
     }
-  
-  AEN( 1, fread( &record_footer, sizeof(int), 1, file), "record footer" );
-  if ( big_endian ) SWAP_INT(record_footer);
-  AEN( record_header, record_footer, "vertex record mismatch");
 
-  AEN( 1, fread( &record_header, sizeof(int), 1, file), "record header" );
-  if ( big_endian ) SWAP_INT(record_header);
-  AEN( record_header, nface*4, "component record wrong size");
+  primal_unmap_file( contents, size );
 
-  for( j=0; j<nface ; j++ ) 
+  if ( KNIFE_SUCCESS != status )
     {
-      AEN( 1, fread( &(primal->f2n[3+4*j]), sizeof(int), 1, file), 
-	   "4 byte component" );
-      if ( big_endian ) SWAP_INT(primal->f2n[3+4*j]);
+      printf("%s: %d: %s record markers or sizes are inconsistent\n",
+	     __FILE__,__LINE__,filename);
+      primal_free( primal );
+      return NULL;
+    }
+
+  if ( NULL == adj_add_elements( primal->face_adj, nface, 3, 4, primal->f2n ) )
+    {
+      printf("%s: %d: primal_from_tri: face adjacency \n",
+	     __FILE__,__LINE__);
+      primal_free( primal );
+      return NULL;
     }
-  
-  AEN( 1, fread( &record_footer, sizeof(int), 1, file), "record footer" );
-  if ( big_endian ) SWAP_INT(record_footer);
-  AEN( record_header, record_footer, "componet record mismatch");
 
   TRYN( primal_establish_all( primal ), "primal_establish_all" );
 
@@ -500,8 +1047,17 @@ void primal_free( Primal primal )
 {
   if ( NULL == primal ) return;
 
-  free( primal->xyz );
-  free( primal->f2n );
+  if ( NULL != primal->shared )
+    {
+#ifdef PRIMAL_SHM
+      munmap( primal->shared, primal->shared_bytes );
+#endif
+    }
+  else
+    {
+      free( primal->xyz );
+      free( primal->f2n );
+    }
   free( primal->c2n );
 
   adj_free( primal->face_adj );
@@ -548,6 +1104,29 @@ KNIFE_STATUS primal_copy_volume( Primal primal,
   return KNIFE_SUCCESS;
 }
 
+/* new coordinates of every node, the connectivity is unchanged */
+KNIFE_STATUS primal_copy_xyz( Primal primal, 
+			      double *x, double *y, double *z )
+{
+  int node;
+
+  if ( NULL != primal->shared )
+    {
+      printf("%s: %d: primal_copy_xyz shared primal is read only\n",
+	     __FILE__,__LINE__);
+      return KNIFE_IMPLEMENT;
+    }
+
+  for( node=0; node<primal_nnode(primal) ; node++ ) 
+    {
+      primal->xyz[0+3*node] = x[node];
+      primal->xyz[1+3*node] = y[node];
+      primal->xyz[2+3*node] = z[node];
+    }
+
+  return KNIFE_SUCCESS;
+}
+
 static int nface_added = 0;
 
 KNIFE_STATUS primal_copy_boundary( Primal primal, int face_id, 
@@ -1057,6 +1636,29 @@ KNIFE_STATUS primal_find_tri_side( Primal primal, int tri, int node0, int node1,
   return KNIFE_NOT_FOUND;
 }
 
+KNIFE_STATUS primal_bounding_box( Primal primal, 
+				  double *lower, double *upper )
+{
+  int node, ixyz;
+
+  if ( 0 == primal->nnode ) return KNIFE_NOT_FOUND;
+
+  for ( ixyz = 0 ; ixyz < 3 ; ixyz++ )
+    {
+      lower[ixyz] = primal->xyz[ixyz];
+      upper[ixyz] = primal->xyz[ixyz];
+    }
+
+  for( node=1; node<primal->nnode ; node++ ) 
+    for ( ixyz = 0 ; ixyz < 3 ; ixyz++ )
+      {
+	lower[ixyz] = MIN( lower[ixyz], primal->xyz[ixyz+3*node] );
+	upper[ixyz] = MAX( upper[ixyz], primal->xyz[ixyz+3*node] );
+      }
+
+  return KNIFE_SUCCESS;
+}
+
 KNIFE_STATUS primal_scale_about( Primal primal, 
 				 double x, double y, double z, double scale )
 {
@@ -1476,6 +2078,534 @@ KNIFE_STATUS primal_export_fast( Primal primal, char *filename )
   return KNIFE_SUCCESS;
 }
 
+/* snapshot: native binary image of an established primal.  After the
+ * 8 byte magic come PRIMAL_SNAPSHOT_NINT ints (version, byte order and
+ * size checks, counts) and then each array of primal_snapshot_blocks
+ * padded to a multiple of 8 bytes, so every block of a mapped file is
+ * aligned and can be copied straight into place */
+
+#define PRIMAL_SNAPSHOT_MAGIC "KNIFESNP"
+#define PRIMAL_SNAPSHOT_VERSION (1)
+#define PRIMAL_SNAPSHOT_NINT (16)
+#define PRIMAL_SNAPSHOT_NBLOCK (13)
+
+#define primal_snapshot_padded(bytes) ( ((bytes)+7) & ~((size_t)7) )
+
+/* lists[0-3] : face_adj start and item, cell_adj start and item */
+static void primal_snapshot_blocks( Primal primal, int *header, int **lists,
+				    void **block, size_t *bytes )
+{
+  int i;
+
+  i = 0;
+  block[i] = primal->xyz;   bytes[i++] = 3*(size_t)header[5]*sizeof(double);
+  block[i] = primal->f2n;   bytes[i++] = 4*(size_t)header[6]*sizeof(int);
+  block[i] = primal->c2n;   bytes[i++] = 4*(size_t)header[7]*sizeof(int);
+  block[i] = primal->c2e;   bytes[i++] = 6*(size_t)header[7]*sizeof(int);
+  block[i] = primal->e2n;   bytes[i++] = 2*(size_t)header[8]*sizeof(int);
+  block[i] = primal->c2t;   bytes[i++] = 4*(size_t)header[7]*sizeof(int);
+  block[i] = primal->t2n;   bytes[i++] = 3*(size_t)header[9]*sizeof(int);
+  block[i] = primal->surface_node;
+  bytes[i++] = (size_t)header[5]*sizeof(int);
+  block[i] = primal->surface_volume_node;
+  bytes[i++] = (size_t)header[10]*sizeof(int);
+  block[i] = lists[0];      bytes[i++] = (size_t)(header[11]+1)*sizeof(int);
+  block[i] = lists[1];      bytes[i++] = (size_t)header[12]*sizeof(int);
+  block[i] = lists[2];      bytes[i++] = (size_t)(header[13]+1)*sizeof(int);
+  block[i] = lists[3];      bytes[i++] = (size_t)header[14]*sizeof(int);
+}
+
+static KNIFE_STATUS primal_snapshot_lists( int *header, int **lists )
+{
+  int i;
+
+  lists[0] = (int *)malloc( (size_t)(header[11]+1)*sizeof(int) );
+  lists[1] = (int *)malloc( MAX((size_t)header[12],1)*sizeof(int) );
+  lists[2] = (int *)malloc( (size_t)(header[13]+1)*sizeof(int) );
+  lists[3] = (int *)malloc( MAX((size_t)header[14],1)*sizeof(int) );
+  for ( i = 0 ; i < 4 ; i++ )
+    if ( NULL == lists[i] )
+      {
+	printf("%s: %d: malloc failed in primal_snapshot_lists\n",
+	       __FILE__,__LINE__);
+	return KNIFE_MEMORY;
+      }
+
+  return KNIFE_SUCCESS;
+}
+
+static void primal_snapshot_free_lists( int **lists )
+{
+  int i;
+  for ( i = 0 ; i < 4 ; i++ ) 
+    if ( NULL != lists[i] ) free( lists[i] );
+}
+
+KNIFE_STATUS primal_export_snapshot( Primal primal, char *filename )
+{
+  FILE *f;
+  int header[PRIMAL_SNAPSHOT_NINT];
+  int *lists[4];
+  void *block[PRIMAL_SNAPSHOT_NBLOCK];
+  size_t bytes[PRIMAL_SNAPSHOT_NBLOCK];
+  char zero[8];
+  size_t pad;
+  int i;
+  KNIFE_STATUS status;
+
+  NOT_NULL( primal, "primal NULL" );
+  if ( NULL == primal->c2e || NULL == primal->c2t || 
+       NULL == primal->surface_node )
+    {
+      printf("%s: %d: primal_export_snapshot: primal not established\n",
+	     __FILE__,__LINE__);
+      return KNIFE_IMPROPER;
+    }
+
+  memset( header, 0, PRIMAL_SNAPSHOT_NINT*sizeof(int) );
+  header[0]  = PRIMAL_SNAPSHOT_VERSION;
+  header[1]  = 1; /* reads back as 1 only in the same byte order */
+  header[2]  = (int)sizeof(int);
+  header[3]  = (int)sizeof(double);
+  header[4]  = primal->nnode0;
+  header[5]  = primal->nnode;
+  header[6]  = primal->nface;
+  header[7]  = primal->ncell;
+  header[8]  = primal->nedge;
+  header[9]  = primal->ntri;
+  header[10] = primal->surface_nnode;
+  header[11] = adj_nnode( primal->face_adj );
+  header[12] = adj_nitem( primal->face_adj );
+  header[13] = adj_nnode( primal->cell_adj );
+  header[14] = adj_nitem( primal->cell_adj );
+
+  status = primal_snapshot_lists( header, lists );
+  if ( KNIFE_SUCCESS != status )
+    {
+      primal_snapshot_free_lists( lists );
+      return status;
+    }
+  adj_lists( primal->face_adj, lists[0], lists[1] );
+  adj_lists( primal->cell_adj, lists[2], lists[3] );
+  primal_snapshot_blocks( primal, header, lists, block, bytes );
+
+  if (NULL == filename)
+    {
+      f = fopen( "primal.snap", "wb" );
+    } else {
+      f = fopen( filename, "wb" );
+    }
+
+  status = KNIFE_FILE_ERROR;
+  if ( NULL != f )
+    {
+      memset( zero, 0, 8 );
+      status = KNIFE_SUCCESS;
+      if ( 1 != fwrite( PRIMAL_SNAPSHOT_MAGIC, 8, 1, f ) ||
+	   1 != fwrite( header, PRIMAL_SNAPSHOT_NINT*sizeof(int), 1, f ) )
+	status = KNIFE_FILE_ERROR;
+      for ( i = 0 ; KNIFE_SUCCESS == status && 
+	      i < PRIMAL_SNAPSHOT_NBLOCK ; i++ )
+	{
+	  pad = primal_snapshot_padded(bytes[i]) - bytes[i];
+	  if ( ( bytes[i] > 0 && 1 != fwrite( block[i], bytes[i], 1, f ) ) ||
+	       ( pad > 0 && 1 != fwrite( zero, pad, 1, f ) ) )
+	    status = KNIFE_FILE_ERROR;
+	}
+      if ( 0 != fclose(f) ) status = KNIFE_FILE_ERROR;
+    }
+
+  primal_snapshot_free_lists( lists );
+
+  return status;
+}
+
+KnifeBool primal_is_snapshot( char *filename )
+{
+  FILE *f;
+  char magic[8];
+  KnifeBool is_snapshot;
+
+  f = fopen( filename, "rb" );
+  if ( NULL == f ) return FALSE;
+  is_snapshot = (KnifeBool)( 1 == fread( magic, 8, 1, f ) &&
+			     0 == memcmp( magic, PRIMAL_SNAPSHOT_MAGIC, 8 ) );
+  fclose( f );
+
+  return is_snapshot;
+}
+
+Primal primal_from_snapshot( char *filename )
+{
+  Primal primal;
+  char *contents;
+  size_t size, offset;
+  int header[PRIMAL_SNAPSHOT_NINT];
+  int *lists[4];
+  void *block[PRIMAL_SNAPSHOT_NBLOCK];
+  size_t bytes[PRIMAL_SNAPSHOT_NBLOCK];
+  int i;
+  KNIFE_STATUS status;
+
+  TSN( primal_map_file( filename, &contents, &size ), "map snapshot" );
+
+  offset = 8 + PRIMAL_SNAPSHOT_NINT*sizeof(int);
+  if ( size < offset || 0 != memcmp( contents, PRIMAL_SNAPSHOT_MAGIC, 8 ) )
+    {
+      printf("%s: %d: %s is not a knife snapshot\n",
+	     __FILE__,__LINE__,filename);
+      primal_unmap_file( contents, size );
+      return NULL;
+    }
+  memcpy( header, contents+8, PRIMAL_SNAPSHOT_NINT*sizeof(int) );
+  if ( PRIMAL_SNAPSHOT_VERSION != header[0] || 1 != header[1] ||
+       (int)sizeof(int) != header[2] || (int)sizeof(double) != header[3] )
+    {
+      printf("%s: %d: %s snapshot version %d or byte order unsupported\n",
+	     __FILE__,__LINE__,filename,header[0]);
+      primal_unmap_file( contents, size );
+      return NULL;
+    }
+  for ( i = 4 ; i < 15 ; i++ )
+    if ( header[i] < 0 )
+      {
+	printf("%s: %d: %s snapshot count %d negative\n",
+	       __FILE__,__LINE__,filename,i);
+	primal_unmap_file( contents, size );
+	return NULL;
+      }
+
+  primal = primal_create( header[5], header[6], header[7] );
+  if ( NULL == primal )
+    {
+      printf("%s: %d: unable to create primal\n",__FILE__,__LINE__);
+      primal_unmap_file( contents, size );
+      return NULL;
+    }
+  primal->nnode0 = header[4];
+  primal->nedge = header[8];
+  primal->ntri = header[9];
+  primal->surface_nnode = header[10];
+  primal->c2e = (int *)malloc( MAX(6*primal->ncell,1)*sizeof(int) );
+  primal->e2n = (int *)malloc( MAX(2*primal->nedge,1)*sizeof(int) );
+  primal->c2t = (int *)malloc( MAX(4*primal->ncell,1)*sizeof(int) );
+  primal->t2n = (int *)malloc( MAX(3*primal->ntri,1)*sizeof(int) );
+  primal->surface_node = (int *)malloc( MAX(primal->nnode,1)*sizeof(int) );
+  primal->surface_volume_node = 
+    (int *)malloc( MAX(primal->surface_nnode,1)*sizeof(int) );
+
+  status = primal_snapshot_lists( header, lists );
+  if ( adj_nnode( primal->face_adj ) != header[11] ||
+       adj_nnode( primal->cell_adj ) != header[13] ) 
+    status = KNIFE_INCONSISTENT;
+  primal_snapshot_blocks( primal, header, lists, block, bytes );
+  for ( i = 0 ; KNIFE_SUCCESS == status && i < PRIMAL_SNAPSHOT_NBLOCK ; i++ )
+    {
+      if ( NULL == block[i] ) 
+	{
+	  status = KNIFE_MEMORY;
+	}
+      else if ( offset + primal_snapshot_padded(bytes[i]) > size )
+	{
+	  status = KNIFE_FILE_ERROR;
+	}
+      else
+	{
+	  memcpy( block[i], contents+offset, bytes[i] );
+	  offset += primal_snapshot_padded(bytes[i]);
+	}
+    }
+
+  primal_unmap_file( contents, size );
+
+  if ( KNIFE_SUCCESS == status &&
+       ( NULL == adj_from_lists( primal->face_adj, lists[0], lists[1] ) ||
+	 NULL == adj_from_lists( primal->cell_adj, lists[2], lists[3] ) ) )
+    status = KNIFE_INCONSISTENT;
+
+  primal_snapshot_free_lists( lists );
+
+  if ( KNIFE_SUCCESS != status )
+    {
+      printf("%s: %d: %d unable to read snapshot %s\n",
+	     __FILE__,__LINE__,status,filename);
+      primal_free( primal );
+      return NULL;
+    }
+
+  return primal;
+}
+
+/* shared segment: magic (written last, once the rest is in place), int
+ * version, nnode, nface, the pid of the creator, the unsigned long long
+ * key of the geometry, then xyz and f2n as in PrimalStruct.  A creator
+ * that fails writes the failed magic so the others stop waiting */
+#define PRIMAL_SHM_MAGIC "KNIFESHM"
+#define PRIMAL_SHM_FAILED "KNIFEBAD"
+#define PRIMAL_SHM_VERSION (2)
+#define PRIMAL_SHM_HEADER (32)
+
+Primal primal_attach( char *name, unsigned long long key, double wait, 
+		      KnifeBool *creator )
+{
+#ifdef PRIMAL_SHM
+  int fd;
+  struct stat file_stat;
+  void *contents;
+  size_t size;
+  int header[4];
+  unsigned long long shared_key;
+  int attempt, nattempt;
+  KnifeBool ready, failed, alive;
+  struct timespec pause;
+  Primal primal;
+
+  *creator = FALSE;
+
+  /* the creator leaves its pid in the header right away so a waiting
+   * process can tell a slow creator from a dead one */
+  fd = shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0600 );
+  if ( fd >= 0 )
+    {
+      if ( 0 == ftruncate( fd, (off_t)PRIMAL_SHM_HEADER ) )
+	{
+	  contents = mmap( NULL, PRIMAL_SHM_HEADER, PROT_READ | PROT_WRITE, 
+			   MAP_SHARED, fd, 0 );
+	  if ( MAP_FAILED != contents )
+	    {
+	      header[3] = (int)getpid( );
+	      memcpy( (char *)contents+20, &(header[3]), sizeof(int) );
+	      munmap( contents, PRIMAL_SHM_HEADER );
+	    }
+	}
+      close( fd );
+      *creator = TRUE;
+      return NULL;
+    }
+  if ( EEXIST != errno ) 
+    {
+      printf("%s: %d: shm_open %s failed, not shared\n",
+	     __FILE__,__LINE__,name);
+      return NULL;
+    }
+
+  fd = shm_open( name, O_RDONLY, 0 );
+  if ( fd < 0 ) return NULL;
+
+  /* the header is polled every 10 ms for wait seconds, the whole
+   * segment is mapped once it is published */
+  contents = NULL;
+  size = PRIMAL_SHM_HEADER;
+  ready = FALSE;
+  failed = FALSE;
+  pause.tv_sec = 0;
+  pause.tv_nsec = 10000000;
+  nattempt = (int)( 100.0 * wait ) + 1;
+  for ( attempt = 0 ; !ready && attempt < nattempt ; attempt++ )
+    {
+      if ( NULL == contents &&
+	   0 == fstat( fd, &file_stat ) && 
+	   file_stat.st_size >= PRIMAL_SHM_HEADER )
+	{
+	  contents = mmap( NULL, size, PROT_READ, MAP_SHARED, fd, 0 );
+	  if ( MAP_FAILED == contents ) 
+	    {
+	      contents = NULL;
+	      break;
+	    }
+	}
+      if ( NULL != contents )
+	failed = (KnifeBool)( 0 == memcmp( contents, PRIMAL_SHM_FAILED, 8 ) );
+      if ( failed ) break;
+      if ( NULL != contents )
+	ready = (KnifeBool)( 0 == memcmp( contents, PRIMAL_SHM_MAGIC, 8 ) );
+      if ( !ready ) nanosleep( &pause, NULL );
+    }
+
+  if ( ready )
+    {
+      munmap( contents, size );
+      contents = NULL;
+      if ( 0 == fstat( fd, &file_stat ) && 
+	   file_stat.st_size >= PRIMAL_SHM_HEADER )
+	{
+	  size = (size_t)file_stat.st_size;
+	  contents = mmap( NULL, size, PROT_READ, MAP_SHARED, fd, 0 );
+	  if ( MAP_FAILED == contents ) contents = NULL;
+	}
+      ready = (KnifeBool)( NULL != contents );
+    }
+  close( fd );
+
+  /* primal_abandon unlinks a failed segment, one left by a creator
+   * that died is unlinked here so the next run starts over, one with
+   * a creator still at work is left alone */
+  if ( !ready )
+    {
+      alive = FALSE;
+      if ( !failed && NULL != contents )
+	{
+	  memcpy( &(header[3]), (char *)contents+20, sizeof(int) );
+	  alive = (KnifeBool)( header[3] > 0 &&
+			       ( 0 == kill( (pid_t)header[3], 0 ) ||
+				 ESRCH != errno ) );
+	}
+      printf("%s: %d: shared primal %s %s, not shared\n",
+	     __FILE__,__LINE__,name,
+	     ( failed ? "abandoned" : 
+	       ( alive ? "still being built" : "never published" ) ) );
+      if ( NULL != contents ) munmap( contents, size );
+      if ( !failed && !alive ) shm_unlink( name );
+      return NULL;
+    }
+
+  memcpy( header, (char *)contents+8, 4*sizeof(int) );
+  memcpy( &shared_key, (char *)contents+24, sizeof(unsigned long long) );
+  if ( PRIMAL_SHM_VERSION != header[0] || header[1] < 0 || header[2] < 0 ||
+       PRIMAL_SHM_HEADER + 
+       3*(size_t)header[1]*sizeof(double) + 
+       4*(size_t)header[2]*sizeof(int) > size ||
+       key != shared_key )
+    {
+      printf("%s: %d: shared primal %s stale or inconsistent, not shared\n",
+	     __FILE__,__LINE__,name);
+      munmap( contents, size );
+      shm_unlink( name );
+      return NULL;
+    }
+
+  primal = (Primal) malloc( sizeof(PrimalStruct) );
+  if ( NULL == primal )
+    {
+      printf("%s: %d: malloc failed in primal_attach\n",__FILE__,__LINE__);
+      munmap( contents, size );
+      return NULL;
+    }
+
+  primal->nnode0 = header[1];
+  primal->nnode = header[1];
+  primal->xyz = (double *)((char *)contents+PRIMAL_SHM_HEADER);
+  primal->nface = header[2];
+  primal->f2n = (int *)((char *)contents+PRIMAL_SHM_HEADER+
+			3*(size_t)header[1]*sizeof(double));
+  primal->ncell = 0;
+  primal->c2n = NULL;
+  primal->cell_adj = NULL;
+  primal->face_adj = NULL;
+  primal->nedge = EMPTY;
+  primal->c2e = NULL;
+  primal->e2n = NULL;
+  primal->ntri = EMPTY;
+  primal->c2t = NULL;
+  primal->t2n = NULL;
+  primal->surface_nnode = EMPTY;
+  primal->surface_node = NULL;
+  primal->surface_volume_node = NULL;
+  primal->shared = contents;
+  primal->shared_bytes = size;
+
+  return primal;
+#else
+  *creator = FALSE;
+  return NULL;
+#endif
+}
+
+KNIFE_STATUS primal_publish( Primal primal, char *name, 
+			     unsigned long long key )
+{
+#ifdef PRIMAL_SHM
+  int fd;
+  size_t size;
+  char *contents;
+  int header[4];
+
+  size = PRIMAL_SHM_HEADER + 
+    3*(size_t)primal->nnode*sizeof(double) + 
+    4*(size_t)primal->nface*sizeof(int);
+
+  fd = shm_open( name, O_RDWR, 0600 );
+  if ( fd < 0 ) 
+    {
+      printf("%s: %d: shm_open %s failed\n",__FILE__,__LINE__,name);
+      return KNIFE_FILE_ERROR;
+    }
+  if ( 0 != ftruncate( fd, (off_t)size ) )
+    {
+      printf("%s: %d: ftruncate %s failed\n",__FILE__,__LINE__,name);
+      close( fd );
+      return KNIFE_MEMORY;
+    }
+  contents = (char *)mmap( NULL, size, PROT_READ | PROT_WRITE, 
+			   MAP_SHARED, fd, 0 );
+  close( fd );
+  if ( MAP_FAILED == (void *)contents )
+    {
+      printf("%s: %d: mmap %s failed\n",__FILE__,__LINE__,name);
+      return KNIFE_MEMORY;
+    }
+
+  header[0] = PRIMAL_SHM_VERSION;
+  header[1] = primal->nnode;
+  header[2] = primal->nface;
+  header[3] = (int)getpid( );
+  memcpy( contents+8, header, 4*sizeof(int) );
+  memcpy( contents+24, &key, sizeof(unsigned long long) );
+  memcpy( contents+PRIMAL_SHM_HEADER, primal->xyz, 
+	  3*(size_t)primal->nnode*sizeof(double) );
+  memcpy( contents+PRIMAL_SHM_HEADER+3*(size_t)primal->nnode*sizeof(double), 
+	  primal->f2n, 4*(size_t)primal->nface*sizeof(int) );
+#ifdef __GNUC__
+  __sync_synchronize( );
+#endif
+  memcpy( contents, PRIMAL_SHM_MAGIC, 8 );
+
+  munmap( contents, size );
+
+  return KNIFE_SUCCESS;
+#else
+  return KNIFE_IMPLEMENT;
+#endif
+}
+
+/* the name is free for the next run, mappings stay valid until freed */
+KNIFE_STATUS primal_unpublish( char *name )
+{
+#ifdef PRIMAL_SHM
+  if ( 0 != shm_unlink( name ) ) return KNIFE_NOT_FOUND;
+#else
+#endif
+  return KNIFE_SUCCESS;
+}
+
+/* the creator could not build the primal, the waiting processes read
+ * the failed magic and build their own */
+KNIFE_STATUS primal_abandon( char *name )
+{
+#ifdef PRIMAL_SHM
+  int fd;
+  char *contents;
+
+  fd = shm_open( name, O_RDWR, 0600 );
+  if ( fd >= 0 )
+    {
+      if ( 0 == ftruncate( fd, (off_t)PRIMAL_SHM_HEADER ) )
+	{
+	  contents = (char *)mmap( NULL, PRIMAL_SHM_HEADER, 
+				   PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	  if ( MAP_FAILED != (void *)contents )
+	    {
+	      memcpy( contents, PRIMAL_SHM_FAILED, 8 );
+	      munmap( contents, PRIMAL_SHM_HEADER );
+	    }
+	}
+      close( fd );
+    }
+#else
+#endif
+  return primal_unpublish( name );
+}
+
 KNIFE_STATUS primal_export_single_zone_tec( Primal primal, char *filename )
 {
   FILE *f;
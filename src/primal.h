@@ -62,6 +62,10 @@ struct PrimalStruct {
   int surface_nnode;
   int *surface_node;
   int *surface_volume_node;
+
+  /* xyz and f2n point into this read only mapping of primal_attach */
+  void *shared;
+  size_t shared_bytes;
 };
 
 Primal primal_create( int nnode, int nface, int ncell );
@@ -75,11 +79,30 @@ Primal primal_from_tri( char *filename );
 Primal primal_from_ascii_tri( char *filename );
 Primal primal_from_unformatted_tri( char *filename );
 
+KnifeBool primal_is_snapshot( char *filename );
+Primal primal_from_snapshot( char *filename );
+
+/* surface primals shared by the processes of a node through a named
+ * POSIX shared memory segment.  primal_attach returns NULL with
+ * creator TRUE to the one process that should build the primal and
+ * primal_publish it, NULL with creator FALSE when sharing is not
+ * available, or a read only view with only xyz and f2n (no adjacency).
+ * A segment that is not published within wait seconds, or holds
+ * another key (geometry), is stale: it is unlinked and NULL returned.
+ * A creator that fails before primal_publish calls primal_abandon */
+Primal primal_attach( char *name, unsigned long long key, double wait,
+		      KnifeBool *creator );
+KNIFE_STATUS primal_publish( Primal, char *name, unsigned long long key );
+KNIFE_STATUS primal_unpublish( char *name );
+KNIFE_STATUS primal_abandon( char *name );
+
 void primal_free( Primal );
 
 KNIFE_STATUS primal_copy_volume( Primal, 
 				 double *x, double *y, double *z,
 				 int *c2n );
+KNIFE_STATUS primal_copy_xyz( Primal, 
+			      double *x, double *y, double *z );
 
 KNIFE_STATUS primal_copy_boundary( Primal, int face_id, 
 				   int nboundnode, int *inode,
@@ -165,6 +188,8 @@ KNIFE_STATUS primal_find_tri_side( Primal, int tri, int node0, int node1,
 #define primal_cell_side_node1(side) ((0==side)?3:(1==side)?2:(2==side)?3:1)
 #define primal_cell_side_node2(side) ((0==side)?2:(1==side)?3:(2==side)?1:2)
 
+KNIFE_STATUS primal_bounding_box( Primal, double *lower, double *upper );
+
 KNIFE_STATUS primal_scale_about( Primal, 
 				 double x, double y, double z, double scale );
 KNIFE_STATUS primal_translate( Primal, 
@@ -186,6 +211,7 @@ Primal primal_subset( Primal, Set bcs );
 
 KNIFE_STATUS primal_export_tri( Primal, char *filename );
 KNIFE_STATUS primal_export_fast( Primal, char *filename );
+KNIFE_STATUS primal_export_snapshot( Primal, char *filename );
 KNIFE_STATUS primal_export_tec( Primal, char *filename );
 KNIFE_STATUS primal_export_single_zone_tec( Primal, char *filename );
 KNIFE_STATUS primal_export_vtk( Primal, char *filename );
@@ -0,0 +1,182 @@
+
+/* phase timing, counters and memory of the cut pipeline */
+
+/* Copyright 2007 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space
+ * Administration. No copyright is claimed in the United States under
+ * Title 17, U.S. Code.  All Other Rights Reserved.
+ *
+ * The knife platform is licensed under the Apache License, Version
+ * 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if defined(HAVE_SYS_TIME_H) && defined(HAVE_GETTIMEOFDAY)
+#include <sys/time.h>
+#endif
+
+#if defined(HAVE_SYS_RESOURCE_H) && defined(HAVE_GETRUSAGE)
+#include <sys/resource.h>
+#endif
+
+#include "profile.h"
+
+#define PROFILE_MAX_PHASE (256)
+
+static ProfilePhaseStruct phase[PROFILE_MAX_PHASE];
+static int nphase = 0;
+static KnifeBool open_phase = FALSE;
+static double open_wall, open_cpu;
+static long count[PROFILE_NCOUNTER];
+static long open_count[PROFILE_NCOUNTER];
+
+static char *counter_name[PROFILE_NCOUNTER] = {
+  "candidates", "intersections", "cuts", "subnodes", "subtris", "masks",
+  "recoveries", "provable_recoveries" };
+
+static double profile_wall( void )
+{
+#if defined(HAVE_SYS_TIME_H) && defined(HAVE_GETTIMEOFDAY)
+  struct timeval now;
+  gettimeofday( &now, NULL );
+  return (double)now.tv_sec + 1.0e-6*(double)now.tv_usec;
+#else
+  return (double)time( (time_t *)NULL );
+#endif
+}
+
+static double profile_cpu( void )
+{
+  return ((double)clock( ))/((double)CLOCKS_PER_SEC);
+}
+
+/* kilobytes on linux, EMPTY when the platform does not say */
+static long profile_peak_rss( void )
+{
+#if defined(HAVE_SYS_RESOURCE_H) && defined(HAVE_GETRUSAGE)
+  struct rusage usage;
+  if ( 0 != getrusage( RUSAGE_SELF, &usage ) ) return EMPTY;
+#ifdef __APPLE__
+  return (long)(usage.ru_maxrss/1024);
+#else
+  return (long)usage.ru_maxrss;
+#endif
+#else
+  return EMPTY;
+#endif
+}
+
+KNIFE_STATUS profile_reset( void )
+{
+  int counter;
+
+  nphase = 0;
+  open_phase = FALSE;
+  for ( counter = 0 ; counter < PROFILE_NCOUNTER ; counter++ )
+    count[counter] = 0;
+
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS profile_phase( char *name )
+{
+  int counter;
+
+  TSS( profile_end( ), "close phase" );
+
+  if ( nphase >= PROFILE_MAX_PHASE ) return KNIFE_ARRAY_BOUND;
+
+  strncpy( phase[nphase].name, name, PROFILE_NAME_LENGTH-1 );
+  phase[nphase].name[PROFILE_NAME_LENGTH-1] = '\0';
+  for ( counter = 0 ; counter < PROFILE_NCOUNTER ; counter++ )
+    open_count[counter] = count[counter];
+  open_wall = profile_wall( );
+  open_cpu = profile_cpu( );
+  open_phase = TRUE;
+
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS profile_end( void )
+{
+  int counter;
+
+  if ( !open_phase ) return KNIFE_SUCCESS;
+
+  phase[nphase].wall = profile_wall( ) - open_wall;
+  phase[nphase].cpu = profile_cpu( ) - open_cpu;
+  phase[nphase].peak_rss = profile_peak_rss( );
+  for ( counter = 0 ; counter < PROFILE_NCOUNTER ; counter++ )
+    phase[nphase].count[counter] = count[counter] - open_count[counter];
+  nphase++;
+  open_phase = FALSE;
+
+  return KNIFE_SUCCESS;
+}
+
+void profile_count( int counter, long increment )
+{
+  if ( counter < 0 || counter >= PROFILE_NCOUNTER ) return;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  count[counter] += increment;
+}
+
+int profile_nphase( void )
+{
+  return nphase;
+}
+
+ProfilePhase profile_phase_record( int phase_index )
+{
+  if ( phase_index < 0 || phase_index >= nphase ) return NULL;
+  return &(phase[phase_index]);
+}
+
+char *profile_counter_name( int counter )
+{
+  if ( counter < 0 || counter >= PROFILE_NCOUNTER ) return NULL;
+  return counter_name[counter];
+}
+
+KNIFE_STATUS profile_json( char *filename, int partition )
+{
+  FILE *f;
+  int phase_index, counter;
+
+  f = fopen( filename, "w" );
+  TNS( f, "could not open profile file" );
+
+  fprintf( f, "{\n  \"partition\": %d,\n  \"phases\": [", partition );
+  for ( phase_index = 0 ; phase_index < nphase ; phase_index++ )
+    {
+      fprintf( f, "%s\n    {\"name\": \"%s\", \"wall\": %.6f, \"cpu\": %.6f,"
+	       " \"peak_rss_kb\": %ld", ( 0 == phase_index ? "" : "," ),
+	       phase[phase_index].name, phase[phase_index].wall,
+	       phase[phase_index].cpu, phase[phase_index].peak_rss );
+      for ( counter = 0 ; counter < PROFILE_NCOUNTER ; counter++ )
+	fprintf( f, ", \"%s\": %ld", counter_name[counter],
+		 phase[phase_index].count[counter] );
+      fprintf( f, "}" );
+    }
+  fprintf( f, "\n  ]\n}\n" );
+
+  if ( 0 != fclose( f ) ) return KNIFE_FILE_ERROR;
+
+  return KNIFE_SUCCESS;
+}
@@ -0,0 +1,69 @@
+/* phase timing, counters and memory of the cut pipeline */
+
+/* Copyright 2007 United States Government as represented by the
+ * Administrator of the National Aeronautics and Space
+ * Administration. No copyright is claimed in the United States under
+ * Title 17, U.S. Code.  All Other Rights Reserved.
+ *
+ * The knife platform is licensed under the Apache License, Version
+ * 2.0 (the "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "knife_definitions.h"
+
+BEGIN_C_DECLORATION
+
+/* counters, bumped where the work is done and charged to the open phase */
+#define PROFILE_CANDIDATE    (0) /* dual-surface triangle pairs tested */
+#define PROFILE_INTERSECTION (1) /* segment-triangle intersections made */
+#define PROFILE_CUT          (2) /* cuts made */
+#define PROFILE_SUBNODE      (3) /* subnodes of triangulated triangles */
+#define PROFILE_SUBTRI       (4) /* subtri of triangulated triangles */
+#define PROFILE_MASK         (5) /* masks made */
+#define PROFILE_RECOVERY     (6) /* cuts recovered by swaps */
+#define PROFILE_PROVABLE     (7) /* cuts recovered by provable recovery */
+#define PROFILE_NCOUNTER     (8)
+
+#define PROFILE_NAME_LENGTH  (64)
+
+typedef struct ProfilePhaseStruct ProfilePhaseStruct;
+typedef ProfilePhaseStruct * ProfilePhase;
+struct ProfilePhaseStruct {
+  char name[PROFILE_NAME_LENGTH];
+  double wall;      /* seconds */
+  double cpu;       /* seconds */
+  long peak_rss;    /* kilobytes, high water mark at the end of the phase */
+  long count[PROFILE_NCOUNTER];
+};
+
+KNIFE_STATUS profile_reset( void );
+
+/* close the open phase (if any) and open one called name */
+KNIFE_STATUS profile_phase( char *name );
+KNIFE_STATUS profile_end( void );
+
+void profile_count( int counter, long increment );
+
+int profile_nphase( void );
+ProfilePhase profile_phase_record( int phase_index );
+char *profile_counter_name( int counter );
+
+KNIFE_STATUS profile_json( char *filename, int partition );
+
+END_C_DECLORATION
+
+#endif /* PROFILE_H */
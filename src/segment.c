@@ -78,14 +78,61 @@ KNIFE_STATUS segment_initialize( Segment segment, Node node0, Node node1 )
   return(KNIFE_SUCCESS);
 }
 
-void segment_free( Segment segment )
+void segment_release( Segment segment )
 {
   if ( NULL == segment ) return;
   array_free( segment->intersection );
   array_free( segment->triangle );
+}
+
+void segment_free( Segment segment )
+{
+  if ( NULL == segment ) return;
+  segment_release( segment );
   free( segment );
 }
 
+/* forget (and free) the intersection with triangle, if there is one */
+KNIFE_STATUS segment_drop_intersection( Segment segment, Triangle triangle )
+{
+  int intersection_index;
+  Intersection intersection;
+
+  for ( intersection_index=0;
+	intersection_index < segment_nintersection(segment);
+	intersection_index++ )
+    {
+      intersection = segment_intersection(segment,intersection_index);
+      if ( triangle == intersection_triangle(intersection) )
+	{
+	  if ( KNIFE_SUCCESS != array_remove( segment->intersection, 
+					      (ArrayItem)intersection ) )
+	    return KNIFE_INCONSISTENT;
+	  intersection_free( intersection );
+	  return KNIFE_SUCCESS;
+	}
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+/* forget (and free) every intersection, after the segment has moved */
+KNIFE_STATUS segment_drop_intersections( Segment segment )
+{
+  int intersection_index;
+
+  for ( intersection_index=0;
+	intersection_index < segment_nintersection(segment);
+	intersection_index++ )
+    intersection_free( segment_intersection(segment,intersection_index) );
+  array_free( segment->intersection );
+
+  segment->intersection = array_create( 1, 10 );
+  NOT_NULL( segment->intersection, "segment intersection array NULL" );
+
+  return KNIFE_SUCCESS;
+}
+
 Node segment_common_node( Segment segment0, Segment segment1 )
 {
   Node node;
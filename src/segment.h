@@ -43,8 +43,12 @@ struct SegmentStruct {
 
 Segment segment_create( Node node0, Node node1 );
 KNIFE_STATUS segment_initialize( Segment segment, Node node0, Node node1 );
+void segment_release( Segment );
 void segment_free( Segment );
 
+KNIFE_STATUS segment_drop_intersection( Segment, Triangle );
+KNIFE_STATUS segment_drop_intersections( Segment );
+
 Node segment_common_node( Segment segment0, Segment segment1 );
 
 KNIFE_STATUS segment_extent( Segment segment, 
@@ -1,5 +1,5 @@
 
-/* growable set (list) of ints */
+/* growable set (list) of ints with a hashed index */
 
 /* Copyright 2007 United States Government as represented by the
  * Administrator of the National Aeronautics and Space
@@ -38,6 +38,9 @@ Set set_create( int guess, int chunk )
   set->chunk      = MAX(chunk,1);
        
   set->data = NULL;
+
+  set->nhash = 0;
+  set->hash = NULL;
   
   return set;
 }
@@ -46,12 +49,42 @@ void set_free( Set set )
 {
   if ( NULL == set ) return;
   if ( NULL != set->data ) free( set->data );
+  if ( NULL != set->hash ) free( set->hash );
   free( set );
 }
 
+#define set_hash_slot(item,nhash) \
+  ((int)(((unsigned int)(item)*2654435761u)&((unsigned int)(nhash)-1)))
+
+static KNIFE_STATUS set_rehash( Set set, int nhash )
+{
+  int indx, slot;
+
+  if ( NULL != set->hash ) free( set->hash );
+  set->nhash = nhash;
+  set->hash = (int *) malloc( set->nhash * sizeof(int) );
+  if (NULL == set->hash) {
+    printf("%s: %d: malloc failed in set_rehash\n",
+	   __FILE__,__LINE__);
+    set->nhash = 0;
+    return KNIFE_MEMORY; 
+  }
+  for ( slot = 0 ; slot < set->nhash ; slot++ ) set->hash[slot] = EMPTY;
+
+  for ( indx = 0 ; indx < set_size(set) ; indx++ )
+    {
+      slot = set_hash_slot( set->data[indx], set->nhash );
+      while ( EMPTY != set->hash[slot] ) slot = (slot+1) & (set->nhash-1);
+      set->hash[slot] = indx;
+    }
+
+  return KNIFE_SUCCESS;
+}
+
 KNIFE_STATUS set_insert( Set set, int item )
 {
   int *new_data;
+  int nhash, slot;
 
   if ( set_contains( set, item ) ) return KNIFE_SUCCESS;
 
@@ -82,6 +115,19 @@ KNIFE_STATUS set_insert( Set set, int item )
 
   set->data[set->actual] = item;
   set->actual++;
+
+  /* keep the hash at most half full */
+  if ( 2*set->actual > set->nhash )
+    {
+      nhash = 16;
+      while ( nhash < 4*set->actual ) nhash *= 2;
+      return set_rehash( set, nhash );
+    }
+
+  slot = set_hash_slot( item, set->nhash );
+  while ( EMPTY != set->hash[slot] ) slot = (slot+1) & (set->nhash-1);
+  set->hash[slot] = set->actual-1;
+
   return KNIFE_SUCCESS;
 }
 
@@ -100,6 +146,9 @@ KNIFE_STATUS set_remove( Set set, int item )
 	  set->data[sweep-1] = set->data[sweep];
 	set->actual--;
       }
+
+  /* indexes after the removed item shifted */
+  if ( found && NULL != set->hash ) return set_rehash( set, set->nhash );
   
   return ( found ? KNIFE_SUCCESS : KNIFE_NOT_FOUND );
 }
@@ -111,10 +160,16 @@ KnifeBool set_contains( Set set, int target )
 
 int set_index_of( Set set, int target )
 {
-  int indx;
+  int slot;
 
-  for ( indx = 0 ; indx < set_size(set) ; indx++ )
-    if ( target == set_item(set, indx) ) return indx;
+  if ( NULL == set || NULL == set->hash ) return EMPTY;
+
+  slot = set_hash_slot( target, set->nhash );
+  while ( EMPTY != set->hash[slot] )
+    {
+      if ( target == set->data[set->hash[slot]] ) return set->hash[slot];
+      slot = (slot+1) & (set->nhash-1);
+    }
  
   return EMPTY;
 }
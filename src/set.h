@@ -1,5 +1,5 @@
 
-/* growable set (list) of ints */
+/* growable set (list) of ints with a hashed index */
 
 /* Copyright 2007 United States Government as represented by the
  * Administrator of the National Aeronautics and Space
@@ -28,9 +28,13 @@ BEGIN_C_DECLORATION
 typedef struct SetStruct SetStruct;
 typedef SetStruct * Set;
 
+/* items stay in insertion order in data, nhash slots (power of two)
+ * of open addressed hash map an item to its index in data */
 struct SetStruct {
   int actual, allocated, chunk;
   int *data;
+  int nhash;
+  int *hash;
 };
 
 Set set_create( int guess, int chunk );
@@ -20,6 +20,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 #include "surface.h"
 
 #define TRY(fcn,msg)					      \
@@ -34,6 +35,122 @@
 
 Surface surface_from( Primal primal, Set bcs, 
 		      KnifeBool inward_pointing_normal  )
+{
+  return surface_from_box( primal, bcs, inward_pointing_normal, NULL, NULL );
+}
+
+static KnifeBool surface_face_in_box( Primal primal, int *face,
+				      double *lower, double *upper )
+{
+  double xyz[3];
+  int i, ixyz;
+  KnifeBool below[3], above[3];
+
+  for ( ixyz = 0 ; ixyz < 3 ; ixyz++ )
+    {
+      below[ixyz] = TRUE;
+      above[ixyz] = TRUE;
+    }
+
+  for (i=0;i<3;i++)
+    {
+      primal_xyz(primal, face[i], xyz);
+      for ( ixyz = 0 ; ixyz < 3 ; ixyz++ )
+	{
+	  if ( xyz[ixyz] >= lower[ixyz] ) below[ixyz] = FALSE;
+	  if ( xyz[ixyz] <= upper[ixyz] ) above[ixyz] = FALSE;
+	}
+    }
+
+  for ( ixyz = 0 ; ixyz < 3 ; ixyz++ )
+    if ( below[ixyz] || above[ixyz] ) return FALSE;
+
+  return TRUE;
+}
+
+/* a primal attached to shared memory has no face adjacency, so the
+ * sides of the selected faces are matched through a local hash of
+ * side+3*local_face keyed on the side nodes.  The last face added
+ * wins, as the first found by primal_find_face_side */
+#define surface_side_slot(node0,node1,nhash)				\
+  ((int)(( (unsigned int)(node0) * 2654435761u ^			\
+	   (unsigned int)(node1) * 2246822519u ) & ((unsigned int)(nhash)-1)))
+
+static int *surface_side_hash( Primal primal, int local_nface, int *face_l2g,
+			       int *nhash )
+{
+  int *hash;
+  int local_iface, side, slot, entry, entry_side;
+  int face[4], other[4];
+
+  *nhash = 16;
+  while ( *nhash < 6*local_nface ) (*nhash) *= 2;
+  hash = (int *)malloc( (*nhash)*sizeof(int) );
+  if ( NULL == hash ) return NULL;
+  for ( slot = 0 ; slot < *nhash ; slot++ ) hash[slot] = EMPTY;
+
+  for ( local_iface = 0 ; local_iface < local_nface ; local_iface++ )
+    {
+      primal_face(primal, face_l2g[local_iface], face);
+      for ( side = 0 ; side<3; side++ )
+	{
+	  slot = surface_side_slot( face[primal_face_side_node0(side)],
+				    face[primal_face_side_node1(side)], 
+				    *nhash );
+	  while ( EMPTY != hash[slot] )
+	    {
+	      entry = hash[slot];
+	      entry_side = (int)( (unsigned int)entry % 3u );
+	      primal_face(primal, face_l2g[entry/3], other);
+	      if ( other[primal_face_side_node0(entry_side)] == 
+		   face[primal_face_side_node0(side)] &&
+		   other[primal_face_side_node1(entry_side)] == 
+		   face[primal_face_side_node1(side)] ) break;
+	      slot = (slot+1) & ((*nhash)-1);
+	    }
+	  hash[slot] = side+3*local_iface;
+	}
+    }
+
+  return hash;
+}
+
+static KNIFE_STATUS surface_find_face_side( Primal primal, 
+					    int *hash, int nhash, 
+					    int *face_l2g,
+					    int node0, int node1,
+					    int *other_face_index, 
+					    int *other_side )
+{
+  int slot, entry, entry_side;
+  int face[4];
+
+  if ( NULL == hash ) 
+    return primal_find_face_side( primal, node0, node1, 
+				  other_face_index, other_side );
+
+  slot = surface_side_slot( node0, node1, nhash );
+  while ( EMPTY != hash[slot] )
+    {
+      entry = hash[slot];
+      entry_side = (int)( (unsigned int)entry % 3u );
+      primal_face(primal, face_l2g[entry/3], face);
+      if ( node0 == face[primal_face_side_node0(entry_side)] &&
+	   node1 == face[primal_face_side_node1(entry_side)] )
+	{
+	  *other_face_index = face_l2g[entry/3];
+	  *other_side = entry_side;
+	  return KNIFE_SUCCESS;
+	}
+      slot = (slot+1) & (nhash-1);
+    }
+
+  return KNIFE_NOT_FOUND;
+}
+
+Surface surface_from_box( Primal primal, Set bcs, 
+			  KnifeBool inward_pointing_normal,
+			  double *lower, double *upper )
 {
   Surface surface;
   int face[4];
@@ -48,6 +165,7 @@ Surface surface_from( Primal primal, Set bcs,
   double xyz[3];
   int *s2n;
   int segment_index;
+  int *side_hash, nside_hash;
 
   surface = (Surface)malloc( sizeof(SurfaceStruct) );
   if (NULL == surface) {
@@ -66,7 +184,9 @@ Surface surface_from( Primal primal, Set bcs,
 	global_iface++ )
     {
       primal_face(primal, global_iface, face);
-      if ( (NULL==bcs) || set_contains(bcs,face[3]) ) 
+      if ( ( (NULL==bcs) || set_contains(bcs,face[3]) ) &&
+	   ( (NULL==lower) || 
+	     surface_face_in_box( primal, face, lower, upper ) ) )
 	{
 	  face_g2l[global_iface] = local_nface;
 	  local_nface++;
@@ -91,6 +211,19 @@ Surface surface_from( Primal primal, Set bcs,
       f2s[2+3*local_iface] = EMPTY;
     }
 
+  side_hash = NULL;
+  nside_hash = 0;
+  if ( NULL == primal->face_adj )
+    {
+      side_hash = surface_side_hash( primal, local_nface, face_l2g, 
+				     &nside_hash );
+      if ( NULL == side_hash ) {
+	printf("%s: %d: malloc failed in surface_from\n",
+	       __FILE__,__LINE__);
+	return NULL; 
+      }
+    }
+
   surface->nsegment = 0;
   for ( local_iface = 0 ; local_iface < local_nface ; local_iface++ )
     {
@@ -103,10 +236,12 @@ Surface surface_from( Primal primal, Set bcs,
 	    node0 = face[primal_face_side_node0(side)];
 	    node1 = face[primal_face_side_node1(side)];
 	    /* the other face may not be there if not watertight */
-	    if (KNIFE_SUCCESS == primal_find_face_side(primal, 
-						       node1, node0, 
-						       &other_global, 
-						       &other_side)) 
+	    if (KNIFE_SUCCESS == surface_find_face_side(primal, 
+							side_hash, nside_hash,
+							face_l2g,
+							node1, node0, 
+							&other_global, 
+							&other_side)) 
 	      {
 		other_local = face_g2l[other_global];
 		if (EMPTY != other_local)
@@ -214,6 +349,7 @@ Surface surface_from( Primal primal, Set bcs,
   free(face_g2l);
   free(f2s);
   free(node_g2l);
+  if ( NULL != side_hash ) free(side_hash);
 
   return surface;
 }
@@ -228,6 +364,174 @@ void surface_free( Surface surface )
   free( surface );
 }
 
+/* take the node coordinates of primal (the surface primal was built
+ * from), moved[node] is set for the nodes that changed */
+KNIFE_STATUS surface_update_xyz( Surface surface, Primal primal, 
+				 KnifeBool *moved )
+{
+  int node, i;
+  double xyz[3];
+
+  for ( node = 0 ; node < surface_nnode(surface) ; node++ )
+    {
+      TRY( primal_xyz( primal, surface->primal_node_index[node], xyz ),
+	   "primal_xyz" );
+      moved[node] = FALSE;
+      for ( i = 0 ; i < 3 ; i++ )
+	if ( xyz[i] != surface_node(surface,node)->xyz[i] ) moved[node] = TRUE;
+      if ( moved[node] )
+	node_initialize( surface_node(surface,node), xyz );
+    }
+
+  return KNIFE_SUCCESS;
+}
+
+/* yz orientation of p about the directed edge a b (raw, for weights)
+ * and its sign, which is never zero: p is pushed off the edge by
+ * (e, e^2) with e vanishing.  The edge is always evaluated in one
+ * direction so the two triangles sharing it see opposite signs */
+static int surface_edge_side( double *a, double *b, double *p, double *raw )
+{
+  double *lo, *hi;
+  double side;
+  KnifeBool flip;
+
+  flip = ( a[1] > b[1] || ( a[1] == b[1] && a[2] > b[2] ) );
+  lo = ( flip ? b : a );
+  hi = ( flip ? a : b );
+
+  side = (hi[1]-lo[1])*(p[2]-lo[2]) - (hi[2]-lo[2])*(p[1]-lo[1]);
+  *raw = ( flip ? -side : side );
+  if ( knife_double_zero(side) ) 
+    side = ( knife_double_zero(hi[2]-lo[2]) ? (hi[1]-lo[1]) : (lo[2]-hi[2]) );
+
+  return ( ( side > 0.0 ) != flip ? 1 : -1 );
+}
+
+/* winding number of the surface about each point, counted by the
+ * triangles crossed by a ray in +x (the sign of the crossing is the
+ * sign of the triangle normal x component).  A closed surface winds
+ * once about the points it encloses.  The triangles are binned by
+ * their yz extent so each ray only visits the triangles of one bin */
+KNIFE_STATUS surface_winding( Surface surface, int npoint, double *xyz, 
+			      int *winding )
+{
+  double lower[3], upper[3], width[2];
+  int nbin, bin, iy, iz, iy0, iy1, iz0, iz1;
+  int *start, *item;
+  int node, triangle_index, point, i;
+  Triangle triangle;
+  double *a, *b, *c;
+
+  for ( point = 0 ; point < npoint ; point++ ) winding[point] = 0;
+  if ( 0 == surface_ntriangle(surface) ) return KNIFE_SUCCESS;
+
+  for ( i = 0 ; i < 3 ; i++ )
+    {
+      lower[i] = surface_node(surface,0)->xyz[i];
+      upper[i] = surface_node(surface,0)->xyz[i];
+    }
+  for ( node = 0 ; node < surface_nnode(surface) ; node++ )
+    for ( i = 0 ; i < 3 ; i++ )
+      {
+	lower[i] = MIN( lower[i], surface_node(surface,node)->xyz[i] );
+	upper[i] = MAX( upper[i], surface_node(surface,node)->xyz[i] );
+      }
+
+  nbin = (int)sqrt( (double)surface_ntriangle(surface) );
+  nbin = MAX( 1, MIN( nbin, 1024 ) );
+  width[0] = ( upper[1] - lower[1] ) / (double)nbin;
+  width[1] = ( upper[2] - lower[2] ) / (double)nbin;
+
+#define surface_bin_of(coordinate,dir)				\
+  ( ( width[(dir)] > 0.0 ) ?						\
+    MAX( 0, MIN( nbin-1, (int)( ((coordinate)-lower[(dir)+1]) /	\
+				width[(dir)] ) ) ) : 0 )
+
+  item = NULL;
+  start = (int *)malloc( (nbin*nbin+1) * sizeof(int) );
+  if ( NULL == start ) return KNIFE_MEMORY;
+  for ( bin = 0 ; bin <= nbin*nbin ; bin++ ) start[bin] = 0;
+
+  /* count, then place, each triangle in the bins of its yz extent */
+  for ( i = 0 ; i < 2 ; i++ )
+    {
+      for (triangle_index=0;
+	   triangle_index<surface_ntriangle(surface);
+	   triangle_index++)
+	{
+	  triangle = surface_triangle(surface,triangle_index);
+	  a = triangle_xyz0(triangle);
+	  b = triangle_xyz1(triangle);
+	  c = triangle_xyz2(triangle);
+	  iy0 = surface_bin_of( MIN(a[1],MIN(b[1],c[1])), 0 );
+	  iy1 = surface_bin_of( MAX(a[1],MAX(b[1],c[1])), 0 );
+	  iz0 = surface_bin_of( MIN(a[2],MIN(b[2],c[2])), 1 );
+	  iz1 = surface_bin_of( MAX(a[2],MAX(b[2],c[2])), 1 );
+	  for ( iz = iz0 ; iz <= iz1 ; iz++ )
+	    for ( iy = iy0 ; iy <= iy1 ; iy++ )
+	      {
+		bin = iy + nbin * iz;
+		if ( 0 == i ) 
+		  { 
+		    start[bin+1]++; 
+		  }
+		else
+		  {
+		    item[start[bin]] = triangle_index;
+		    start[bin]++;
+		  }
+	      }
+	}
+      if ( 0 == i )
+	{
+	  for ( bin = 0 ; bin < nbin*nbin ; bin++ ) 
+	    start[bin+1] += start[bin];
+	  item = (int *)malloc( MAX(start[nbin*nbin],1) * sizeof(int) );
+	  if ( NULL == item ) { free( start ); return KNIFE_MEMORY; }
+	}
+    }
+  /* the placing pass left start[bin] at the start of bin+1 */
+  for ( bin = nbin*nbin ; bin > 0 ; bin-- ) start[bin] = start[bin-1];
+  start[0] = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic,256) private(bin,i,triangle,a,b,c)
+#endif
+  for ( point = 0 ; point < npoint ; point++ )
+    {
+      double *p, side0, side1, side2, x;
+      int sign0, sign1, sign2;
+      p = &(xyz[3*point]);
+      if ( p[0] > upper[0] || 
+	   p[1] < lower[1] || p[1] > upper[1] ||
+	   p[2] < lower[2] || p[2] > upper[2] ) continue;
+      bin = surface_bin_of(p[1],0) + nbin * surface_bin_of(p[2],1);
+      for ( i = start[bin] ; i < start[bin+1] ; i++ )
+	{
+	  triangle = surface_triangle(surface,item[i]);
+	  a = triangle_xyz0(triangle);
+	  b = triangle_xyz1(triangle);
+	  c = triangle_xyz2(triangle);
+	  sign0 = surface_edge_side( b, c, p, &side0 );
+	  sign1 = surface_edge_side( c, a, p, &side1 );
+	  sign2 = surface_edge_side( a, b, p, &side2 );
+	  if ( sign0 != sign1 || sign0 != sign2 ) continue;
+	  if ( knife_double_zero( side0+side1+side2 ) ) continue;
+	  /* x of the triangle plane where the ray passes */
+	  x = ( side0*a[0] + side1*b[0] + side2*c[0] ) / ( side0+side1+side2 );
+	  if ( x > p[0] ) winding[point] += sign0;
+	}
+    }
+
+#undef surface_bin_of
+
+  free( item );
+  free( start );
+
+  return KNIFE_SUCCESS;
+}
+
 KNIFE_STATUS surface_triangulate( Surface surface )
 {
   int triangle_index;
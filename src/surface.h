@@ -47,6 +47,10 @@ struct SurfaceStruct {
 };
 
 Surface surface_from( Primal, Set of_bcs, KnifeBool inward_pointing_normal );
+/* only the faces with an extent that overlaps lower to upper */
+Surface surface_from_box( Primal, Set of_bcs, 
+			  KnifeBool inward_pointing_normal,
+			  double *lower, double *upper );
 
 void surface_free( Surface );
 
@@ -66,6 +70,11 @@ void surface_free( Surface );
 #define surface_triangle_index(surface,this_triangle) \
   ( (int)( (this_triangle) - ((surface)->triangle) ) )
 
+KNIFE_STATUS surface_update_xyz( Surface, Primal, KnifeBool *moved );
+
+KNIFE_STATUS surface_winding( Surface, int npoint, double *xyz, 
+			      int *winding );
+
 KNIFE_STATUS surface_triangulate( Surface );
 
 KNIFE_STATUS surface_export_array( Surface, double *xyz, int *global, int *t2n);
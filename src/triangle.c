@@ -21,11 +21,23 @@
 #include <math.h>
 #include "triangle.h"
 #include "loop.h"
+#include "profile.h"
+
+static KNIFE_STATUS triangle_initialize_subtri( Triangle triangle );
+static void triangle_release_subtri( Triangle triangle );
+static KNIFE_STATUS triangle_single_cut( Triangle triangle );
+static KNIFE_STATUS triangle_generic_cuts( Triangle triangle );
+static KNIFE_STATUS triangle_insert_cut_subnodes( Triangle triangle );
+static KnifeBool triangle_swap_positive( Triangle triangle, 
+					Subnode node0, Subnode node1 );
 
 static int triangle_eps_frame = 0;
 static int triangle_tecplot_frame = 0;
 static int triangle_export_frame = 0;
 
+static KnifeBool triangle_single_cut_check = FALSE;
+static KnifeBool triangle_cdt_check = FALSE;
+
 #define POSITIVE_AREA( subtri )					\
   if (TRUE) {							\
     if (subtri_reference_area(subtri) <= 0.0 ) {		\
@@ -108,9 +120,8 @@ KNIFE_STATUS triangle_initialize(Triangle triangle,
 				 Segment segment2,
 				 int boundary_face_index )
 {
-  Subnode subnode0, subnode1, subnode2;
-
   triangle->boundary_face_index = boundary_face_index;
+  triangle->recovery = TRIANGLE_LOOP_RECOVERY;
 
   triangle->segment[0] = segment0;
   triangle->segment[1] = segment1;
@@ -123,6 +134,20 @@ KNIFE_STATUS triangle_initialize(Triangle triangle,
   triangle->node2 = segment_common_node( segment0, segment1 );
   NOT_NULL(triangle->node2,"common node2 NULL in triangle_initialize");
 
+  TRY( triangle_initialize_subtri( triangle ), "init subtri" );
+
+  triangle->cut = array_create( 1, 50 );
+  NOT_NULL(triangle->cut, "triangle->cut NULL in init");
+
+  return KNIFE_SUCCESS;
+}
+
+/* the corner subnodes and the single subtri of an untriangulated
+ * triangle */
+static KNIFE_STATUS triangle_initialize_subtri( Triangle triangle )
+{
+  Subnode subnode0, subnode1, subnode2;
+
   subnode0 = subnode_create( 1.0, 0.0, 0.0, triangle->node0, NULL );
   NOT_NULL(subnode0, "NULL sn0");
   subnode1 = subnode_create( 0.0, 1.0, 0.0, triangle->node1, NULL );
@@ -144,16 +169,12 @@ KNIFE_STATUS triangle_initialize(Triangle triangle,
 			    subtri_create( subnode0, subnode1, subnode2 ) ),
        "add st");
 
-  triangle->cut = array_create( 1, 50 );
-  NOT_NULL(triangle->cut, "triangle->cut NULL in init");
-
   return KNIFE_SUCCESS;
 }
 
-void triangle_free( Triangle triangle )
+static void triangle_release_subtri( Triangle triangle )
 {
   int i;
-  if ( NULL == triangle ) return;
 
   for ( i = 0; i < triangle_nsubnode(triangle); i++) 
     subnode_free( triangle_subnode( triangle, i ) );
@@ -162,13 +183,36 @@ void triangle_free( Triangle triangle )
   for ( i = 0; i < triangle_nsubtri(triangle); i++) 
     subtri_free( triangle_subtri( triangle, i ) );
   array_free( triangle->subtri );
+}
+
+void triangle_release( Triangle triangle )
+{
+  if ( NULL == triangle ) return;
+
+  triangle_release_subtri( triangle );
 
   /* FIXME find a consistant way to free cuts and intersections */
   array_free( triangle->cut );
+}
 
+void triangle_free( Triangle triangle )
+{
+  if ( NULL == triangle ) return;
+  triangle_release( triangle );
   free( triangle );
 }
 
+/* back to the single subtri of triangle_initialize, the cuts are kept
+ * for the next triangle_triangulate_cuts */
+KNIFE_STATUS triangle_reset_subtri( Triangle triangle )
+{
+  if ( NULL == triangle ) return KNIFE_NULL;
+
+  triangle_release_subtri( triangle );
+
+  return triangle_initialize_subtri( triangle );
+}
+
 int triangle_segment_index( Triangle triangle, Segment segment )
 {
   if ( NULL == triangle ) return EMPTY;
@@ -197,6 +241,18 @@ KNIFE_STATUS triangle_set_frame( int frame )
   return KNIFE_SUCCESS;
 }
 
+KNIFE_STATUS triangle_set_single_cut_check( KnifeBool check )
+{
+  triangle_single_cut_check = check;
+  return KNIFE_SUCCESS;
+}
+
+KNIFE_STATUS triangle_set_cdt_check( KnifeBool check )
+{
+  triangle_cdt_check = check;
+  return KNIFE_SUCCESS;
+}
+
 KNIFE_STATUS triangle_extent( Triangle triangle, 
 			      double *center, double *diameter )
 {
@@ -243,16 +299,252 @@ KNIFE_STATUS triangle_neighbor( Triangle triangle, Segment segment,
   return KNIFE_NOT_FOUND;
 }
 
+/* side of the initial subtri that triangle_insert would put uvw in */
+static int triangle_insert_side( double *uvw )
+{
+  int side;
+  side = EMPTY;
+  if (uvw[0] <= uvw[1] && uvw[0] <= uvw[2]) side = 0;
+  if (uvw[1] <= uvw[0] && uvw[1] <= uvw[2]) side = 1;
+  if (uvw[2] <= uvw[0] && uvw[2] <= uvw[1]) side = 2;
+  return side;
+}
+
+/* n0 is the first node of a subtri with positive uvw area */
+static KnifeBool triangle_orient_subnodes( Subnode *n0, Subnode *n1, 
+					   Subnode *n2 )
+{
+  Subnode swap;
+  if ( subnode_area( *n0, *n1, *n2 ) < 0.0 )
+    {
+      swap = *n1;
+      *n1 = *n2;
+      *n2 = swap;
+    }
+  return (KnifeBool)( 1.0e-20 <= subnode_area( *n0, *n1, *n2 ) );
+}
+
+/* lifted in circle volume of triangle_suspect_edge for the side n1-n2
+ * of the positive subtri n0,n1,n2 with o2 across it */
+static double triangle_in_circle( Subnode n0, Subnode n1, Subnode n2, 
+				  Subnode o2 )
+{
+  double xyz0[3], xyz1[3], xyz2[3], xyz3[3];
+
+  if ( subnode_area( n0, n1, n2 ) < 0.0 ) 
+    return triangle_in_circle( n0, n2, n1, o2 );
+
+  xyz0[0] = subnode_v(n0); xyz0[1] = subnode_w(n0);
+  xyz1[0] = subnode_v(n1); xyz1[1] = subnode_w(n1);
+  xyz2[0] = subnode_v(n2); xyz2[1] = subnode_w(n2);
+  xyz3[0] = subnode_v(o2); xyz3[1] = subnode_w(o2);
+
+  xyz0[2] = xyz0[0]*xyz0[0]+xyz0[1]*xyz0[1];
+  xyz1[2] = xyz1[0]*xyz1[0]+xyz1[1]*xyz1[1];
+  xyz2[2] = xyz2[0]*xyz2[0]+xyz2[1]*xyz2[1];
+  xyz3[2] = xyz3[0]*xyz3[0]+xyz3[1]*xyz3[1];
+
+  return intersection_volume6(xyz0,xyz1,xyz2,xyz3);
+}
+
+/* a lone cut that enters and leaves through two different sides splits
+ * the triangle into the corner subtri it cuts off and the Delaunay pair
+ * of the remaining quad, which is where the insert, recover and swap
+ * loop of triangle_generic_cuts ends up. KNIFE_NOT_IMPROVED (triangle
+ * untouched) when the cut is not that simple or is near degenerate. */
+static KNIFE_STATUS triangle_single_cut( Triangle triangle )
+{
+  Cut cut;
+  Intersection intersection0, intersection1;
+  double uvw0[3], uvw1[3];
+  int side0, side1, corner;
+  Subnode node[3], subnode0, subnode1;
+  Subnode c0, c1, c2, q0, q1, q2, r0, r1, r2;
+  double volume0, volume1;
+  Subtri subtri;
+
+  if ( 1 != triangle_ncut(triangle) ) return KNIFE_NOT_IMPROVED;
+  if ( 3 != triangle_nsubnode(triangle) || 
+       1 != triangle_nsubtri(triangle) ) return KNIFE_NOT_IMPROVED;
+
+  cut = triangle_cut(triangle,0);
+  NOT_NULL(cut,"triangle_single_cut: cut NULL");
+  intersection0 = cut_intersection0(cut);
+  intersection1 = cut_intersection1(cut);
+  NOT_NULL(intersection0,"triangle_single_cut: int0");
+  NOT_NULL(intersection1,"triangle_single_cut: int1");
+
+  if ( triangle == intersection_triangle( intersection0 ) ||
+       triangle == intersection_triangle( intersection1 ) )
+    return KNIFE_NOT_IMPROVED;
+  if ( intersection_t( intersection0 ) <= 0.0 ||
+       intersection_t( intersection0 ) >= 1.0 ||
+       intersection_t( intersection1 ) <= 0.0 ||
+       intersection_t( intersection1 ) >= 1.0 ) return KNIFE_NOT_IMPROVED;
+
+  TRY( intersection_uvw(intersection0,triangle,uvw0), "intersection uvw0" );
+  TRY( intersection_uvw(intersection1,triangle,uvw1), "intersection uvw1" );
+  side0 = triangle_insert_side( uvw0 );
+  side1 = triangle_insert_side( uvw1 );
+  if ( EMPTY == side0 || EMPTY == side1 || side0 == side1 ) 
+    return KNIFE_NOT_IMPROVED;
+  corner = 3 - side0 - side1;
+
+  node[0] = triangle_subnode(triangle,0);
+  node[1] = triangle_subnode(triangle,1);
+  node[2] = triangle_subnode(triangle,2);
+
+  subnode0 = subnode_create( uvw0[0], uvw0[1], uvw0[2], NULL, intersection0 );
+  NOT_NULL( subnode0, "new subnode0 NULL");
+  subnode1 = subnode_create( uvw1[0], uvw1[1], uvw1[2], NULL, intersection1 );
+  NOT_NULL( subnode1, "new subnode1 NULL");
+
+  /* subnode0 is between corner and node[side1], subnode1 is between
+   * corner and node[side0], the quad is subnode0 node[side1] node[side0]
+   * subnode1 with diagonal subnode0-node[side0] or subnode1-node[side1] */
+  c0 = node[corner]; c1 = subnode0; c2 = subnode1;
+  volume0 = triangle_in_circle( subnode1, subnode0, node[side0], 
+				node[side1] );
+  volume1 = triangle_in_circle( subnode0, subnode1, node[side1], 
+				node[side0] );
+  if ( volume0 > 0.0 && volume1 < 0.0 )
+    {
+      q0 = subnode0; q1 = node[side1]; q2 = node[side0];
+      r0 = subnode0; r1 = node[side0]; r2 = subnode1;
+    }
+  else if ( volume1 > 0.0 && volume0 < 0.0 )
+    {
+      q0 = subnode1; q1 = subnode0;    q2 = node[side1];
+      r0 = subnode1; r1 = node[side1]; r2 = node[side0];
+    }
+  else
+    { /* cocircular, the generic path result depends on insert order */
+      subnode_free( subnode0 );
+      subnode_free( subnode1 );
+      return KNIFE_NOT_IMPROVED;
+    }
+
+  if ( !triangle_orient_subnodes( &c0, &c1, &c2 ) ||
+       !triangle_orient_subnodes( &q0, &q1, &q2 ) ||
+       !triangle_orient_subnodes( &r0, &r1, &r2 ) )
+    {
+      subnode_free( subnode0 );
+      subnode_free( subnode1 );
+      return KNIFE_NOT_IMPROVED;
+    }
+
+  TRY( triangle_add_subnode( triangle, subnode0 ), "add subnode0" );
+  TRY( triangle_add_subnode( triangle, subnode1 ), "add subnode1" );
+
+  subtri = triangle_subtri(triangle,0);
+  subtri->n0 = c0;
+  subtri->n1 = c1;
+  subtri->n2 = c2;
+  POSITIVE_AREA( subtri );
+
+  subtri = subtri_create( q0, q1, q2 );
+  NOT_NULL( subtri, "new subtri q NULL");
+  TRY( triangle_add_subtri( triangle, subtri ), "add subtri q" );
+  POSITIVE_AREA( subtri );
+
+  subtri = subtri_create( r0, r1, r2 );
+  NOT_NULL( subtri, "new subtri r NULL");
+  TRY( triangle_add_subtri( triangle, subtri ), "add subtri r" );
+  POSITIVE_AREA( subtri );
+
+  return KNIFE_SUCCESS;
+}
+
+/* subtri of the fast path as sorted (node or intersection) triples */
+static void triangle_subtri_keys( Triangle triangle, void **key )
+{
+  int subtri_index, i, j;
+  Subnode subnode[3];
+  void *swap;
+
+  for ( subtri_index = 0;
+	subtri_index < triangle_nsubtri(triangle); 
+	subtri_index++)
+    {
+      subnode[0] = subtri_n0(triangle_subtri(triangle,subtri_index));
+      subnode[1] = subtri_n1(triangle_subtri(triangle,subtri_index));
+      subnode[2] = subtri_n2(triangle_subtri(triangle,subtri_index));
+      for ( i = 0 ; i < 3 ; i++ )
+	key[i+3*subtri_index] = 
+	  ( NULL != subnode_node(subnode[i]) ? 
+	    (void *)subnode_node(subnode[i]) : 
+	    (void *)subnode_intersection(subnode[i]) );
+      for ( i = 0 ; i < 2 ; i++ )
+	for ( j = i+1 ; j < 3 ; j++ )
+	  if ( key[j+3*subtri_index] < key[i+3*subtri_index] )
+	    {
+	      swap = key[i+3*subtri_index];
+	      key[i+3*subtri_index] = key[j+3*subtri_index];
+	      key[j+3*subtri_index] = swap;
+	    }
+    }
+}
+
+static KNIFE_STATUS triangle_split_cuts( Triangle triangle )
+{
+  KNIFE_STATUS status;
+  void *fast[9], *generic[9];
+  int i, j;
+  KnifeBool found;
+
+  if ( TRIANGLE_CDT_RECOVERY == triangle_recovery(triangle) ||
+       ( triangle_cdt_check && triangle_ncut(triangle) > 1 ) )
+    return triangle_constrained_delaunay( triangle );
+
+  status = triangle_single_cut( triangle );
+  if ( KNIFE_NOT_IMPROVED == status ) return triangle_generic_cuts( triangle );
+  TRY( status, "triangle_single_cut" );
+  if ( !triangle_single_cut_check ) return KNIFE_SUCCESS;
+
+  /* same subtri (up to order and rotation) from the generic path */
+  triangle_subtri_keys( triangle, fast );
+  TRY( triangle_reset_subtri( triangle ), "reset for check" );
+  TRY( triangle_generic_cuts( triangle ), "generic for check" );
+  if ( 3 != triangle_nsubtri(triangle) )
+    {
+      printf("%s: %d: single cut check %d generic subtri\n",
+	     __FILE__,__LINE__,triangle_nsubtri(triangle));
+      return KNIFE_INCONSISTENT;
+    }
+  triangle_subtri_keys( triangle, generic );
+  for ( i = 0 ; i < 3 ; i++ )
+    {
+      found = FALSE;
+      for ( j = 0 ; j < 3 ; j++ )
+	found = (KnifeBool)( found || ( fast[0+3*i] == generic[0+3*j] &&
+					fast[1+3*i] == generic[1+3*j] &&
+					fast[2+3*i] == generic[2+3*j] ) );
+      if ( !found )
+	{
+	  printf("%s: %d: single cut check subtri %d differs\n",
+		 __FILE__,__LINE__,i);
+	  triangle_tecplot(triangle);
+	  return KNIFE_INCONSISTENT;
+	}
+    }
+
+  return KNIFE_SUCCESS;
+}
+
 KNIFE_STATUS triangle_triangulate_cuts( Triangle triangle )
+{
+  TRYQ( triangle_split_cuts( triangle ), "triangle_split_cuts" );
+
+  profile_count( PROFILE_SUBNODE, triangle_nsubnode(triangle) );
+  profile_count( PROFILE_SUBTRI, triangle_nsubtri(triangle) );
+
+  return KNIFE_SUCCESS;
+}
+
+static KNIFE_STATUS triangle_insert_cut_subnodes( Triangle triangle )
 {
   int cut_index;
   Cut cut;
-  Subnode subnode0, subnode1;
-  Subtri subtri;
-  KNIFE_STATUS recover_status;
-  KnifeBool *cut_recovered;
-  KnifeBool improvement;
-  int subnode_index;
   double t_limit;
   double side_tolerence;
 
@@ -300,6 +592,22 @@ KNIFE_STATUS triangle_triangulate_cuts( Triangle triangle )
 	   "insert subnode1 in triangle_triangulate_cuts" );
   }
 
+  return KNIFE_SUCCESS;
+}
+
+static KNIFE_STATUS triangle_generic_cuts( Triangle triangle )
+{
+  int cut_index;
+  Cut cut;
+  Subnode subnode0, subnode1;
+  Subtri subtri;
+  KNIFE_STATUS recover_status;
+  KnifeBool *cut_recovered;
+  KnifeBool improvement;
+  int subnode_index;
+
+  TRY( triangle_insert_cut_subnodes( triangle ), "insert cut subnodes" );
+
   /* recover all cuts as subtriangle sides */
 
   cut_recovered = (KnifeBool *) malloc( triangle_ncut(triangle) * 
@@ -333,6 +641,7 @@ KNIFE_STATUS triangle_triangulate_cuts( Triangle triangle )
 
 	    if ( KNIFE_SUCCESS == recover_status )
 	      {
+		profile_count( PROFILE_RECOVERY, 1 );
 		cut_recovered[cut_index] = TRUE;
 		improvement = TRUE;
 		if (TRUE)
@@ -367,13 +676,15 @@ KNIFE_STATUS triangle_triangulate_cuts( Triangle triangle )
 						      cut_intersection0(cut));
 	subnode1 = triangle_subnode_with_intersection(triangle, 
 						      cut_intersection1(cut));
+	profile_count( PROFILE_PROVABLE, 1 );
 	recover_status = triangle_provable_recovery(triangle,subnode0,subnode1);
 	if ( KNIFE_SUCCESS != recover_status )
 	  {
 	    free(cut_recovered);
-	    printf("%s: %d: triangle_provable_recovery failed\n",
-		   __FILE__,__LINE__);
-	    return recover_status;
+	    printf("%s: %d: triangle_provable_recovery failed %d, cdt\n",
+		   __FILE__,__LINE__,recover_status);
+	    triangle_set_recovery( triangle, TRIANGLE_CDT_RECOVERY );
+	    return triangle_constrained_delaunay( triangle );
 	  }
 	/* enforce delaunay after recovery */
 	for ( subnode_index = 0;
@@ -406,30 +717,160 @@ KNIFE_STATUS triangle_triangulate_cuts( Triangle triangle )
   return triangle_verify_subtri_area( triangle );
 }
 
-KNIFE_STATUS triangle_shewchuk( Triangle triangle )
+/* proper crossing of side node0-node1 and the segment from end0 to end1.
+ * The areas of nearly collinear subnodes are round off, so segments
+ * whose vw boxes do not overlap never cross */
+static KnifeBool triangle_side_crosses( Subnode node0, Subnode node1,
+					Subnode end0, Subnode end1 )
 {
-  int status;
-  char command[1025];
+  int i;
 
-  int cut_index;
+  if ( node0 == end0 || node0 == end1 || 
+       node1 == end0 || node1 == end1 ) return FALSE;
+  for ( i = 1 ; i < 3 ; i++ )
+    if ( MAX( node0->uvw[i], node1->uvw[i] ) < 
+	 MIN( end0->uvw[i], end1->uvw[i] ) ||
+	 MAX( end0->uvw[i], end1->uvw[i] ) < 
+	 MIN( node0->uvw[i], node1->uvw[i] ) ) return FALSE;
+  return (KnifeBool)( subnode_area( end0, end1, node0 ) *
+		      subnode_area( end0, end1, node1 ) < 0.0 &&
+		      subnode_area( node0, node1, end0 ) *
+		      subnode_area( node0, node1, end1 ) < 0.0 );
+}
+
+/* flip the subtri sides crossing node0-node1 until it is a side. The
+ * crossing sides are kept in a queue, a side that is not the diagonal
+ * of a convex quad and a flipped side that still crosses go to the back
+ * so that a flip is never undone right away (Sloan, Adv. Eng. Software
+ * 1993) */
+static KNIFE_STATUS triangle_flip_recovery( Triangle triangle,
+					    Subnode node0, Subnode node1 )
+{
+  int subtri_index, side, i;
+  int nqueue, first, ncrossing, nvisit, max_visit;
+  Subnode *queue;
+  Subtri subtri;
+  Subnode n[3], n0, n1, n2, side0, side1, other0, other1;
+  Cut cut;
+  KnifeBool queued;
+
+  if ( NULL == node0 || NULL == node1 ) return KNIFE_NULL;
+
+  nqueue = 3*triangle_nsubtri(triangle);
+  queue = (Subnode *)malloc( 2*nqueue*sizeof(Subnode) );
+  NOT_NULL( queue, "triangle_flip_recovery queue" );
+
+  ncrossing = 0;
+  for ( subtri_index = 0;
+	subtri_index < triangle_nsubtri(triangle); 
+	subtri_index++)
+    {
+      subtri = triangle_subtri(triangle, subtri_index);
+      n[0] = subtri_n0(subtri);
+      n[1] = subtri_n1(subtri);
+      n[2] = subtri_n2(subtri);
+      for ( side = 0 ; side < 3 ; side++ )
+	{
+	  side0 = n[side];
+	  side1 = n[(side+1)%3];
+	  if ( !triangle_side_crosses( side0, side1, node0, node1 ) ) continue;
+	  if ( KNIFE_SUCCESS == triangle_cut_with_subnodes( triangle, 
+							    side0, side1,
+							    &cut ) )
+	    {
+	      free( queue );
+	      printf("%s: %d: cuts cross in triangle_flip_recovery\n",
+		     __FILE__,__LINE__);
+	      return KNIFE_INCONSISTENT;
+	    }
+	  queued = FALSE;
+	  for ( i = 0 ; i < ncrossing ; i++ )
+	    queued = (KnifeBool)( queued || ( queue[0+2*i] == side1 &&
+					      queue[1+2*i] == side0 ) );
+	  if ( queued ) continue;
+	  queue[0+2*ncrossing] = side0;
+	  queue[1+2*ncrossing] = side1;
+	  ncrossing++;
+	}
+    }
+
+  /* each visit flips a side or goes around the queue once more */
+  max_visit = 10 * nqueue * nqueue;
+  first = 0;
+  for ( nvisit = 0 ; ncrossing > 0 && nvisit < max_visit ; nvisit++ )
+    {
+      side0 = queue[0+2*first];
+      side1 = queue[1+2*first];
+      first = (first+1)%nqueue;
+      ncrossing--;
+      if ( triangle_swap_positive( triangle, side0, side1 ) )
+	{
+	  TRY( triangle_subtri_with_subnodes( triangle, side0, side1, 
+					      &subtri ), "s0" );
+	  TRY( subtri_orient( subtri, side0, &n0, &n1, &n2 ), "orient0");
+	  other0 = n2;
+	  TRY( triangle_subtri_with_subnodes( triangle, side1, side0, 
+					      &subtri ), "s1" );
+	  TRY( subtri_orient( subtri, side1, &n0, &n1, &n2 ), "orient1");
+	  other1 = n2;
+	  TRY( triangle_swap_side( triangle, side0, side1 ), "flip" );
+	  if ( !triangle_side_crosses( other0, other1, node0, node1 ) ) 
+	    continue;
+	  side0 = other0;
+	  side1 = other1;
+	}
+      queue[0+2*((first+ncrossing)%nqueue)] = side0;
+      queue[1+2*((first+ncrossing)%nqueue)] = side1;
+      ncrossing++;
+    }
+
+  free( queue );
+
+  if ( ncrossing > 0 ) 
+    {
+      printf("%s: %d: triangle_flip_recovery %d sides still cross\n",
+	     __FILE__,__LINE__,ncrossing);
+      return KNIFE_NOT_IMPROVED;
+    }
+
+  return triangle_subtri_with_subnodes( triangle, node0, node1, &subtri );
+}
+
+/* rebuilds the subtri from scratch without the loop recovery of
+ * triangle_provable_recovery: the Delaunay insert of the cut subnodes,
+ * each cut recovered by flipping the sides it crosses, then Delaunay
+ * swaps of every side that is not a cut */
+KNIFE_STATUS triangle_constrained_delaunay( Triangle triangle )
+{
+  int cut_index, subnode_index;
   Cut cut;
   Subnode subnode0, subnode1;
   Subtri subtri;
 
-  if ( 0 == triangle_ncut(triangle) ) return KNIFE_SUCCESS;
+  if ( NULL == triangle ) return KNIFE_NULL;
+
+  TRY( triangle_reset_subtri( triangle ), "reset" );
+  TRY( triangle_insert_cut_subnodes( triangle ), "insert cut subnodes" );
 
-  TRY( triangle_export( triangle ), "export" );
-  sprintf(command, "triangle -q -S -p triangle%08d > triangle%08d.out",
-	  triangle_export_frame, triangle_export_frame );
-  status = system( command );
-  if (0 != status) 
+  for ( cut_index = 0;
+	cut_index < triangle_ncut(triangle); 
+	cut_index++) 
     {
-      printf("%s: %d: triangle exit code %d\n",__FILE__,__LINE__,status);
-      return KNIFE_FAILURE;
+      cut = triangle_cut(triangle,cut_index);
+      subnode0 = triangle_subnode_with_intersection(triangle, 
+						    cut_intersection0(cut));
+      subnode1 = triangle_subnode_with_intersection(triangle, 
+						    cut_intersection1(cut));
+      TRY( triangle_flip_recovery( triangle, subnode0, subnode1 ),
+	   "flip recovery" );
     }
-  TRY( triangle_import( triangle, NULL ), "import" );
 
-  triangle_tecplot( triangle );
+  for ( subnode_index = 0;
+	subnode_index < triangle_nsubnode(triangle); 
+	subnode_index++)
+    TRY( triangle_delaunay( triangle, 
+			    triangle_subnode(triangle,subnode_index ) ),
+	 "re-d");
 
   /* verify that all cuts are now subtriangle sides (redundant) */
   for ( cut_index = 0;
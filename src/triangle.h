@@ -40,6 +40,10 @@ END_C_DECLORATION
 
 BEGIN_C_DECLORATION
 
+/* how triangle_triangulate_cuts recovers the cuts of a triangle */
+#define TRIANGLE_LOOP_RECOVERY (0)
+#define TRIANGLE_CDT_RECOVERY  (1)
+
 struct TriangleStruct {
   int boundary_face_index;
   Segment segment[3];
@@ -47,6 +51,7 @@ struct TriangleStruct {
   Array subnode;
   Array subtri;
   Array cut;
+  int recovery;
 };
 
 Triangle triangle_create(Segment segment0, Segment segment1, Segment segment2,
@@ -56,7 +61,9 @@ KNIFE_STATUS triangle_initialize(Triangle,
 				 Segment segment1, 
 				 Segment segment2,
 				 int boundary_face_index );
+void triangle_release( Triangle );
 void triangle_free( Triangle );
+KNIFE_STATUS triangle_reset_subtri( Triangle );
 
 #define triangle_segment(triangle,segment_index)	\
   ((triangle)->segment[segment_index])
@@ -78,6 +85,12 @@ int triangle_segment_index(Triangle, Segment);
 #define triangle_on_boundary(triangle) \
   (EMPTY != triangle_boundary_face_index(triangle))
 
+/* a triangle whose triangle_provable_recovery failed keeps
+ * TRIANGLE_CDT_RECOVERY for later re-cuts */
+#define triangle_recovery(triangle) ((triangle)->recovery)
+#define triangle_set_recovery(triangle,method) \
+  ((triangle)->recovery = (method))
+
 #define triangle_node0(triangle) ((triangle)->node0)
 #define triangle_node1(triangle) ((triangle)->node1)
 #define triangle_node2(triangle) ((triangle)->node2)
@@ -113,13 +126,22 @@ int triangle_node_index(Triangle, Node);
 
 
 KNIFE_STATUS triangle_set_frame( int frame );
+/* redo the single cut fast path of triangle_triangulate_cuts with the
+ * general insert and recover path and report when they differ */
+KNIFE_STATUS triangle_set_single_cut_check( KnifeBool check );
+/* recover the cuts of every triangle with more than one cut with
+ * triangle_constrained_delaunay */
+KNIFE_STATUS triangle_set_cdt_check( KnifeBool check );
 
 KNIFE_STATUS triangle_extent( Triangle, double *center, double *radius );
 
 KNIFE_STATUS triangle_neighbor( Triangle, Segment, Triangle *other );
 
 KNIFE_STATUS triangle_triangulate_cuts( Triangle );
-KNIFE_STATUS triangle_shewchuk( Triangle );
+/* triangulate_cuts without the loop based recovery of the cuts, used
+ * for a triangle with TRIANGLE_CDT_RECOVERY and as the fallback when
+ * triangle_provable_recovery fails */
+KNIFE_STATUS triangle_constrained_delaunay( Triangle );
 
 KNIFE_STATUS triangle_area_normal( Triangle, double *area, double *normal );
 